@@ -135,6 +135,16 @@ purc_document_delete(purc_document_t doc)
     return refc;
 }
 
+void
+purc_document_get_content_cache_stats(purc_document_t doc,
+        size_t *nr_hits, size_t *nr_misses)
+{
+    if (nr_hits)
+        *nr_hits = doc->nr_content_hits;
+    if (nr_misses)
+        *nr_misses = doc->nr_content_misses;
+}
+
 pcdoc_element_t
 purc_document_special_elem(purc_document_t doc, pcdoc_special_elem_k elem)
 {
@@ -195,6 +205,37 @@ pcdoc_element_new_content(purc_document_t doc,
     return doc->ops->new_content(doc, elem, op, content, len);
 }
 
+pcdoc_fragment_t
+pcdoc_fragment_new(purc_document_t doc, pcdoc_element_t elem,
+        const char **parts, const size_t *lens, size_t nr_slots)
+{
+    if (doc->ops->new_fragment == NULL) {
+        purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+        return NULL;
+    }
+
+    return doc->ops->new_fragment(doc, elem, parts, lens, nr_slots);
+}
+
+pcdoc_node
+pcdoc_element_new_content_from_fragment(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation_k op,
+        pcdoc_fragment_t frag, const char **vals, const size_t *lens)
+{
+    pcdoc_node node;
+
+    node = doc->ops->insert_fragment(doc, elem, op, frag, vals, lens);
+    if (node.type != PCDOC_NODE_VOID)
+        doc->age++;
+    return node;
+}
+
+void
+pcdoc_fragment_delete(purc_document_t doc, pcdoc_fragment_t frag)
+{
+    doc->ops->delete_fragment(doc, frag);
+}
+
 int
 pcdoc_element_get_tag_name(purc_document_t doc, pcdoc_element_t elem,
         const char **local_name, size_t *local_len,
@@ -24,6 +24,9 @@
 
 // #undef NDEBUG
 
+#define _GNU_SOURCE
+#include <string.h>
+
 #include "purc-document.h"
 #include "purc-errors.h"
 #include "purc-html.h"
@@ -34,6 +37,8 @@
 #include "private/map.h"
 #include "private/hash.h"
 #include "private/dom.h"
+#include "private/hashtable.h"
+#include "private/list.h"
 
 #include "ns_const.h"
 
@@ -78,8 +83,13 @@ static purc_document_t create(const char *content, size_t length)
     return doc;
 }
 
+static void content_cache_delete(struct pcdoc_content_cache *cache);
+
 static void destroy(purc_document_t doc)
 {
+    if (doc->content_cache)
+        content_cache_delete(doc->content_cache);
+
     assert(doc->impl);
     pchtml_html_document_destroy(doc->impl);
     free(doc);
@@ -372,6 +382,226 @@ static const dom_subtree_op dom_subtree_ops[] = {
     dom_displace_content_by_subtree,
 };
 
+/*
+ * The contents inserted recently are kept parsed in a LRU cache, so
+ * the same markup inserted into the same kind of element again is copied
+ * instead of parsed again. The parser only depends on the local name and
+ * the namespace of the context element, so they are parts of the key.
+ */
+#define CONTENT_CACHE_SIZE          64
+#define CONTENT_CACHE_MAX_LEN       4096
+
+struct content_key {
+    uintptr_t               ctxt_name;
+    uintptr_t               ctxt_ns;
+    const char             *markup;
+    size_t                  len;
+};
+
+struct content_entry {
+    struct content_key      key;
+    struct list_head        ln;
+
+    /* the parsed subtree; owned by the cache */
+    pcdom_node_t           *subtree;
+};
+
+struct pcdoc_content_cache {
+    struct pchash_table    *table;
+
+    /* the most recently used entry first */
+    struct list_head        lru;
+};
+
+static uint32_t
+content_key_hash(const void *k)
+{
+    const struct content_key *key = k;
+    const unsigned char *p = (const unsigned char *)key->markup;
+    uint32_t hval = 0x811c9dc5;
+
+    /* FNV-1a */
+    for (size_t i = 0; i < key->len; i++) {
+        hval ^= p[i];
+        hval *= 0x01000193;
+    }
+
+    hval ^= (uint32_t)key->ctxt_name;
+    hval *= 0x01000193;
+    hval ^= (uint32_t)key->ctxt_ns;
+    hval *= 0x01000193;
+    return hval;
+}
+
+static int
+content_key_cmp(const void *k1, const void *k2)
+{
+    const struct content_key *key1 = k1;
+    const struct content_key *key2 = k2;
+
+    if (key1->ctxt_name != key2->ctxt_name || key1->ctxt_ns != key2->ctxt_ns ||
+            key1->len != key2->len)
+        return 1;
+    return memcmp(key1->markup, key2->markup, key1->len);
+}
+
+static void
+content_entry_delete(struct content_entry *entry, bool destroy_subtree)
+{
+    if (destroy_subtree)
+        pcdom_node_destroy_deep(entry->subtree);
+    free((char *)entry->key.markup);
+    free(entry);
+}
+
+static void
+content_cache_delete(struct pcdoc_content_cache *cache)
+{
+    struct content_entry *entry, *tmp;
+
+    /* the subtrees go with the document */
+    list_for_each_entry_safe(entry, tmp, &cache->lru, ln) {
+        content_entry_delete(entry, false);
+    }
+
+    pchash_table_delete(cache->table);
+    free(cache);
+}
+
+static struct pcdoc_content_cache *
+content_cache_get(purc_document_t doc)
+{
+    if (doc->content_cache == NULL) {
+        struct pcdoc_content_cache *cache = calloc(1, sizeof(*cache));
+        if (cache == NULL)
+            return NULL;
+
+        cache->table = pchash_table_new(CONTENT_CACHE_SIZE,
+                NULL, NULL, NULL, NULL,
+                content_key_hash, content_key_cmp, false, false);
+        if (cache->table == NULL) {
+            free(cache);
+            return NULL;
+        }
+
+        INIT_LIST_HEAD(&cache->lru);
+        doc->content_cache = cache;
+    }
+
+    return doc->content_cache;
+}
+
+/* the content of a template element is not copied by pcdom_node_clone() */
+static bool
+is_subtree_clonable(pcdom_node_t *root)
+{
+    pcdom_node_t *node = root;
+
+    while (node) {
+        if (node->type != PCDOM_NODE_TYPE_ELEMENT &&
+                node->type != PCDOM_NODE_TYPE_TEXT &&
+                node->type != PCDOM_NODE_TYPE_COMMENT)
+            return false;
+
+        if (node->type == PCDOM_NODE_TYPE_ELEMENT &&
+                node->local_name == PCHTML_TAG_TEMPLATE &&
+                node->ns == PCHTML_NS_HTML)
+            return false;
+
+        if (node->first_child) {
+            node = node->first_child;
+            continue;
+        }
+
+        while (node != root && node->next == NULL)
+            node = node->parent;
+
+        if (node == root)
+            break;
+        node = node->next;
+    }
+
+    return true;
+}
+
+/* returns the subtree to insert, which is parsed or copied from the cache */
+static pcdom_node_t *
+parse_content(purc_document_t doc, pcdom_element_t *dom_elem,
+        const char *content, size_t length)
+{
+    pcdom_document_t *dom_doc = pcdom_interface_document(doc->impl);
+    struct content_key key = {
+        .ctxt_name = dom_elem->node.local_name,
+        .ctxt_ns = dom_elem->node.ns,
+        .markup = content,
+        .len = length,
+    };
+
+    struct pcdoc_content_cache *cache = NULL;
+    if (length <= CONTENT_CACHE_MAX_LEN)
+        cache = content_cache_get(doc);
+
+    if (cache) {
+        struct content_entry *entry;
+        if (pchash_table_lookup_ex(cache->table, &key, (void **)&entry)) {
+            pcdom_node_t *subtree = pcdom_node_clone(entry->subtree, true);
+            list_del(&entry->ln);
+            if (subtree) {
+                list_add(&entry->ln, &cache->lru);
+                doc->nr_content_hits++;
+                return subtree;
+            }
+
+            purc_clr_error();
+            pchash_table_erase(cache->table, &entry->key);
+            content_entry_delete(entry, true);
+        }
+    }
+
+    doc->nr_content_misses++;
+    pcdom_node_t *subtree = dom_parse_fragment(dom_doc, dom_elem,
+            content, length);
+    if (cache == NULL || subtree == NULL || !is_subtree_clonable(subtree))
+        return subtree;
+
+    /* keep the parsed one, and insert a copy of it, so the elements with
+       an identifier are registered by the inserted ones */
+    pcdom_node_t *copy = pcdom_node_clone(subtree, true);
+    if (copy == NULL) {
+        purc_clr_error();
+        return subtree;
+    }
+
+    struct content_entry *entry = calloc(1, sizeof(*entry));
+    char *markup = malloc(length);
+    if (entry == NULL || markup == NULL)
+        goto failed;
+
+    memcpy(markup, content, length);
+    entry->key = key;
+    entry->key.markup = markup;
+    entry->subtree = subtree;
+    if (pchash_table_insert_ex(cache->table, &entry->key, entry, NULL))
+        goto failed;
+    list_add(&entry->ln, &cache->lru);
+
+    if (pchash_table_length(cache->table) > CONTENT_CACHE_SIZE) {
+        struct content_entry *last;
+        last = list_last_entry(&cache->lru, struct content_entry, ln);
+        list_del(&last->ln);
+        pchash_table_erase(cache->table, &last->key);
+        content_entry_delete(last, true);
+    }
+
+    return copy;
+
+failed:
+    free(markup);
+    free(entry);
+    pcdom_node_destroy_deep(copy);
+    return subtree;
+}
+
 static pcdoc_node new_content(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_operation_k op,
             const char *content, size_t length)
@@ -385,9 +615,8 @@ static pcdoc_node new_content(purc_document_t doc,
         goto done;
     }
 
-    pcdom_document_t *dom_doc = pcdom_interface_document(doc->impl);
     pcdom_element_t *dom_elem = pcdom_interface_element(elem);
-    pcdom_node_t *subtree = dom_parse_fragment(dom_doc, dom_elem,
+    pcdom_node_t *subtree = parse_content(doc, dom_elem,
             content, length ? length : strlen(content));
 
     pcdom_node_t *dom_node = subtree->first_child->first_child;
@@ -406,6 +635,450 @@ done:
     return node;
 }
 
+/*
+ * A fragment is the markup with the slots parsed once, and kept aside.
+ * A slot is marked by a private use character (U+E000), the index of
+ * the slot in decimal, and another private use character (U+E001),
+ * so we can find out the text nodes and the attribute values containing
+ * slots (the sites) after parsing. To insert the fragment, we put
+ * the values in the sites and insert a deep copy of the parsed subtree.
+ */
+#define SLOT_OPEN           "\xEE\x80\x80"
+#define SLOT_CLOSE          "\xEE\x80\x81"
+#define SLOT_MARK_LEN       3
+
+struct fragment_piece {
+    /* the index of the slot, or -1 for a static piece */
+    ssize_t             slot;
+    const char         *str;
+    size_t              len;
+};
+
+struct fragment_site {
+    /* the text node or the attribute */
+    pcdom_node_t           *node;
+    bool                    is_attr;
+
+    /* the original text; the static pieces point to it */
+    char                   *orig;
+
+    size_t                  nr_pieces;
+    struct fragment_piece  *pieces;
+};
+
+struct pcdoc_fragment {
+    pcdom_node_t           *subtree;
+
+    /* the local name and the namespace of the context element */
+    uintptr_t               ctxt_name;
+    uintptr_t               ctxt_ns;
+
+    size_t                  nr_slots;
+    size_t                  nr_sites;
+    struct fragment_site   *sites;
+
+    /* the buffer to assemble the text of a site */
+    char                   *buf;
+    size_t                  sz_buf;
+};
+
+static void
+delete_fragment(purc_document_t doc, pcdoc_fragment_t frag)
+{
+    UNUSED_PARAM(doc);
+
+    for (size_t i = 0; i < frag->nr_sites; i++) {
+        free(frag->sites[i].orig);
+        free(frag->sites[i].pieces);
+    }
+    free(frag->sites);
+    free(frag->buf);
+
+    if (frag->subtree)
+        pcdom_node_destroy_deep(frag->subtree);
+    free(frag);
+}
+
+/* returns -1 if the text has malformed or duplicated slots */
+static int
+fragment_add_site(struct pcdoc_fragment *frag, size_t *slot_found,
+        pcdom_node_t *node, bool is_attr, const char *text, size_t len)
+{
+    if (memmem(text, len, SLOT_OPEN, SLOT_MARK_LEN) == NULL) {
+        if (memmem(text, len, SLOT_CLOSE, SLOT_MARK_LEN))
+            return -1;
+        return 0;
+    }
+
+    struct fragment_site *sites = realloc(frag->sites,
+            sizeof(*sites) * (frag->nr_sites + 1));
+    if (sites == NULL)
+        return -1;
+    frag->sites = sites;
+
+    struct fragment_site *site = sites + frag->nr_sites;
+    memset(site, 0, sizeof(*site));
+    frag->nr_sites++;
+
+    site->node = node;
+    site->is_attr = is_attr;
+    site->orig = strndup(text, len);
+    /* at most one static piece before and after every slot */
+    site->pieces = malloc(sizeof(*site->pieces) * (len / SLOT_MARK_LEN + 1));
+    if (site->orig == NULL || site->pieces == NULL)
+        return -1;
+
+    const char *p = site->orig;
+    const char *end = site->orig + len;
+    while (p < end) {
+        const char *open = memmem(p, end - p, SLOT_OPEN, SLOT_MARK_LEN);
+        const char *static_end = open ? open : end;
+
+        if (static_end > p) {
+            if (memmem(p, static_end - p, SLOT_CLOSE, SLOT_MARK_LEN))
+                return -1;
+
+            struct fragment_piece *piece = site->pieces + site->nr_pieces++;
+            piece->slot = -1;
+            piece->str = p;
+            piece->len = static_end - p;
+        }
+
+        if (open == NULL)
+            break;
+
+        p = open + SLOT_MARK_LEN;
+        size_t slot = 0;
+        const char *digits = p;
+        while (p < end && purc_isdigit(*p) && p - digits < 8) {
+            slot = slot * 10 + (*p - '0');
+            p++;
+        }
+
+        if (p == digits || slot >= frag->nr_slots || slot_found[slot] ||
+                end - p < SLOT_MARK_LEN ||
+                memcmp(p, SLOT_CLOSE, SLOT_MARK_LEN))
+            return -1;
+
+        slot_found[slot] = 1;
+        p += SLOT_MARK_LEN;
+
+        struct fragment_piece *piece = site->pieces + site->nr_pieces++;
+        piece->slot = slot;
+        piece->str = NULL;
+        piece->len = 0;
+    }
+
+    return 0;
+}
+
+static int
+fragment_find_sites(struct pcdoc_fragment *frag, pcdom_node_t *root)
+{
+    int ret = -1;
+    size_t *slot_found = calloc(frag->nr_slots + 1, sizeof(size_t));
+    if (slot_found == NULL)
+        return -1;
+
+    pcdom_node_t *node = root->first_child;
+    while (node) {
+        pcdom_character_data_t *ch_data;
+
+        switch (node->type) {
+        case PCDOM_NODE_TYPE_ELEMENT:
+        {
+            pcdom_element_t *elem = pcdom_interface_element(node);
+
+            /* the content of a template is not in the tree, and the
+               elements with an identifier are registered by the document */
+            if ((node->local_name == PCHTML_TAG_TEMPLATE &&
+                        node->ns == PCHTML_NS_HTML) || elem->attr_id)
+                goto done;
+
+            for (pcdom_attr_t *attr = elem->first_attr; attr;
+                    attr = attr->next) {
+                if (attr->value && attr->value->data &&
+                        fragment_add_site(frag, slot_found,
+                            pcdom_interface_node(attr), true,
+                            (const char *)attr->value->data,
+                            attr->value->length))
+                    goto done;
+            }
+            break;
+        }
+
+        case PCDOM_NODE_TYPE_TEXT:
+            ch_data = pcdom_interface_character_data(node);
+            if (fragment_add_site(frag, slot_found, node, false,
+                        (const char *)ch_data->data.data,
+                        ch_data->data.length))
+                goto done;
+            break;
+
+        case PCDOM_NODE_TYPE_COMMENT:
+            ch_data = pcdom_interface_character_data(node);
+            if (memmem(ch_data->data.data, ch_data->data.length,
+                        SLOT_OPEN, SLOT_MARK_LEN))
+                goto done;
+            break;
+
+        default:
+            goto done;
+        }
+
+        if (node->first_child) {
+            node = node->first_child;
+            continue;
+        }
+
+        while (node != root && node->next == NULL)
+            node = node->parent;
+
+        if (node == root)
+            break;
+        node = node->next;
+    }
+
+    for (size_t i = 0; i < frag->nr_slots; i++) {
+        if (!slot_found[i])
+            goto done;
+    }
+    ret = 0;
+
+done:
+    free(slot_found);
+    return ret;
+}
+
+/* checks whether the last `&` in the part is not followed by a `;` */
+static bool
+fragment_open_reference(const char *part, size_t len)
+{
+    while (len > 0) {
+        len--;
+        if (part[len] == ';')
+            return false;
+        if (part[len] == '&')
+            return true;
+    }
+    return false;
+}
+
+static pcdoc_fragment_t
+new_fragment(purc_document_t doc, pcdoc_element_t elem,
+        const char **parts, const size_t *lens, size_t nr_slots)
+{
+    struct pcdoc_fragment *frag = NULL;
+    purc_rwstream_t markup = NULL;
+
+    for (size_t i = 0; i <= nr_slots; i++) {
+        if (memmem(parts[i], lens[i], SLOT_OPEN, SLOT_MARK_LEN) ||
+                memmem(parts[i], lens[i], SLOT_CLOSE, SLOT_MARK_LEN))
+            goto not_supported;
+
+        /* a character reference not ended before a slot would take
+           the value of the slot in, e.g. `&` followed by `amp;` */
+        if (i < nr_slots && fragment_open_reference(parts[i], lens[i]))
+            goto not_supported;
+    }
+
+    markup = purc_rwstream_new_buffer(1024, 0);
+    if (markup == NULL)
+        goto failed;
+
+    for (size_t i = 0; i <= nr_slots; i++) {
+        char index[32];
+        purc_rwstream_write(markup, parts[i], lens[i]);
+        if (i < nr_slots) {
+            int n = snprintf(index, sizeof(index),
+                    SLOT_OPEN "%u" SLOT_CLOSE, (unsigned)i);
+            purc_rwstream_write(markup, index, n);
+        }
+    }
+
+    frag = calloc(1, sizeof(*frag));
+    if (frag == NULL)
+        goto failed;
+
+    pcdom_document_t *dom_doc = pcdom_interface_document(doc->impl);
+    pcdom_element_t *dom_elem = pcdom_interface_element(elem);
+    size_t sz_markup;
+    const char *content = purc_rwstream_get_mem_buffer(markup, &sz_markup);
+
+    frag->ctxt_name = dom_elem->node.local_name;
+    frag->ctxt_ns = dom_elem->node.ns;
+    frag->nr_slots = nr_slots;
+    frag->subtree = dom_parse_fragment(dom_doc, dom_elem,
+            content, sz_markup);
+    if (frag->subtree == NULL || frag->subtree->first_child == NULL)
+        goto not_supported;
+
+    if (fragment_find_sites(frag, frag->subtree->first_child))
+        goto not_supported;
+
+    purc_rwstream_destroy(markup);
+    return frag;
+
+not_supported:
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    goto cleanup;
+
+failed:
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+
+cleanup:
+    if (frag)
+        delete_fragment(doc, frag);
+    if (markup)
+        purc_rwstream_destroy(markup);
+    return NULL;
+}
+
+/* checks whether the parser would take the value as it is */
+static bool
+fragment_value_fits(const char *val, size_t len, bool is_attr,
+        bool at_start)
+{
+    if (is_attr) {
+        for (size_t i = 0; i < len; i++) {
+            if (strchr("&\"'<>=`", val[i]) || purc_isspace(val[i]) ||
+                    val[i] == '\0')
+                return false;
+        }
+        return true;
+    }
+
+    /* the parser drops the leading newline in pre, listing, and textarea */
+    if (at_start && len > 0 && val[0] == '\n')
+        return false;
+
+    for (size_t i = 0; i < len; i++) {
+        if (val[i] == '<' || val[i] == '&' || val[i] == '\r' ||
+                val[i] == '\0')
+            return false;
+    }
+    return true;
+}
+
+static bool
+is_all_spaces(const char *str, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (!purc_isspace(str[i]))
+            return false;
+    }
+    return true;
+}
+
+static pcdoc_node
+insert_fragment(purc_document_t doc, pcdoc_element_t elem,
+        pcdoc_operation_k op, pcdoc_fragment_t frag,
+        const char **vals, const size_t *lens)
+{
+    UNUSED_PARAM(doc);
+
+    pcdoc_node node = { PCDOC_NODE_VOID, { NULL } };
+
+    if (UNLIKELY(op >= PCA_TABLESIZE(dom_subtree_ops))) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto done;
+    }
+
+    pcdom_element_t *dom_elem = pcdom_interface_element(elem);
+    if (dom_elem->node.local_name != frag->ctxt_name ||
+            dom_elem->node.ns != frag->ctxt_ns)
+        goto done;
+
+    /* check all the values before changing anything */
+    for (size_t i = 0; i < frag->nr_sites; i++) {
+        struct fragment_site *site = frag->sites + i;
+        bool spaces_only = true;
+
+        for (size_t j = 0; j < site->nr_pieces; j++) {
+            struct fragment_piece *piece = site->pieces + j;
+            const char *str = piece->str;
+            size_t len = piece->len;
+
+            if (piece->slot >= 0) {
+                str = vals[piece->slot];
+                len = lens[piece->slot];
+                if (!fragment_value_fits(str, len, site->is_attr, j == 0))
+                    goto done;
+            }
+
+            if (spaces_only)
+                spaces_only = is_all_spaces(str, len);
+        }
+
+        /* the parser would not make a text node for nothing,
+           and treats the spaces differently in some contexts */
+        if (!site->is_attr && spaces_only)
+            goto done;
+    }
+
+    for (size_t i = 0; i < frag->nr_sites; i++) {
+        struct fragment_site *site = frag->sites + i;
+        size_t total = 0;
+
+        for (size_t j = 0; j < site->nr_pieces; j++) {
+            struct fragment_piece *piece = site->pieces + j;
+            total += (piece->slot >= 0) ? lens[piece->slot] : piece->len;
+        }
+
+        if (total > frag->sz_buf) {
+            char *buf = realloc(frag->buf, total);
+            if (buf == NULL) {
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                goto done;
+            }
+            frag->buf = buf;
+            frag->sz_buf = total;
+        }
+
+        char *p = frag->buf;
+        for (size_t j = 0; j < site->nr_pieces; j++) {
+            struct fragment_piece *piece = site->pieces + j;
+            if (piece->slot >= 0) {
+                memcpy(p, vals[piece->slot], lens[piece->slot]);
+                p += lens[piece->slot];
+            }
+            else {
+                memcpy(p, piece->str, piece->len);
+                p += piece->len;
+            }
+        }
+
+        unsigned int status;
+        if (site->is_attr) {
+            status = pcdom_attr_set_value(pcdom_interface_attr(site->node),
+                    (const unsigned char *)frag->buf, total);
+        }
+        else {
+            status = pcdom_character_data_replace(
+                    pcdom_interface_character_data(site->node),
+                    (const unsigned char *)frag->buf, total, 0, 0);
+        }
+
+        if (status) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto done;
+        }
+    }
+
+    pcdom_node_t *subtree = pcdom_node_clone(frag->subtree, true);
+    if (subtree == NULL)
+        goto done;
+
+    pcdom_node_t *dom_node = subtree->first_child->first_child;
+    dom_subtree_ops[op](dom_elem, subtree);
+
+    node.type = PCDOC_NODE_ELEMENT;
+    node.elem = (pcdoc_element_t)dom_node;
+
+done:
+    return node;
+}
+
 static inline int
 dom_set_element_attribute(pcdom_element_t *element,
         const char* name, const char* value, size_t length)
@@ -999,6 +1672,9 @@ struct purc_document_ops _pcdoc_html_ops = {
     .new_text_content = new_text_content,
     .new_data_content = NULL,
     .new_content = new_content,
+    .new_fragment = new_fragment,
+    .insert_fragment = insert_fragment,
+    .delete_fragment = delete_fragment,
     .set_attribute = set_attribute,
     .special_elem = special_elem,
     .get_tag_name = get_tag_name,
@@ -110,6 +110,131 @@ pcdom_node_destroy_deep(pcdom_node_t *root)
     return NULL;
 }
 
+static pcdom_node_t *
+node_clone_element(pcdom_document_t *doc, pcdom_element_t *from)
+{
+    pcdom_element_t *to;
+
+    to = pcdom_document_create_interface(doc, from->node.local_name,
+            from->node.ns);
+    if (to == NULL) {
+        return NULL;
+    }
+
+    to->node.prefix = from->node.prefix;
+    to->upper_name = from->upper_name;
+    to->qualified_name = from->qualified_name;
+    to->custom_state = from->custom_state;
+    to->self_close = from->self_close;
+
+    if (from->is_value != NULL && from->is_value->data != NULL) {
+        if (pcdom_element_is_set(to, from->is_value->data,
+                    from->is_value->length) != PURC_ERROR_OK)
+            goto failed;
+    }
+
+    for (pcdom_attr_t *attr = from->first_attr; attr; attr = attr->next) {
+        pcdom_attr_t *new_attr = pcdom_attr_interface_create(doc);
+        if (new_attr == NULL) {
+            goto failed;
+        }
+
+        pcdom_attr_clone_name_value(attr, new_attr);
+        new_attr->upper_name = attr->upper_name;
+        new_attr->node.ns = attr->node.ns;
+        new_attr->node.prefix = attr->node.prefix;
+
+        /* the id attribute is registered by its value */
+        bool has_value = attr->value && attr->value->data;
+        const unsigned char *value = has_value ?
+            attr->value->data : (const unsigned char *)"";
+        size_t value_len = has_value ? attr->value->length : 0;
+
+        if ((has_value || attr->node.local_name == PCDOM_ATTR_ID) &&
+                pcdom_attr_set_value(new_attr, value,
+                    value_len) != PCHTML_STATUS_OK) {
+            pcdom_attr_interface_destroy(new_attr);
+            goto failed;
+        }
+
+        pcdom_element_attr_append(to, new_attr);
+    }
+
+    return pcdom_interface_node(to);
+
+failed:
+    pcdom_node_destroy(pcdom_interface_node(to));
+    return NULL;
+}
+
+static pcdom_node_t *
+node_clone_one(pcdom_document_t *doc, pcdom_node_t *node)
+{
+    pcdom_character_data_t *ch_data;
+
+    switch (node->type) {
+        case PCDOM_NODE_TYPE_ELEMENT:
+            return node_clone_element(doc, pcdom_interface_element(node));
+
+        case PCDOM_NODE_TYPE_TEXT:
+            ch_data = pcdom_interface_character_data(node);
+            return pcdom_interface_node(pcdom_document_create_text_node(doc,
+                        ch_data->data.data, ch_data->data.length));
+
+        case PCDOM_NODE_TYPE_COMMENT:
+            ch_data = pcdom_interface_character_data(node);
+            return pcdom_interface_node(pcdom_document_create_comment(doc,
+                        ch_data->data.data, ch_data->data.length));
+
+        default:
+            break;
+    }
+
+    pcinst_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return NULL;
+}
+
+pcdom_node_t *
+pcdom_node_clone(pcdom_node_t *root, bool deep)
+{
+    pcdom_document_t *doc = root->owner_document;
+    pcdom_node_t *clone = node_clone_one(doc, root);
+    if (clone == NULL || !deep) {
+        return clone;
+    }
+
+    /* `parent` is always the clone of the parent of `node` */
+    pcdom_node_t *node = root->first_child;
+    pcdom_node_t *parent = clone;
+    while (node != NULL) {
+        pcdom_node_t *copy = node_clone_one(doc, node);
+        if (copy == NULL) {
+            pcdom_node_destroy_deep(clone);
+            return NULL;
+        }
+        pcdom_node_append_child(parent, copy);
+
+        if (node->first_child != NULL) {
+            node = node->first_child;
+            parent = copy;
+            continue;
+        }
+
+        while (node != root && node->next == NULL) {
+            node = node->parent;
+            parent = parent->parent;
+        }
+
+        if (node == root) {
+            break;
+        }
+
+        node = node->next;
+    }
+
+    return clone;
+}
+
 const unsigned char *
 pcdom_node_name(pcdom_node_t *node, size_t *len)
 {
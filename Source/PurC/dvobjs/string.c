@@ -28,32 +28,90 @@
 #include "private/dvobjs.h"
 #include "private/utils.h"
 #include "private/variant.h"
+#include "private/str-matcher.h"
+#include "private/hashtable.h"
+#include "private/instance.h"
 #include "purc-variant.h"
 #include "helper.h"
 
-static const char * get_next_segment (const char *data,
-        const char *delim, size_t *length)
+/* The search strings or replacements given by a string or
+   a linear container of strings. */
+struct string_list {
+    size_t          nr;
+    const char    **strs;
+    size_t         *lens;
+
+    /* whether the strings are given by a linear container */
+    bool            is_container;
+
+    /* the storage for a single string */
+    const char     *str_one;
+    size_t          len_one;
+};
+
+static bool
+string_list_init(struct string_list *list, purc_variant_t arg)
 {
-    const char *head = NULL;
-    char *temp = NULL;
+    memset(list, 0, sizeof(*list));
 
-    *length = 0;
+    if (arg == PURC_VARIANT_INVALID) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return false;
+    }
 
-    if ((*data == 0x00) || (*delim == 0x00))
-        return NULL;
+    list->str_one = purc_variant_get_string_const_ex(arg, &list->len_one);
+    if (list->str_one) {
+        list->nr = 1;
+        list->strs = &list->str_one;
+        list->lens = &list->len_one;
+        return true;
+    }
 
-    head = data;
+    size_t sz;
+    if (!purc_variant_linear_container_size(arg, &sz)) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return false;
+    }
 
-    temp = strstr (head, delim);
+    list->is_container = true;
+    if (sz == 0)
+        return true;
 
-    if (temp) {
-        *length =  temp - head;
+    list->strs = malloc(sizeof(const char *) * sz);
+    list->lens = malloc(sizeof(size_t) * sz);
+    if (list->strs == NULL || list->lens == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
     }
-    else {
-        *length = strlen (head);
+
+    for (size_t i = 0; i < sz; i++) {
+        purc_variant_t item = purc_variant_linear_container_get(arg, i);
+        list->strs[i] = purc_variant_get_string_const_ex(item,
+                list->lens + i);
+        if (list->strs[i] == NULL) {
+            purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+            goto failed;
+        }
     }
 
-    return head;
+    list->nr = sz;
+    return true;
+
+failed:
+    free(list->strs);
+    free(list->lens);
+    list->strs = NULL;
+    list->lens = NULL;
+    return false;
+}
+
+static void
+string_list_release(struct string_list *list)
+{
+    if (list->is_container) {
+        free(list->strs);
+        free(list->lens);
+    }
 }
 
 static purc_variant_t
@@ -624,8 +682,10 @@ explode_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     UNUSED_PARAM(call_flags);
 
     purc_variant_t ret_var = PURC_VARIANT_INVALID;
-    purc_variant_t val = PURC_VARIANT_INVALID;
-    char *buf = NULL;
+    purc_variant_t owner = PURC_VARIANT_INVALID;
+    struct pcutils_str_matcher *matcher = NULL;
+    struct string_list delims;
+    char *copy = NULL;
 
     if ((argv == NULL) || (nr_args < 2)) {
         purc_set_error (PURC_ERROR_ARGUMENT_MISSED);
@@ -637,44 +697,90 @@ explode_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         return PURC_VARIANT_INVALID;
     }
 
-    if ((argv[1] == PURC_VARIANT_INVALID) ||
-            (!purc_variant_is_string (argv[1]))) {
-        purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+    // the delimiter can be a string or an array of strings
+    if (!string_list_init(&delims, argv[1]))
         return PURC_VARIANT_INVALID;
-    }
 
-    const char *source = purc_variant_get_string_const (argv[0]);
-    const char *delim = purc_variant_get_string_const (argv[1]);
-    size_t len_delim = purc_variant_string_size (argv[1]) - 1;
-    size_t length = 0;
-    const char *head = get_next_segment (source, delim, &length);
+    size_t len_source;
+    const char *source = purc_variant_get_string_const_ex (argv[0],
+            &len_source);
 
     ret_var = purc_variant_make_array (0, PURC_VARIANT_INVALID);
+    if (ret_var == PURC_VARIANT_INVALID)
+        goto failed;
 
-    while (head) {
-        buf = malloc (length + 1);
-        if (buf == NULL) {
-            purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
-            purc_variant_unref (ret_var);
-            return PURC_VARIANT_INVALID;
+    // an empty source or an empty single delimiter gives an empty array
+    if (len_source == 0 || (!delims.is_container && delims.len_one == 0))
+        goto done;
+
+    matcher = pcutils_str_matcher_new(delims.strs, delims.lens, delims.nr);
+    if (matcher == NULL)
+        goto failed;
+
+    /* The long pieces share one copy of the source, in which the delimiters
+       are overwritten by null bytes, instead of having a copy for each. */
+    const char *head = source;
+    const char *end = source + len_source;
+    while (head < end) {
+        size_t len_delim = 0;
+        const char *found = pcutils_str_matcher_find(matcher,
+                head, end - head, NULL, &len_delim);
+        size_t length = found ? (size_t)(found - head) : (size_t)(end - head);
+
+        if (owner == PURC_VARIANT_INVALID && length >= PCVRNT_SZ_BYTES) {
+            copy = malloc (len_source + 1);
+            if (copy == NULL) {
+                purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
+                goto failed;
+            }
+
+            memcpy (copy, source, len_source + 1);
+            owner = purc_variant_make_byte_sequence_reuse_buff (copy,
+                    len_source + 1, len_source + 1);
+            if (owner == PURC_VARIANT_INVALID) {
+                free (copy);
+                goto failed;
+            }
         }
 
-        strncpy (buf, head, length + 1);
-        *(buf + length)= 0x00;
-        val = purc_variant_make_string_reuse_buff (buf, length, true);
-        purc_variant_array_append (ret_var, val);
+        purc_variant_t val;
+        if (owner) {
+            char *piece = copy + (head - source);
+            piece[length] = 0x00;
+            val = pcvariant_make_string_shared (owner, piece, length);
+        }
+        else {
+            val = purc_variant_make_string_ex (head, length, false);
+        }
+        if (val == PURC_VARIANT_INVALID)
+            goto failed;
+
+        bool ok = purc_variant_array_append (ret_var, val);
         purc_variant_unref (val);
+        if (!ok)
+            goto failed;
 
-        if (*(head + length) != 0x00)
-            head = get_next_segment (head + length + len_delim,
-                    delim, &length);
-        else
+        if (found == NULL)
             break;
+        head = found + len_delim;
     }
 
+done:
+    if (owner)
+        purc_variant_unref (owner);
+    pcutils_str_matcher_delete(matcher);
+    string_list_release(&delims);
     return ret_var;
-}
 
+failed:
+    if (owner)
+        purc_variant_unref (owner);
+    pcutils_str_matcher_delete(matcher);
+    string_list_release(&delims);
+    if (ret_var)
+        purc_variant_unref (ret_var);
+    return PURC_VARIANT_INVALID;
+}
 
 static purc_variant_t
 implode_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
@@ -764,6 +870,36 @@ implode_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     return ret_var;
 }
 
+static inline bool
+ensure_buffer_space(char **buf, size_t *sz_buf, size_t len, size_t extra)
+{
+    if (len + extra + 1 > *sz_buf) {
+        size_t sz_new = *sz_buf * 2;
+        if (sz_new < len + extra + 1)
+            sz_new = len + extra + 1;
+
+        char *new_buf = realloc(*buf, sz_new);
+        if (new_buf == NULL) {
+            purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
+            return false;
+        }
+
+        *buf = new_buf;
+        *sz_buf = sz_new;
+    }
+
+    return true;
+}
+
+/*
+ * $STR.replace(<string $subject>, <string | array $search>,
+ *      <string | array $replace>)
+ *
+ * When $search is an array, all the search strings are matched in one pass
+ * over the subject. At a position, the longest search string matched wins.
+ * When $replace is an array too, the i-th search string is replaced by
+ * the i-th replacement, or by an empty string if there is no such one.
+ */
 static purc_variant_t
 replace_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         unsigned call_flags)
@@ -771,7 +907,9 @@ replace_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     UNUSED_PARAM(root);
     UNUSED_PARAM(call_flags);
 
-    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    struct pcutils_str_matcher *matcher = NULL;
+    struct string_list searches = { 0 }, replaces = { 0 };
+    char *buf = NULL;
 
     if ((argv == NULL) || (nr_args < 3)) {
         purc_set_error (PURC_ERROR_ARGUMENT_MISSED);
@@ -783,369 +921,690 @@ replace_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         return PURC_VARIANT_INVALID;
     }
 
-    if ((argv[1] == PURC_VARIANT_INVALID) ||
-            (!purc_variant_is_string (argv[1]))) {
+    size_t len_subject;
+    const char *subject = purc_variant_get_string_const_ex (argv[0],
+            &len_subject);
+    if (len_subject == 0) {
         purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
         return PURC_VARIANT_INVALID;
     }
 
-    if ((argv[2] == PURC_VARIANT_INVALID) ||
-            (!purc_variant_is_string (argv[2]))) {
+    if (!string_list_init(&searches, argv[1]) ||
+            !string_list_init(&replaces, argv[2]))
+        goto failed;
+
+    if (!searches.is_container && replaces.is_container) {
         purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
-        return PURC_VARIANT_INVALID;
+        goto failed;
     }
 
-    size_t len_delim = purc_variant_string_size (argv[0]) - 1;
-    if (len_delim == 0) {
-        purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
-        return PURC_VARIANT_INVALID;
+    matcher = pcutils_str_matcher_new(searches.strs, searches.lens,
+            searches.nr);
+    if (matcher == NULL)
+        goto failed;
+
+    /* If no replacement is longer than its search string, the result can
+       not be longer than the subject, and the buffer never grows. */
+    size_t sz_buf = len_subject + 1;
+    for (size_t i = 0; i < searches.nr; i++) {
+        size_t len_rep = 0;
+        if (!replaces.is_container)
+            len_rep = replaces.len_one;
+        else if (i < replaces.nr)
+            len_rep = replaces.lens[i];
+
+        if (len_rep > searches.lens[i]) {
+            sz_buf += len_subject / 2;
+            break;
+        }
     }
-    len_delim = purc_variant_string_size (argv[1]) - 1;
-    if (len_delim == 0) {
-        purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
-        return PURC_VARIANT_INVALID;
+
+    const char *head = subject;
+    const char *end = subject + len_subject;
+    size_t len = 0;
+    while (head < end) {
+        size_t idx, len_matched;
+        const char *found = pcutils_str_matcher_find(matcher,
+                head, end - head, &idx, &len_matched);
+        if (found == NULL)
+            break;
+
+        if (buf == NULL) {
+            buf = malloc (sz_buf);
+            if (buf == NULL) {
+                purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
+                goto failed;
+            }
+        }
+
+        const char *rep = "";
+        size_t len_rep = 0;
+        if (!replaces.is_container) {
+            rep = replaces.str_one;
+            len_rep = replaces.len_one;
+        }
+        else if (idx < replaces.nr) {
+            rep = replaces.strs[idx];
+            len_rep = replaces.lens[idx];
+        }
+
+        size_t len_seg = found - head;
+        if (!ensure_buffer_space(&buf, &sz_buf, len, len_seg + len_rep))
+            goto failed;
+
+        memcpy (buf + len, head, len_seg);
+        len += len_seg;
+        memcpy (buf + len, rep, len_rep);
+        len += len_rep;
+        head = found + len_matched;
     }
 
-    const char *source = purc_variant_get_string_const (argv[0]);
-    const char *delim = purc_variant_get_string_const (argv[1]);
-    const char *replace = purc_variant_get_string_const (argv[2]);
-    purc_rwstream_t rwstream = purc_rwstream_new_buffer (32, STREAM_SIZE);
+    pcutils_str_matcher_delete(matcher);
+    matcher = NULL;
+
+    // nothing replaced
+    if (buf == NULL) {
+        string_list_release(&searches);
+        string_list_release(&replaces);
+        return purc_variant_ref (argv[0]);
+    }
+
+    if (!ensure_buffer_space(&buf, &sz_buf, len, end - head))
+        goto failed;
+    memcpy (buf + len, head, end - head);
+    len += end - head;
+    buf[len] = 0x00;
+
+    string_list_release(&searches);
+    string_list_release(&replaces);
+    return purc_variant_make_string_reuse_buff (buf, sz_buf, false);
+
+failed:
+    if (buf)
+        free (buf);
+    pcutils_str_matcher_delete(matcher);
+    string_list_release(&searches);
+    string_list_release(&replaces);
+    return PURC_VARIANT_INVALID;
+}
+
+/*
+ * The format templates of format_c and format_p are compiled to a list of
+ * segments (literal runs and typed placeholders) once, and cached by
+ * the template text in the local data of the current instance.
+ */
+#define LDNAME_FORMAT_TEMPLATES     "dvobj-string-format-templates"
+#define NR_CACHED_TEMPLATES         16
+
+enum fmt_seg_type {
+    FMT_SEG_LITERAL = 0,
+    FMT_SEG_LONGINT,        // %d
+    FMT_SEG_OCTAL,          // %o
+    FMT_SEG_ULONGINT,       // %u
+    FMT_SEG_HEX,            // %x
+    FMT_SEG_NUMBER,         // %f
+    FMT_SEG_STRING,         // %s
+    FMT_SEG_MEMBER,         // {index} or {key}
+};
+
+struct fmt_segment {
+    enum fmt_seg_type   type;
+
+    /* the literal text in the template */
+    const char         *literal;
+    size_t              len;
+
+    /* the key and the index for FMT_SEG_MEMBER */
+    char               *key;
+    int                 index;
+};
+
+struct fmt_template {
+    /* whether the template is for format_p */
+    bool                is_p;
+    uint32_t            hash;
+
+    char               *text;
+    size_t              len_text;
+
+    /* the total length of the literal runs */
+    size_t              len_literals;
+    /* the number of placeholders */
+    size_t              nr_holders;
+
+    size_t              nr_segs;
+    struct fmt_segment *segs;
+};
+
+struct fmt_cache {
+    struct fmt_template *tmpls[NR_CACHED_TEMPLATES];
+};
+
+static void fmt_template_delete(struct fmt_template *tmpl)
+{
+    if (tmpl) {
+        for (size_t i = 0; i < tmpl->nr_segs; i++)
+            free(tmpl->segs[i].key);
+        free(tmpl->segs);
+        free(tmpl->text);
+        free(tmpl);
+    }
+}
+
+static void cb_free_fmt_cache(void *key, void *local_data)
+{
+    UNUSED_PARAM(key);
 
-    size_t len_replace = purc_variant_string_size (argv[2]) - 1;
-    size_t length = 0;
-    const char *head = get_next_segment (source, delim, &length);
+    struct fmt_cache *cache = local_data;
+    for (size_t i = 0; i < NR_CACHED_TEMPLATES; i++)
+        fmt_template_delete(cache->tmpls[i]);
+    free(cache);
+}
+
+static struct fmt_segment *
+fmt_template_add(struct fmt_template *tmpl, enum fmt_seg_type type,
+        const char *literal, size_t len)
+{
+    if (type == FMT_SEG_LITERAL && len == 0)
+        return tmpl->segs;  // nothing to add, but not an error
+
+    /* the number of segments never exceeds len_text + 1 */
+    struct fmt_segment *seg = tmpl->segs + tmpl->nr_segs++;
+    seg->type = type;
+    seg->literal = literal;
+    seg->len = len;
+    seg->key = NULL;
+    seg->index = 0;
+
+    if (type == FMT_SEG_LITERAL)
+        tmpl->len_literals += len;
+    else
+        tmpl->nr_holders++;
+    return seg;
+}
 
-    while (head) {
-        purc_rwstream_write (rwstream, head, length);
+static bool
+fmt_template_compile_c(struct fmt_template *tmpl)
+{
+    const char *text = tmpl->text;
+    size_t start = 0, i = 0;
 
-        if (*(head + length) != 0x00) {
-            purc_rwstream_write (rwstream, replace, len_replace);
-            head = get_next_segment (head + length + len_delim,
-                    delim, &length);
-        } else
+    while (i < tmpl->len_text) {
+        if (text[i] != '%' || i + 1 == tmpl->len_text) {
+            i++;
+            continue;
+        }
+
+        enum fmt_seg_type type;
+        switch (text[i + 1]) {
+        case '%':
+            // keep the first '%' in the literal run
+            fmt_template_add(tmpl, FMT_SEG_LITERAL, text + start,
+                    i + 1 - start);
+            i += 2;
+            start = i;
+            continue;
+        case 'd':
+            type = FMT_SEG_LONGINT;
             break;
+        case 'o':
+            type = FMT_SEG_OCTAL;
+            break;
+        case 'u':
+            type = FMT_SEG_ULONGINT;
+            break;
+        case 'x':
+            type = FMT_SEG_HEX;
+            break;
+        case 'f':
+            type = FMT_SEG_NUMBER;
+            break;
+        case 's':
+            type = FMT_SEG_STRING;
+            break;
+        default:
+            // not a conversion, keep it as is
+            i++;
+            continue;
+        }
+
+        fmt_template_add(tmpl, FMT_SEG_LITERAL, text + start, i - start);
+        fmt_template_add(tmpl, type, NULL, 0);
+        i += 2;
+        start = i;
     }
 
-    size_t rw_size = 0;
-    const char *rw_string = purc_rwstream_get_mem_buffer (rwstream, &rw_size);
+    fmt_template_add(tmpl, FMT_SEG_LITERAL, text + start,
+            tmpl->len_text - start);
+    return true;
+}
 
-    if ((rw_size == 0) || (rw_string == NULL))
-        ret_var = PURC_VARIANT_INVALID;
+static bool
+fmt_template_compile_p(struct fmt_template *tmpl)
+{
+    const char *text = tmpl->text;
+    size_t start = 0, i = 0;
+
+    while (i < tmpl->len_text) {
+        if (text[i] != '{') {
+            i++;
+            continue;
+        }
+
+        const char *close = memchr(text + i + 1, '}', tmpl->len_text - i - 1);
+        if (close == NULL)
+            break;
+
+        fmt_template_add(tmpl, FMT_SEG_LITERAL, text + start, i - start);
+        struct fmt_segment *seg = fmt_template_add(tmpl, FMT_SEG_MEMBER,
+                NULL, 0);
+        seg->key = strndup(text + i + 1, close - text - i - 1);
+        if (seg->key == NULL) {
+            purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
+            return false;
+        }
+        pcdvobjs_remove_space (seg->key);
+        seg->index = atoi (seg->key);
+
+        i = close - text + 1;
+        start = i;
+    }
+
+    fmt_template_add(tmpl, FMT_SEG_LITERAL, text + start,
+            tmpl->len_text - start);
+    return true;
+}
+
+static struct fmt_template *
+fmt_template_get(purc_variant_t format, bool is_p)
+{
+    struct fmt_cache *cache = NULL;
+    const char *text;
+    size_t len_text;
+
+    text = purc_variant_get_string_const_ex(format, &len_text);
+    uint32_t hash = pchash_fnv1a_str_hash(text);
+    size_t slot = (hash ^ (uint32_t)is_p) % NR_CACHED_TEMPLATES;
+
+    purc_get_local_data(LDNAME_FORMAT_TEMPLATES, (uintptr_t *)&cache, NULL);
+    if (cache) {
+        struct fmt_template *tmpl = cache->tmpls[slot];
+        if (tmpl && tmpl->is_p == is_p && tmpl->hash == hash &&
+                tmpl->len_text == len_text &&
+                memcmp(tmpl->text, text, len_text) == 0)
+            return tmpl;
+    }
     else {
-        ret_var = purc_variant_make_string (rw_string, false);
+        cache = calloc(1, sizeof(*cache));
+        if (cache == NULL ||
+                !purc_set_local_data(LDNAME_FORMAT_TEMPLATES,
+                    (uintptr_t)cache, cb_free_fmt_cache)) {
+            free(cache);
+            purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
+            return NULL;
+        }
     }
 
-    purc_rwstream_destroy (rwstream);
+    struct fmt_template *tmpl = calloc(1, sizeof(*tmpl));
+    if (tmpl == NULL)
+        goto failed;
 
-    return ret_var;
+    tmpl->is_p = is_p;
+    tmpl->hash = hash;
+    tmpl->len_text = len_text;
+    tmpl->text = strndup(text, len_text);
+    tmpl->segs = malloc(sizeof(struct fmt_segment) * (len_text + 1));
+    if (tmpl->text == NULL || tmpl->segs == NULL)
+        goto failed;
+
+    if (!(is_p ? fmt_template_compile_p(tmpl) : fmt_template_compile_c(tmpl)))
+        goto failed_compile;
+
+    /* shrink the segment list */
+    struct fmt_segment *segs = realloc(tmpl->segs,
+            sizeof(struct fmt_segment) * (tmpl->nr_segs ? tmpl->nr_segs : 1));
+    if (segs)
+        tmpl->segs = segs;
+
+    fmt_template_delete(cache->tmpls[slot]);
+    cache->tmpls[slot] = tmpl;
+    return tmpl;
+
+failed:
+    purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
+failed_compile:
+    fmt_template_delete(tmpl);
+    return NULL;
 }
 
-static purc_variant_t
-format_c_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
-        unsigned call_flags)
+/* the arguments given by the argument list, or by a linear container */
+struct fmt_args {
+    purc_variant_t     *argv;
+    purc_variant_t      container;
+    size_t              nr_args;
+};
+
+static inline purc_variant_t
+fmt_args_get(const struct fmt_args *args, size_t idx)
 {
-    UNUSED_PARAM(root);
-    UNUSED_PARAM(call_flags);
+    if (idx >= args->nr_args)
+        return PURC_VARIANT_INVALID;
+    if (args->container)
+        return purc_variant_linear_container_get(args->container, idx);
+    return args->argv[idx];
+}
 
-    const char *format = NULL;
-    purc_variant_t ret_var = PURC_VARIANT_INVALID;
-    purc_rwstream_t rwstream = purc_rwstream_new_buffer (32, STREAM_SIZE);
+static int
+fmt_render_c(const struct fmt_template *tmpl, const struct fmt_args *args,
+        purc_rwstream_t rws)
+{
+    /* "%lf" of DBL_MAX needs more than 300 bytes */
+    char buff[512];
+    size_t j = 0;
 
-    if ((argv == NULL) || (nr_args == 0)) {
-        purc_rwstream_destroy (rwstream);
-        purc_set_error (PURC_ERROR_ARGUMENT_MISSED);
+    for (size_t i = 0; i < tmpl->nr_segs; i++) {
+        const struct fmt_segment *seg = tmpl->segs + i;
+        const char *str = buff;
+        int len = 0;
+
+        if (seg->type == FMT_SEG_LITERAL) {
+            purc_rwstream_write (rws, seg->literal, seg->len);
+            continue;
+        }
+
+        purc_variant_t arg = fmt_args_get(args, j++);
+        if (arg == PURC_VARIANT_INVALID) {
+            purc_set_error (PURC_ERROR_ARGUMENT_MISSED);
+            return -1;
+        }
+
+        int64_t i64 = 0;
+        uint64_t u64 = 0;
+        double number = 0;
+        size_t len_str;
+        switch (seg->type) {
+        case FMT_SEG_LONGINT:
+            purc_variant_cast_to_longint (arg, &i64, false);
+            len = snprintf (buff, sizeof(buff), "%lld", (long long int)i64);
+            break;
+        case FMT_SEG_OCTAL:
+            purc_variant_cast_to_ulongint (arg, &u64, false);
+            len = snprintf (buff, sizeof(buff), "%llo",
+                    (long long unsigned)u64);
+            break;
+        case FMT_SEG_ULONGINT:
+            purc_variant_cast_to_ulongint (arg, &u64, false);
+            len = snprintf (buff, sizeof(buff), "%llu",
+                    (long long unsigned)u64);
+            break;
+        case FMT_SEG_HEX:
+            purc_variant_cast_to_ulongint (arg, &u64, false);
+            len = snprintf (buff, sizeof(buff), "%llx",
+                    (long long unsigned)u64);
+            break;
+        case FMT_SEG_NUMBER:
+            purc_variant_cast_to_number (arg, &number, false);
+            len = snprintf (buff, sizeof(buff), "%lf", number);
+            break;
+        case FMT_SEG_STRING:
+            str = purc_variant_get_string_const_ex (arg, &len_str);
+            if (str == NULL) {
+                purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+                return -1;
+            }
+            purc_rwstream_write (rws, str, len_str);
+            continue;
+        default:
+            assert(0);
+            break;
+        }
+
+        if (len > 0) {
+            if ((size_t)len >= sizeof(buff))
+                len = sizeof(buff) - 1;
+            purc_rwstream_write (rws, str, len);
+        }
+    }
+
+    return 0;
+}
+
+static int
+fmt_render_p(const struct fmt_template *tmpl, purc_variant_t data,
+        purc_rwstream_t rws)
+{
+    bool is_object = purc_variant_is_object (data);
+
+    for (size_t i = 0; i < tmpl->nr_segs; i++) {
+        const struct fmt_segment *seg = tmpl->segs + i;
+
+        if (seg->type == FMT_SEG_LITERAL) {
+            purc_rwstream_write (rws, seg->literal, seg->len);
+            continue;
+        }
+
+        purc_variant_t member;
+        if (is_object)
+            member = purc_variant_object_get_by_ckey (data, seg->key);
+        else if (seg->index >= 0)
+            member = purc_variant_linear_container_get (data, seg->index);
+        else
+            member = PURC_VARIANT_INVALID;
+
+        if (member == PURC_VARIANT_INVALID) {
+            purc_set_error (PURC_ERROR_NOT_FOUND);
+            return -1;
+        }
+
+        // a string goes as is; others are serialized
+        size_t len_str;
+        const char *str = purc_variant_get_string_const_ex (member, &len_str);
+        if (str) {
+            purc_rwstream_write (rws, str, len_str);
+        }
+        else if (purc_variant_serialize (member, rws, 0,
+                    PCVRNT_SERIALIZE_OPT_REAL_JSON |
+                    PCVRNT_SERIALIZE_OPT_RUNTIME_STRING, NULL) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static bool
+fmt_is_data_container(purc_variant_t v)
+{
+    enum purc_variant_type vt = purc_variant_get_type(v);
+    return vt == PURC_VARIANT_TYPE_ARRAY || vt == PURC_VARIANT_TYPE_SET ||
+        vt == PURC_VARIANT_TYPE_TUPLE || vt == PURC_VARIANT_TYPE_OBJECT;
+}
+
+/* the literal text plus an estimated size of the placeholders */
+static inline size_t
+fmt_initial_size(const struct fmt_template *tmpl)
+{
+    size_t sz = tmpl->len_literals + tmpl->nr_holders * 16 + 1;
+    return (sz < LEN_INI_PRINT_BUF) ? LEN_INI_PRINT_BUF : sz;
+}
+
+/* render one row, and return the result as a string */
+static purc_variant_t
+fmt_render_one(const struct fmt_template *tmpl, const struct fmt_args *args,
+        purc_variant_t data)
+{
+    purc_rwstream_t rws = purc_rwstream_new_buffer (fmt_initial_size(tmpl),
+            LEN_MAX_PRINT_BUF);
+    if (rws == NULL) {
+        purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
         return PURC_VARIANT_INVALID;
     }
 
-    if (!purc_variant_is_string (argv[0])) {
-        purc_rwstream_destroy (rwstream);
-        purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+    int ret = tmpl->is_p ? fmt_render_p(tmpl, data, rws) :
+        fmt_render_c(tmpl, args, rws);
+    if (ret || purc_rwstream_write (rws, "", 1) < 1) {
+        purc_rwstream_destroy (rws);
         return PURC_VARIANT_INVALID;
     }
-    else
-        format = purc_variant_get_string_const (argv[0]);
-
-    char buffer[16];
-    int start = 0;
-    int i = 0;
-    int j = 1;
-    int64_t i64 = 0;
-    uint64_t u64 = 0;
-    double number = 0;
-    const char *temp_str = NULL;
-
-    while (*(format + i) != 0x00) {
-        if (*(format + i) == '%') {
-            switch (*(format + i + 1)) {
-                case 0x00:
-                    break;
-                case '%':
-                    purc_rwstream_write (rwstream, format + start, i - start);
-                    purc_rwstream_write (rwstream, "%", 1);
-                    i++;
-                    start = i + 1;
-                    break;
-                case 'd':
-                    purc_rwstream_write (rwstream, format + start, i - start);
-                    if (argv[j] == PURC_VARIANT_INVALID) {
-                        purc_rwstream_destroy (rwstream);
-                        return PURC_VARIANT_INVALID;
-                    }
-                    purc_variant_cast_to_longint (argv[j], &i64, false);
-                    sprintf (buffer, "%lld", (long long int)i64);
-                    purc_rwstream_write (rwstream, buffer, strlen (buffer));
-                    i++;
-                    j++;
-                    start = i + 1;
-                    break;
-                case 'o':
-                    purc_rwstream_write (rwstream, format + start, i - start);
-                    if (argv[j] == PURC_VARIANT_INVALID) {
-                        purc_rwstream_destroy (rwstream);
-                        return PURC_VARIANT_INVALID;
-                    }
-                    purc_variant_cast_to_ulongint (argv[j], &u64, false);
-                    sprintf (buffer, "%llo", (long long unsigned)u64);
-                    purc_rwstream_write (rwstream, buffer, strlen (buffer));
-                    i++;
-                    j++;
-                    start = i + 1;
-                    break;
-                case 'u':
-                    purc_rwstream_write (rwstream, format + start, i - start);
-                    if (argv[j] == PURC_VARIANT_INVALID) {
-                        purc_rwstream_destroy (rwstream);
-                        return PURC_VARIANT_INVALID;
-                    }
-                    purc_variant_cast_to_ulongint (argv[j], &u64, false);
-                    sprintf (buffer, "%llu", (long long unsigned)u64);
-                    purc_rwstream_write (rwstream, buffer, strlen (buffer));
-                    i++;
-                    j++;
-                    start = i + 1;
-                    break;
-                case 'x':
-                    purc_rwstream_write (rwstream, format + start, i - start);
-                    if (argv[j] == PURC_VARIANT_INVALID) {
-                        purc_rwstream_destroy (rwstream);
-                        return PURC_VARIANT_INVALID;
-                    }
-                    purc_variant_cast_to_ulongint (argv[j], &u64, false);
-                    sprintf (buffer, "%llx", (long long unsigned)u64);
-                    purc_rwstream_write (rwstream, buffer, strlen (buffer));
-                    i++;
-                    j++;
-                    start = i + 1;
-                    break;
-                case 'f':
-                    purc_rwstream_write (rwstream, format + start, i - start);
-                    if (argv[j] == PURC_VARIANT_INVALID) {
-                        purc_rwstream_destroy (rwstream);
-                        return PURC_VARIANT_INVALID;
-                    }
-                    purc_variant_cast_to_number (argv[j], &number, false);
-                    sprintf (buffer, "%lf", number);
-                    purc_rwstream_write (rwstream, buffer, strlen (buffer));
-                    i++;
-                    j++;
-                    start = i + 1;
-                    break;
-                case 's':
-                    purc_rwstream_write (rwstream, format + start, i - start);
-                    if (argv[j] == PURC_VARIANT_INVALID) {
-                        purc_rwstream_destroy (rwstream);
-                        return PURC_VARIANT_INVALID;
-                    }
-                    if (!purc_variant_is_string (argv[0])) {
-                        purc_rwstream_destroy (rwstream);
-                        return PURC_VARIANT_INVALID;
-                    }
-                    temp_str = purc_variant_get_string_const (argv[j]);
-                    purc_rwstream_write (rwstream, temp_str, strlen (temp_str));
-                    i++;
-                    j++;
-                    start = i + 1;
-                    break;
-            }
-        }
-        i++;
+
+    size_t sz_content = 0, sz_buffer = 0;
+    char *content = purc_rwstream_get_mem_buffer_ex (rws,
+            &sz_content, &sz_buffer, true);
+    purc_rwstream_destroy (rws);
+
+    return purc_variant_make_string_reuse_buff (content, sz_buffer, false);
+}
+
+/* render all rows with one buffer, and return an array of strings */
+static purc_variant_t
+fmt_render_rows(const struct fmt_template *tmpl, purc_variant_t rows)
+{
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    purc_rwstream_t rws = NULL;
+    size_t nr_rows;
+
+    if (!purc_variant_linear_container_size (rows, &nr_rows)) {
+        purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+        goto failed;
     }
 
-    if (i != start)
-        purc_rwstream_write (rwstream, format + start, strlen (format + start));
-    purc_rwstream_write (rwstream, "\0", 1);
+    ret_var = purc_variant_make_array (0, PURC_VARIANT_INVALID);
+    rws = purc_rwstream_new_buffer (fmt_initial_size(tmpl), LEN_MAX_PRINT_BUF);
+    if (ret_var == PURC_VARIANT_INVALID || rws == NULL) {
+        purc_set_error (PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
 
-    size_t rw_size = 0;
-    size_t content_size = 0;
-    char *rw_string = purc_rwstream_get_mem_buffer_ex (rwstream,
-            &content_size, &rw_size, true);
+    for (size_t i = 0; i < nr_rows; i++) {
+        purc_variant_t row = purc_variant_linear_container_get (rows, i);
+        int ret;
 
-    if ((rw_size == 0) || (rw_string == NULL))
-        ret_var = PURC_VARIANT_INVALID;
-    else {
-        ret_var = purc_variant_make_string_reuse_buff (rw_string,
-                rw_size, false);
-        if(ret_var == PURC_VARIANT_INVALID) {
-            purc_set_error (PURC_ERROR_INVALID_VALUE);
-            ret_var = PURC_VARIANT_INVALID;
+        purc_rwstream_seek (rws, 0, SEEK_SET);
+        if (tmpl->is_p) {
+            if (!fmt_is_data_container (row)) {
+                purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+                goto failed;
+            }
+            ret = fmt_render_p(tmpl, row, rws);
+        }
+        else {
+            struct fmt_args args = { NULL, row, 0 };
+            if (!purc_variant_linear_container_size (row, &args.nr_args)) {
+                purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+                goto failed;
+            }
+            ret = fmt_render_c(tmpl, &args, rws);
         }
-    }
 
-    purc_rwstream_destroy (rwstream);
+        if (ret)
+            goto failed;
+
+        size_t len = (size_t)purc_rwstream_tell (rws);
+        const char *content = purc_rwstream_get_mem_buffer (rws, NULL);
+        purc_variant_t line = purc_variant_make_string_ex (content, len,
+                false);
+        if (line == PURC_VARIANT_INVALID)
+            goto failed;
 
+        bool ok = purc_variant_array_append (ret_var, line);
+        purc_variant_unref (line);
+        if (!ok)
+            goto failed;
+    }
+
+    purc_rwstream_destroy (rws);
     return ret_var;
+
+failed:
+    if (rws)
+        purc_rwstream_destroy (rws);
+    if (ret_var)
+        purc_variant_unref (ret_var);
+    return PURC_VARIANT_INVALID;
 }
 
+/*
+ * $STR.format_c(<string $format>, <any $arg0>, ...)
+ * $STR.format_c(<string $format>, <array $rows>, <boolean $rows = true>)
+ *
+ * The second form is selected only by passing exactly three arguments,
+ * with an array and the boolean true after the format. Every member of
+ * $rows is then a linear container holding the arguments for one line,
+ * and an array of the lines is returned.
+ */
 static purc_variant_t
-format_p_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+format_c_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         unsigned call_flags)
 {
     UNUSED_PARAM(root);
     UNUSED_PARAM(call_flags);
 
-    const char *format = NULL;
-    purc_variant_t ret_var = PURC_VARIANT_INVALID;
-    purc_variant_t tmp_var = PURC_VARIANT_INVALID;
-    purc_rwstream_t rwstream = purc_rwstream_new_buffer (32, STREAM_SIZE);
-    int type = 0;
-    char buffer[32];
-    int index = 0;
-    char *buf = NULL;
-    size_t sz_stream = 0;
-    size_t format_size = 0;
-    purc_rwstream_t serialize = NULL;     // used for serialize
-
     if ((argv == NULL) || (nr_args == 0)) {
-        purc_rwstream_destroy(rwstream);
         purc_set_error (PURC_ERROR_ARGUMENT_MISSED);
         return PURC_VARIANT_INVALID;
     }
 
-    if ( (!purc_variant_is_string (argv[0]))) {
-        purc_rwstream_destroy(rwstream);
+    if (!purc_variant_is_string (argv[0])) {
         purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
         return PURC_VARIANT_INVALID;
     }
-    else {
-        format = purc_variant_get_string_const (argv[0]);
-        format_size = purc_variant_string_size (argv[0]);
-    }
 
-    if (argv[1] == PURC_VARIANT_INVALID) {
-        purc_rwstream_destroy(rwstream);
-        purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+    struct fmt_template *tmpl = fmt_template_get(argv[0], false);
+    if (tmpl == NULL)
         return PURC_VARIANT_INVALID;
-    }
 
-    enum purc_variant_type vt = purc_variant_get_type(argv[1]);
-    if (vt == PURC_VARIANT_TYPE_ARRAY || vt == PURC_VARIANT_TYPE_SET
-            || vt == PURC_VARIANT_TYPE_TUPLE) {
-        type = 0;
-    }
-    else if (vt == PURC_VARIANT_TYPE_OBJECT) {
-        type = 1;
-    }
-    else {
-        purc_rwstream_destroy(rwstream);
-        purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
-        return PURC_VARIANT_INVALID;
-    }
-
-    if (type == 0) {
-        const char *start = NULL;
-        const char *end = NULL;
-        size_t length = 0;
-        const char *head = pcutils_get_next_token (format, "{", &length);
-        while (head) {
-            purc_rwstream_write (rwstream, head, length);
-
-            start = head + length + 1;
-            head = pcutils_get_next_token (head + length + 1, "}", &length);
-            end = head + length;
-            strncpy(buffer, start, end - start);
-            *(buffer + (end - start)) = 0x00;
-            pcdvobjs_remove_space (buffer);
-            index = atoi (buffer);
-
-            tmp_var = purc_variant_linear_container_get (argv[1], index);
-            if (tmp_var == PURC_VARIANT_INVALID) {
-                purc_rwstream_destroy (rwstream);
-                return PURC_VARIANT_INVALID;
-            }
+    if (nr_args == 3 && argv[1] != PURC_VARIANT_INVALID &&
+            purc_variant_is_array (argv[1]) &&
+            argv[2] != PURC_VARIANT_INVALID &&
+            purc_variant_is_true (argv[2]))
+        return fmt_render_rows(tmpl, argv[1]);
 
-            serialize = purc_rwstream_new_buffer (32, STREAM_SIZE);
-            purc_variant_serialize (tmp_var, serialize, 3, 0, &sz_stream);
-            buf = purc_rwstream_get_mem_buffer (serialize, &sz_stream);
-            purc_rwstream_write (rwstream, buf + 1, sz_stream - 2);
-            purc_rwstream_destroy (serialize);
-
-            head = pcutils_get_next_token (head + length + 1, "{", &length);
-            end++;
+    struct fmt_args args = { argv + 1, PURC_VARIANT_INVALID, nr_args - 1 };
+    return fmt_render_one(tmpl, &args, PURC_VARIANT_INVALID);
+}
 
-            if (length == format_size - (head - format) - 1)
-                break;
-        }
+/*
+ * $STR.format_p(<string $format>, <array | object $data>
+ *      [, <boolean $rows = false>])
+ *
+ * When $rows is true, every member of $data is an array or an object
+ * for one line, and an array of the lines is returned.
+ */
+static purc_variant_t
+format_p_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        unsigned call_flags)
+{
+    UNUSED_PARAM(root);
+    UNUSED_PARAM(call_flags);
 
-        if (end != NULL)
-            purc_rwstream_write (rwstream, end, strlen (end));
+    if ((argv == NULL) || (nr_args < 2)) {
+        purc_set_error (PURC_ERROR_ARGUMENT_MISSED);
+        return PURC_VARIANT_INVALID;
     }
-    else {
-        const char *start = NULL;
-        const char *end = NULL;
-        size_t length = 0;
-        const char *head = pcutils_get_next_token (format, "{", &length);
-        while (head) {
-            purc_rwstream_write (rwstream, head, length);
-
-            start = head + length + 1;
-            head = pcutils_get_next_token (head + length + 1, "}", &length);
-            end = head + length;
-            strncpy(buffer, start, end - start);
-            *(buffer + (end - start)) = 0x00;
-            pcdvobjs_remove_space (buffer);
-
-            tmp_var = purc_variant_object_get_by_ckey (argv[1], buffer);
-            if (tmp_var == PURC_VARIANT_INVALID) {
-                purc_rwstream_destroy (rwstream);
-                return PURC_VARIANT_INVALID;
-            }
 
-            serialize = purc_rwstream_new_buffer (32, STREAM_SIZE);
-            purc_variant_serialize (tmp_var, serialize, 3, 0, &sz_stream);
-            buf = purc_rwstream_get_mem_buffer (serialize, &sz_stream);
-            purc_rwstream_write (rwstream, buf + 1, sz_stream - 2);
-            purc_rwstream_destroy (serialize);
-
-            head = pcutils_get_next_token (head + length + 1, "{", &length);
-            end++;
-
-            if (length == format_size - (head - format) - 1)
-                break;
-        }
+    if (!purc_variant_is_string (argv[0])) {
+        purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+        return PURC_VARIANT_INVALID;
+    }
 
-        if (end != NULL)
-            purc_rwstream_write (rwstream, end, strlen (end));
+    if (argv[1] == PURC_VARIANT_INVALID ||
+            !fmt_is_data_container (argv[1])) {
+        purc_set_error (PURC_ERROR_WRONG_DATA_TYPE);
+        return PURC_VARIANT_INVALID;
     }
 
-    size_t rw_size = 0;
-    size_t content_size = 0;
-    char *rw_string = purc_rwstream_get_mem_buffer_ex (rwstream,
-            &content_size, &rw_size, true);
+    bool rows = false;
+    if (nr_args > 2 && argv[2] != PURC_VARIANT_INVALID)
+        rows = purc_variant_booleanize (argv[2]);
 
-    if ((rw_size == 0) || (rw_string == NULL))
-        ret_var = PURC_VARIANT_INVALID;
-    else {
-        ret_var = purc_variant_make_string_reuse_buff (rw_string,
-                content_size, false);
-        if(ret_var == PURC_VARIANT_INVALID) {
-            purc_set_error (PURC_ERROR_INVALID_VALUE);
-            ret_var = PURC_VARIANT_INVALID;
-        }
-    }
+    struct fmt_template *tmpl = fmt_template_get(argv[0], true);
+    if (tmpl == NULL)
+        return PURC_VARIANT_INVALID;
 
-    purc_rwstream_destroy (rwstream);
+    if (rows)
+        return fmt_render_rows(tmpl, argv[1]);
 
-    return ret_var;
+    return fmt_render_one(tmpl, NULL, argv[1]);
 }
 
 static purc_variant_t
@@ -1216,6 +1675,11 @@ substr_getter (purc_variant_t root, size_t nr_args, purc_variant_t *argv,
     length = end - start;
     if (length == 0)
         return purc_variant_make_string("", false);
+    else if (end == src + str_len - 1 && length >= (int64_t)(str_len / 4)) {
+        /* A tail which is not too small shares the buffer of the source;
+           a small one does not pin the source. */
+        ret_var = pcvariant_make_string_shared (argv[0], start, length);
+    }
     else {
         char *buf = malloc (length + 1);
         if (buf == NULL) {
@@ -55,129 +55,178 @@ static struct keyword_to_atom {
     { _KW_rfc3986,          PCUTILS_URL_OPT_RFC3986,    0 },
 };
 
-size_t pcdvobj_url_decode_in_place(char *string, size_t length, int rfc)
-{
-    size_t nr_decoded = 0;
-    size_t left = length;
-    unsigned char *dest = (unsigned char *)string;
+/* 1 for the bytes which are kept as is: ALPHA, DIGIT, '-', '_', and '.' */
+static const unsigned char url_unreserved[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
 
-    while (left > 0) {
-        unsigned char decoded;
+/* the values of hexadecimal digits; -1 for others */
+static const signed char url_hex_values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+static const char url_hex_digits[] = "0123456789ABCDEF";
+
+/* Decodes the percent-encoded string to dst, which can be the same as
+   string; returns the number of the bytes left undecoded. */
+static size_t
+url_decode_bytes(unsigned char *dst, const char *string, size_t length,
+        int rfc, size_t *nr_decoded)
+{
+    const unsigned char *src = (const unsigned char *)string;
+    const unsigned char *end = src + length;
+    unsigned char *out = dst;
+
+    while (src < end) {
+        /* copy the run of unreserved characters */
+        const unsigned char *run = src;
+        while (run < end && url_unreserved[*run])
+            run++;
+
+        if (run > src) {
+            if (out != src)
+                memmove(out, src, run - src);
+            out += run - src;
+            src = run;
+            if (src == end)
+                break;
+        }
 
-        if (rfc == PURC_K_KW_rfc1738 && *string == '+') {
-            decoded = ' ';
+        if (*src == '+' && rfc == PURC_K_KW_rfc1738) {
+            *out++ = ' ';
+            src++;
         }
-        else if (purc_isalnum(*string) ||
-                *string == '-' || *string == '_' || *string == '.') {
-            decoded = (unsigned char)*string;
+        else if (*src == '%' && end - src > 2 &&
+                url_hex_values[src[1]] >= 0 && url_hex_values[src[2]] >= 0) {
+            *out++ = (unsigned char)((url_hex_values[src[1]] << 4) |
+                    url_hex_values[src[2]]);
+            src += 3;
         }
         else {
-            if (*string == '%') {
-                if (left > 2) {
-                    if (pcutils_hex2byte(string + 1, &decoded)) {
-                        goto bad_encoding;
-                    }
-
-                    string += 2;
-                    left -= 2;
-                }
-                else {
-                    goto bad_encoding;
-                }
-            }
-            else {
-                goto bad_encoding;
-            }
+            break;
         }
-
-        dest[nr_decoded] = decoded;
-        nr_decoded++;
-
-        left--;
-        string++;
     }
 
-bad_encoding:
-    dest[nr_decoded] = 0;
-    return left;
+    *nr_decoded = out - dst;
+    return end - src;
 }
 
-int pcdvobj_url_encode(struct pcutils_mystring *mystr,
-        const unsigned char *bytes, size_t nr_bytes, int rfc)
+size_t pcdvobj_url_decode_in_place(char *string, size_t length, int rfc)
 {
-    for (size_t i = 0; i < nr_bytes; i++) {
-        unsigned char encoded[4];
-        size_t len = 0;
+    size_t nr_decoded;
+    size_t left = url_decode_bytes((unsigned char *)string, string, length,
+            rfc, &nr_decoded);
 
-        if (rfc == PURC_K_KW_rfc1738 && bytes[i] == ' ') {
-            encoded[0] = '+';
-            len = 1;
-        }
-        else if (purc_isalnum(bytes[i]) ||
-                bytes[i] == '-' || bytes[i] == '_' || bytes[i] == '.') {
-            encoded[0] = bytes[i];
-            len = 1;
-        }
-        else {
-            encoded[0] = '%';
-            pcutils_bin2hex(bytes + i, 1, (char *)encoded + 1, true);
-            len = 3;
-        }
+    string[nr_decoded] = 0;
+    return left;
+}
 
-        if (pcutils_mystring_append_mchar(mystr, encoded, len))
+/* makes sure there is room for extra bytes and the terminating null byte */
+static int
+url_reserve_space(struct pcutils_mystring *mystr, size_t extra)
+{
+    size_t sz = mystr->nr_bytes + extra + 1;
+    if (sz > mystr->sz_space) {
+        char *buff = realloc(mystr->buff, sz);
+        if (buff == NULL)
             return -1;
+
+        mystr->buff = buff;
+        mystr->sz_space = sz;
     }
 
     return 0;
 }
 
-int pcdvobj_url_decode(struct pcutils_mystring *mystr,
-        const char *string, size_t length, int rfc, bool silently)
+int pcdvobj_url_encode(struct pcutils_mystring *mystr,
+        const unsigned char *bytes, size_t nr_bytes, int rfc)
 {
-    size_t left = length;
+    bool plus_for_space = (rfc == PURC_K_KW_rfc1738);
 
-    while (left > 0) {
-        unsigned char decoded;
+    /* calculate the length of the encoded string first */
+    size_t len_encoded = nr_bytes;
+    for (size_t i = 0; i < nr_bytes; i++) {
+        if (!url_unreserved[bytes[i]] && !(plus_for_space && bytes[i] == ' '))
+            len_encoded += 2;
+    }
 
-        if (rfc == PURC_K_KW_rfc1738 && *string == '+') {
-            decoded = ' ';
-        }
-        else if (purc_isalnum(*string) ||
-                *string == '-' || *string == '_' || *string == '.') {
-            decoded = (unsigned char)*string;
-        }
-        else {
-            if (*string == '%') {
-                if (left > 2) {
-                    if (pcutils_hex2byte(string + 1, &decoded)) {
-                        goto bad_encoding;
-                    }
+    if (url_reserve_space(mystr, len_encoded))
+        return -1;
 
-                    string += 2;
-                    left -= 2;
-                }
-                else {
-                    goto bad_encoding;
-                }
-            }
-            else {
-                goto bad_encoding;
-            }
-        }
+    char *out = mystr->buff + mystr->nr_bytes;
+    const unsigned char *end = bytes + nr_bytes;
+    while (bytes < end) {
+        /* copy the run of unreserved characters */
+        const unsigned char *run = bytes;
+        while (run < end && url_unreserved[*run])
+            run++;
 
-        if (pcutils_mystring_append_mchar(mystr, &decoded, 1))
-            return -1;
+        memcpy(out, bytes, run - bytes);
+        out += run - bytes;
+        if (run == end)
+            break;
 
-        left--;
-        string++;
+        if (plus_for_space && *run == ' ') {
+            *out++ = '+';
+        }
+        else {
+            *out++ = '%';
+            *out++ = url_hex_digits[*run >> 4];
+            *out++ = url_hex_digits[*run & 0x0F];
+        }
+        bytes = run + 1;
     }
 
+    mystr->nr_bytes += len_encoded;
     return 0;
+}
 
-bad_encoding:
-    if (silently)
-        return 0;
-    return 1;
+int pcdvobj_url_decode(struct pcutils_mystring *mystr,
+        const char *string, size_t length, int rfc, bool silently)
+{
+    /* the decoded bytes never outnumber the encoded ones */
+    if (url_reserve_space(mystr, length))
+        return -1;
+
+    size_t nr_decoded;
+    size_t left = url_decode_bytes(
+            (unsigned char *)mystr->buff + mystr->nr_bytes,
+            string, length, rfc, &nr_decoded);
+    mystr->nr_bytes += nr_decoded;
+
+    if (left > 0 && !silently)
+        return 1;
+    return 0;
 }
 
 static purc_variant_t
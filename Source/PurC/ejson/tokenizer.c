@@ -32,6 +32,7 @@
 #include "private/errors.h"
 #include "private/debug.h"
 #include "private/utils.h"
+#include "private/dtoa.h"
 #include "private/stack.h"
 #include "private/tkz-helper.h"
 #include "private/atom-buckets.h"
@@ -2097,7 +2098,7 @@ BEGIN_STATE(EJSON_TKZ_STATE_AFTER_VALUE_NUMBER)
             SET_ERR(PCEJSON_ERROR_BAD_JSON_NUMBER);
             RETURN_AND_STOP_PARSE();
         }
-        double d = strtod(
+        double d = pcutils_strtod(
                 tkz_buffer_get_bytes(parser->temp_buffer), NULL);
         top->node = pcvcm_node_new_number(d);
         update_tkz_stack(parser);
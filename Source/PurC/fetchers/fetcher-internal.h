@@ -29,6 +29,10 @@
 
 #define PCFETCHER_INITIAL_PROGRESS  0.1
 
+/* Response bodies announced at least this large are delivered by the fetcher
+ * process in one shared memory segment. */
+#define PCFETCHER_SHM_BODY_THRESHOLD    (1024 * 1024)
+
 #ifdef __cplusplus
 extern "C" {
 #endif  /* __cplusplus */
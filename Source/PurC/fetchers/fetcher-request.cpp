@@ -35,6 +35,7 @@
 #include "ResourceResponse.h"
 
 #include "private/url.h"
+#include "private/rwstream.h"
 
 #include <wtf/RunLoop.h>
 
@@ -365,6 +366,11 @@ void PcFetcherRequest::didReceiveMessage(IPC::Connection&,
                 decoder, this, &PcFetcherRequest::didReceiveSharedBuffer);
         return;
     }
+    if (decoder.messageName() == Messages::WebResourceLoader::DidReceiveSharedMemory::name()) {
+        IPC::handleMessage<Messages::WebResourceLoader::DidReceiveSharedMemory>(
+                decoder, this, &PcFetcherRequest::didReceiveSharedMemory);
+        return;
+    }
     if (decoder.messageName() == Messages::WebResourceLoader::DidFinishResourceLoad::name()) {
         IPC::handleMessage<Messages::WebResourceLoader::DidFinishResourceLoad>(
                 decoder, this, &PcFetcherRequest::didFinishResourceLoad);
@@ -421,6 +427,11 @@ void PcFetcherRequest::didReceiveResponse(
         init = DEF_RWS_SIZE;
         m_estimatedLength = progressItemDefaultEstimatedLength;
     }
+    else if (m_callback->header.sz_resp >= PCFETCHER_SHM_BODY_THRESHOLD) {
+        /* the body will arrive in a shared memory segment */
+        init = DEF_RWS_SIZE;
+        m_estimatedLength = m_callback->header.sz_resp;
+    }
     else {
         init = m_callback->header.sz_resp;
         m_estimatedLength = m_callback->header.sz_resp;
@@ -435,24 +446,19 @@ void PcFetcherRequest::didReceiveResponse(
         );
     }
     m_callback->rws = purc_rwstream_new_buffer(init, INT_MAX);
+    m_rwsIsMapped = false;
 }
 
-void PcFetcherRequest::didReceiveSharedBuffer(
-        IPC::SharedBufferDataReference&& data, int64_t encodedDataLength)
+void PcFetcherRequest::updateProgress(size_t sizeReceived)
 {
-    UNUSED_PARAM(encodedDataLength);
-    auto locker = holdLock(m_callbackLock);
-    if (m_callback == NULL) {
-        return;
-    }
-    m_bytesReceived += data.size();
+    m_bytesReceived += sizeReceived;
     if (m_bytesReceived > m_estimatedLength) {
         m_estimatedLength = m_bytesReceived * 2;
     }
     double increment, percentOfRemainingBytes;
     long long remainingBytes = m_estimatedLength - m_bytesReceived;
     if (remainingBytes > 0)  // Prevent divide by 0.
-         percentOfRemainingBytes = (double)data.size() / (double)remainingBytes;
+         percentOfRemainingBytes = (double)sizeReceived / (double)remainingBytes;
     else
         percentOfRemainingBytes = 1.0;
 
@@ -467,10 +473,85 @@ void PcFetcherRequest::didReceiveSharedBuffer(
             }
         );
     }
+}
 
+void PcFetcherRequest::didReceiveSharedBuffer(
+        IPC::SharedBufferDataReference&& data, int64_t encodedDataLength)
+{
+    UNUSED_PARAM(encodedDataLength);
+    auto locker = holdLock(m_callbackLock);
+    if (m_callback == NULL) {
+        return;
+    }
+
+    updateProgress(data.size());
+    ensureWritableStream();
     purc_rwstream_write(m_callback->rws, data.data(), data.size());
 }
 
+static void releaseSharedMemory(void *ctxt)
+{
+    static_cast<SharedMemory*>(ctxt)->deref();
+}
+
+void PcFetcherRequest::didReceiveSharedMemory(SharedMemory::Handle&& handle,
+        uint64_t dataSize, int64_t encodedDataLength)
+{
+    UNUSED_PARAM(encodedDataLength);
+    auto locker = holdLock(m_callbackLock);
+    if (m_callback == NULL) {
+        return;
+    }
+
+    auto sharedMemory = SharedMemory::map(handle,
+            SharedMemory::Protection::ReadOnly);
+    if (!sharedMemory || dataSize > sharedMemory->size()) {
+        return;
+    }
+
+    bool isWholeBody = (m_bytesReceived == 0);
+    updateProgress(dataSize);
+
+    if (!isWholeBody) {
+        ensureWritableStream();
+        purc_rwstream_write(m_callback->rws, sharedMemory->data(), dataSize);
+        return;
+    }
+
+    /* The whole body is in the segment: wrap the mapping instead of copying
+       it; the mapping lives as long as the returned rwstream. */
+    SharedMemory *mapped = sharedMemory.leakRef();
+    purc_rwstream_t rws = pcrwstream_new_from_readonly_mem(mapped->data(),
+            dataSize, releaseSharedMemory, mapped);
+    if (rws == NULL) {
+        mapped->deref();
+        return;
+    }
+
+    if (m_callback->rws) {
+        purc_rwstream_destroy(m_callback->rws);
+    }
+    m_callback->rws = rws;
+    m_rwsIsMapped = true;
+}
+
+void PcFetcherRequest::ensureWritableStream()
+{
+    if (!m_rwsIsMapped) {
+        return;
+    }
+
+    /* more data than announced: fall back to a growing memory stream */
+    size_t sz_content = 0;
+    void *mapped = purc_rwstream_get_mem_buffer_ex(m_callback->rws,
+            &sz_content, NULL, false);
+    purc_rwstream_t rws = purc_rwstream_new_buffer(sz_content * 2, INT_MAX);
+    purc_rwstream_write(rws, mapped, sz_content);
+    purc_rwstream_destroy(m_callback->rws);
+    m_callback->rws = rws;
+    m_rwsIsMapped = false;
+}
+
 void PcFetcherRequest::didFinishResourceLoad(
         const NetworkLoadMetrics& networkLoadMetrics)
 {
@@ -32,6 +32,7 @@
 
 #include "WebCoreArgumentCoders.h"
 #include "SharedBufferDataReference.h"
+#include "SharedMemory.h"
 #include "Connection.h"
 #include "MessageReceiverMap.h"
 #include "ProcessLauncher.h"
@@ -110,12 +111,17 @@ protected:
     void didReceiveResponse(const PurCFetcher::ResourceResponse&, bool);
     void didReceiveSharedBuffer(IPC::SharedBufferDataReference&&,
             int64_t encodedDataLength);
+    void didReceiveSharedMemory(SharedMemory::Handle&&, uint64_t dataSize,
+            int64_t encodedDataLength);
     void didFinishResourceLoad(const PurCFetcher::NetworkLoadMetrics&);
     void didFailResourceLoad(const ResourceError& error);
     void willSendRequest(ResourceRequest&&,
             IPC::FormDataReference&& requestBody, ResourceResponse&&);
 
 private:
+    void updateProgress(size_t sizeReceived);
+    void ensureWritableStream();
+
     uint64_t m_sessionId;
     uint64_t m_req_id;
     bool m_is_async;
@@ -134,6 +140,7 @@ private:
     long long m_estimatedLength {0};
     long long m_bytesReceived {0};
     double m_progressValue;
+    bool m_rwsIsMapped {false};
 
 };
 
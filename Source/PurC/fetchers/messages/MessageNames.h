@@ -3306,6 +3306,7 @@ enum class MessageName : uint16_t {
     , SyncMessageReply = 1984
     , InitializeConnection = 1985
     , LegacySessionState = 1986
+    , WebResourceLoader_DidReceiveSharedMemory = 1987
 };
 
 ReceiverName receiverName(MessageName);
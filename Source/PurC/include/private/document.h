@@ -51,6 +51,9 @@ struct pcdoc_travel_attrs_info {
 
 typedef int (*pcdoc_node_cb)(purc_document_t doc, void *node, void *ctxt);
 
+/* the fragment compiled from a markup with slots; see pcdoc_fragment_new() */
+typedef struct pcdoc_fragment *pcdoc_fragment_t;
+
 struct purc_document_ops {
     purc_document_t (*create)(const char *content, size_t length);
     void (*destroy)(purc_document_t doc);
@@ -71,6 +74,17 @@ struct purc_document_ops {
             pcdoc_element_t elem, pcdoc_operation_k op,
             const char *content, size_t length);
 
+    // nullable
+    pcdoc_fragment_t (*new_fragment)(purc_document_t doc,
+            pcdoc_element_t elem, const char **parts, const size_t *lens,
+            size_t nr_slots);
+    // null if `new_fragment` is null
+    pcdoc_node (*insert_fragment)(purc_document_t doc,
+            pcdoc_element_t elem, pcdoc_operation_k op,
+            pcdoc_fragment_t frag, const char **vals, const size_t *lens);
+    // null if `new_fragment` is null
+    void (*delete_fragment)(purc_document_t doc, pcdoc_fragment_t frag);
+
     int (*set_attribute)(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_operation_k op,
             const char *name, const char *val, size_t len);
@@ -167,6 +181,11 @@ struct purc_document {
     struct purc_document_ops *ops;
 
     void *impl;
+
+    /* the contents parsed recently; maintained by the operations */
+    struct pcdoc_content_cache *content_cache;
+    size_t nr_content_hits;
+    size_t nr_content_misses;
 };
 
 typedef enum {
@@ -215,6 +234,32 @@ extern struct purc_document_ops _pcdoc_void_ops WTF_INTERNAL;
 extern struct purc_document_ops _pcdoc_plain_ops WTF_INTERNAL;
 extern struct purc_document_ops _pcdoc_html_ops WTF_INTERNAL;
 
+/*
+ * Compiles the markup made of the nr_slots + 1 parts separated by
+ * the slots into a fragment for the content of elem. Returns NULL and
+ * sets PURC_ERROR_NOT_SUPPORTED if the document type does not support it,
+ * the slots are not all in text nodes or attribute values, or a part
+ * before a slot has a `&` not followed by a `;`.
+ */
+pcdoc_fragment_t
+pcdoc_fragment_new(purc_document_t doc, pcdoc_element_t elem,
+        const char **parts, const size_t *lens, size_t nr_slots);
+
+/*
+ * Fills the slots of the fragment with the values and inserts a copy of
+ * it as pcdoc_element_new_content() does. Returns a void node and
+ * leaves the document unchanged if the values can not be put in the
+ * slots as they are, or elem differs from the element the fragment was
+ * compiled for; the caller should insert the markup text then.
+ */
+pcdoc_node
+pcdoc_element_new_content_from_fragment(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation_k op,
+        pcdoc_fragment_t frag, const char **vals, const size_t *lens);
+
+void
+pcdoc_fragment_delete(purc_document_t doc, pcdoc_fragment_t frag);
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
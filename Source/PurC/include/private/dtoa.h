@@ -0,0 +1,60 @@
+/**
+ * @file dtoa.h
+ * @date 2026/10/18
+ * @brief The header file for the conversions between numbers and strings.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PURC_PRIVATE_DTOA_H
+#define PURC_PRIVATE_DTOA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* the size of the buffer which is long enough for all functions below */
+#define PCUTILS_DTOA_BUFSZ      32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* write the decimal representation of an integer and a terminating null
+   character to buf; returns the number of characters written, excluding
+   the null character. */
+size_t pcutils_u64toa(uint64_t u64, char *buf);
+size_t pcutils_i64toa(int64_t i64, char *buf);
+
+/* write a short representation of a double which reads back as the same
+   double to buf, in the layout of `%.17g`; it may have one or two more
+   digits than the shortest one for a few doubles. Infinities and NaN are
+   written as `Infinity`, `-Infinity`, and `NaN`. Returns the number of
+   characters written, excluding the null character. The output does not
+   depend on the current locale. */
+size_t pcutils_dtoa(double d, char *buf);
+
+/* same as strtod(), but the decimal point is always `.` regardless of the
+   current locale. Plain decimal numbers are converted without calling
+   the C library in most cases; other forms like hexadecimal numbers,
+   infinities and NaN are handed over to strtod(). */
+double pcutils_strtod(const char *str, char **end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* PURC_PRIVATE_DTOA_H */
@@ -137,8 +137,14 @@ struct pcintr_heap {
     purc_atom_t         move_buff;
     pcintr_timer_t     *event_timer;    // 10ms
 
+
+    // the time when the running coroutine got its time slice.
+    struct timespec     slice_begin;
+
     purc_cond_handler   cond_handler;
     unsigned int        keep_alive:1;
+    // whether a coroutine was dispatched to the isolated runners.
+    unsigned int        isolated_runners_used:1;
     double              timestamp;
 };
 
@@ -197,6 +203,15 @@ struct pcintr_stack {
     // the number of stack frames.
     size_t                        nr_frames;
 
+    // the popped normal frames kept for reuse.
+    struct list_head              free_frames;
+    // the number of the popped frames kept.
+    size_t                        nr_free_frames;
+
+    // the values of the constant attributes (struct pcvdom_attr * ->
+    // purc_variant_t); see pcintr_stack_frame_eval_attr_and_content_full().
+    struct pchash_table          *const_attr_vals;
+
     // the pointer to the vDOM tree.
     purc_vdom_t                   vdom;
     purc_document_t               doc;
@@ -220,6 +235,8 @@ struct pcintr_stack {
     uint32_t                      observe_idle:1;
     uint32_t                      terminated:1;
     uint32_t                      inherit:1;
+    /* the VCM being evaluated can be suspended and evaluated again */
+    uint32_t                      vcm_preemptible:1;
 
     // error or except info
     // valid only when except == 1
@@ -258,6 +275,14 @@ struct pcintr_stack {
     pcdoc_element_t               curr_edom_elem;
     pcutils_mraw_t               *mraw;
     pcutils_str_t                *curr_edom_elem_text_content;
+
+    // the contents appended to the same element but not sent to the
+    // renderer yet; see pcintr_util_new_content().
+    pcdoc_element_t               pending_content_elem;
+    struct pcintr_stack_frame    *pending_content_frame;
+    purc_rwstream_t               pending_content;
+    pcrdr_msg_data_type           pending_content_type;
+    bool                          pending_content_no_return;
 };
 
 enum pcintr_coroutine_stage {
@@ -316,6 +341,9 @@ struct pcintr_coroutine {
 
     struct pcintr_stack         stack;  /* stack that holds this coroutine */
 
+    /* containers dropped by the steps, released by the scheduler */
+    struct pcvariant_dying      dying;
+
     enum pcintr_coroutine_stage stage;
     enum pcintr_coroutine_state state;
     int                         waits;  /* FIXME: nr of registered events */
@@ -459,10 +487,15 @@ struct pcintr_stack_frame {
     unsigned int       silently:1;
     unsigned int       must_yield:1;
 
+    // the symbol variables to be made on first use (bit 1 << symbol);
+    // see pcintr_get_symbol_var().
+    unsigned int       lazy_symvals;
+
     enum pcintr_stack_frame_eval_step eval_step;
     enum pcintr_element_step elem_step;
     size_t             eval_attr_pos;
-    pcutils_array_t   *attrs_result;
+    // the buffer is kept when the frame is reused.
+    pcutils_array_t    attrs_result;
 };
 
 struct pcintr_stack_frame_normal {
@@ -544,6 +577,12 @@ void pcintr_stop_coroutine(pcintr_coroutine_t crtn,
 /* resume the specific coroutine */
 void pcintr_resume_coroutine(pcintr_coroutine_t crtn) WTF_INTERNAL;
 
+/* Called at the yield points of long-running operations. If the time slice
+   of the current coroutine expired, make it ready for the next round,
+   set PURC_ERROR_AGAIN and return true; the caller should then stop and
+   leave the state to resume from. */
+bool pcintr_preempt_if_slice_expired(void) WTF_INTERNAL;
+
 void pcintr_check_after_execution(void);
 void pcintr_set_current_co_with_location(pcintr_coroutine_t co,
         const char *file, int line, const char *func);
@@ -751,6 +790,11 @@ pcintr_util_new_content(purc_document_t doc,
         const char *content, size_t len, purc_variant_t data_type,
         bool sync_to_rdr, bool no_return);
 
+/* send the contents appended by pcintr_util_new_content() but not sent
+   to the renderer yet. */
+void
+pcintr_util_send_pending_content(pcintr_stack_t stack);
+
 pcdoc_data_node_t
 pcintr_util_set_data_content(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation_k op,
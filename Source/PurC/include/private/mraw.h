@@ -54,9 +54,22 @@ extern "C" {
         - (sizeof(size_t) % PCUTILS_MEM_ALIGN_STEP))  \
     : sizeof(size_t))
 
+/*
+ * The freed blocks not larger than PCUTILS_MRAW_SMALL_MAX bytes are kept in
+ * one list per size instead of the binary search tree, so allocating and
+ * freeing the nodes of a document are O(1), and allocating a new node is
+ * a pointer bump as long as no node of the same size was freed.
+ */
+#define PCUTILS_MRAW_SMALL_MAX          256
+#define PCUTILS_MRAW_NR_SMALL_LISTS     \
+    (PCUTILS_MRAW_SMALL_MAX / PCUTILS_MEM_ALIGN_STEP + 1)
+
 struct pcutils_mraw {
     pcutils_mem_t *mem;
     pcutils_bst_t *cache;
+
+    /* the freed small blocks; indexed by size / PCUTILS_MEM_ALIGN_STEP */
+    void *small_cache[PCUTILS_MRAW_NR_SMALL_LISTS];
 };
 
 /*
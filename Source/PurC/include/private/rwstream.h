@@ -25,5 +25,23 @@
 #ifndef PURC_PRIVATE_RWSTREAM_H
 #define PURC_PRIVATE_RWSTREAM_H
 
+#include "purc-rwstream.h"
+
+typedef void (*pcrws_cb_release)(void *ctxt);
+
+PCA_EXTERN_C_BEGIN
+
+/*
+ * Creates a read-only and seekable rwstream over an immutable memory block,
+ * e.g., a mapped shared memory segment. The memory is not copied; @release
+ * will be called with @ctxt when the rwstream is destroyed, so that the
+ * owner of the memory can unmap or free it.
+ */
+purc_rwstream_t
+pcrwstream_new_from_readonly_mem(const void *mem, size_t sz,
+        pcrws_cb_release release, void *ctxt);
+
+PCA_EXTERN_C_END
+
 #endif /* not defined PURC_PRIVATE_RWSTREAM_H */
 
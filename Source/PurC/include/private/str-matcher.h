@@ -0,0 +1,56 @@
+/**
+ * @file str-matcher.h
+ * @date 2026/10/18
+ * @brief The header file for the multiple-pattern string matcher.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PURC_PRIVATE_STR_MATCHER_H
+#define PURC_PRIVATE_STR_MATCHER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+struct pcutils_str_matcher;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* create a matcher for nr_patterns non-empty patterns; the patterns are
+   copied, so the caller can release them after this call. */
+struct pcutils_str_matcher *
+pcutils_str_matcher_new(const char **patterns, const size_t *lengths,
+        size_t nr_patterns);
+
+/* destroy a matcher */
+void pcutils_str_matcher_delete(struct pcutils_str_matcher *matcher);
+
+/* find the leftmost match in the first len bytes of str; if several
+   patterns match at the same position, the longest one wins. Returns the
+   start of the match, or NULL if there is no match. idx and len_matched
+   can be NULL. */
+const char *
+pcutils_str_matcher_find(const struct pcutils_str_matcher *matcher,
+        const char *str, size_t len, size_t *idx, size_t *len_matched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* PURC_PRIVATE_STR_MATCHER_H */
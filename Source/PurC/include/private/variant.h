@@ -40,6 +40,11 @@ PCA_EXTERN_C_BEGIN
 #define PCVRNT_FLAG_NOFREE          PCVRNT_FLAG_CONSTANT
 #define PCVRNT_FLAG_EXTRA_SIZE      (0x01 << 1)  // when use extra space
 #define PCVRNT_FLAG_STRING_STATIC   (0x01 << 2)  // make_string_static
+#define PCVRNT_FLAG_STRING_SHARED   (0x01 << 3)  // pcvariant_make_string_shared
+
+/* the max size of a string or a byte sequence stored in the variant */
+#define PCVRNT_SZ_BYTES     (sizeof(long double) > sizeof(void*) * 2 ? \
+                            sizeof(long double) : sizeof(void*) * 2)
 
 #define PVT(t)          (PURC_VARIANT_TYPE##t)
 #define IS_CONTAINER(t) (t == PURC_VARIANT_TYPE_OBJECT || \
@@ -84,6 +89,9 @@ PCA_EXTERN_C_BEGIN
 #define PCVAR_LISTENER_PRE   (0x00)
 #define PCVAR_LISTENER_POST  (0x01)
 
+// the post listener accepts the aggregated change records of a batch
+#define PCVAR_LISTENER_BATCH (0x02)
+
 struct pcvar_listener {
     // the operation in which this listener is intersted.
     pcvar_op_t          op;
@@ -91,7 +99,7 @@ struct pcvar_listener {
     // the context for the listener
     void*               ctxt;
 
-    // flags of the listener; only one flag currently: PRE or POST.
+    // flags of the listener: PRE or POST, and BATCH.
     unsigned int        flags;
 
     // the operation handler
@@ -161,6 +169,12 @@ struct purc_variant {
               - `sz_ptr[0]` stores the length in characters;
               - `sz_ptr[1]` stores the pointer.
 
+           for shared string (PCVRNT_FLAG_STRING_SHARED),
+              - `sz_ptr[0]` stores the size in bytes;
+              - `sz_ptr[1]` stores the pointer in the buffer of the owner;
+              - `extra_data` stores the owner variant instead of
+                 the length in characters.
+
            for exception and atom string,
              - `sz_ptr[0]` should always be 0.
              - `sz_ptr[1]` stores the atom. */
@@ -193,6 +207,13 @@ struct purc_variant {
 
 #define USE_LOOP_BUFFER_FOR_RESERVED    0
 
+// a stack of the containers to be released.
+struct pcvariant_dying {
+    purc_variant_t     *values;
+    size_t              nr;
+    size_t              sz;
+};
+
 struct pcvariant_heap {
     // the constant values.
     struct purc_variant v_undefined;
@@ -211,6 +232,19 @@ struct pcvariant_heap {
 #else
     struct list_head    v_reserved;
 #endif
+
+    // the active batches of change notifications.
+    struct pcvar_batch *batches;
+
+    // the stack of the containers to be released.
+    struct pcvariant_dying  own_dying;
+
+    // the stack the dropped containers are pushed to; not own_dying
+    // if the release is deferred.
+    struct pcvariant_dying *dying;
+
+    // whether a value is being released.
+    bool                releasing;
 };
 
 // internal interfaces for moving variant.
@@ -367,10 +401,42 @@ int pcvariant_set_get_uniqkeys(purc_variant_t set, size_t *nr_keynames,
 ssize_t pcvariant_serialize(char *buf, size_t sz, purc_variant_t val);
 char* pcvariant_serialize_alloc(char *buf, size_t sz, purc_variant_t val);
 
+/* push the containers dropped from now on to dying, so that they are
+   released by pcvariant_release_deferred(), or release them at once if
+   dying is NULL; returns the old stack or NULL */
+struct pcvariant_dying *pcvariant_defer_release(struct pcvariant_dying *dying);
+
+/* release the containers in dying until there is none or the time budget
+   runs out (0 for no limit); returns the number of the remaining ones */
+size_t pcvariant_release_deferred(struct pcvariant_dying *dying,
+        unsigned int budget_ms);
+
+/* release all the containers in dying and the stack itself */
+void pcvariant_release_dying(struct pcvariant_dying *dying);
+
+/* load a JSON document lazily; see purc_variant_load_from_json_stream_ex */
+purc_variant_t pcvariant_load_lazy_json(purc_rwstream_t stream);
+
+/* whether the value is an object loaded lazily */
+bool pcvariant_is_lazy_json(purc_variant_t value);
+
 char* pcvariant_to_string(purc_variant_t v);
 
 purc_variant_t pcvariant_make_object(size_t nr_kvs, ...);
 
+/* Make a string which shares the buffer of the owner without copying:
+   `str` must be in the immutable buffer kept alive by `owner`, and
+   `str[len]` must be a null byte. The owner will be referenced by
+   the new string. A string shorter than PCVRNT_SZ_BYTES will be copied
+   as usual. */
+purc_variant_t
+pcvariant_make_string_shared(purc_variant_t owner, const char *str,
+        size_t len) WTF_INTERNAL;
+
+/* Make the shared string have a private copy of its content, and release
+   the owner. Returns false if out of memory. */
+bool pcvariant_string_unshare(purc_variant_t string) WTF_INTERNAL;
+
 WTF_ATTRIBUTE_PRINTF(1, 2)
 purc_variant_t pcvariant_make_with_printf(const char *fmt, ...);
 
@@ -397,6 +463,33 @@ void pcvariant_on_post_fired(
         purc_variant_t *argv    // the array of all relevant child variants.
         );
 
+/*
+ * Register a post listener which accepts aggregated change records.
+ *
+ * Out of a batch, the handler is called for every change as usual.
+ * In a batch, the changes are recorded, and the handler is called once
+ * for every kind of the operations when the outermost batch ends, with
+ * only one argument, an array of the change records:
+ *  - for an array, the records are [first, count] pairs of the indices;
+ *    consecutive indices are merged into one pair.
+ *  - for other containers, the records are the keys (for an object) or
+ *    the first arguments of the changes.
+ */
+struct pcvar_listener *
+pcvariant_register_batch_listener(purc_variant_t v,
+        pcvar_op_t op, pcvar_op_handler handler, void *ctxt);
+
+/*
+ * Begin a batch of the changes on the container. Returns NULL if there
+ * is no batch listener on the container or on failure; in both cases
+ * the changes are notified one by one. Batches on the same container
+ * can nest; the records are delivered when the outermost one ends.
+ */
+struct pcvar_batch *pcvariant_begin_batch(purc_variant_t ctnr);
+
+/* end a batch; batch can be NULL. */
+void pcvariant_end_batch(struct pcvar_batch *batch);
+
 purc_variant_t pcvariant_set_find (purc_variant_t set, purc_variant_t value);
 
 static inline bool
@@ -286,6 +286,27 @@ purc_document_impl_entity(purc_document_t doc, purc_document_type_k *type);
 PCA_EXPORT unsigned int
 purc_document_delete(purc_document_t doc);
 
+/**
+ * purc_document_get_content_cache_stats:
+ *
+ * Gets the statistics of the cache of parsed contents of a document.
+ *
+ * @doc: The pointer to a document.
+ * @nr_hits: The buffer to return the number of contents found in the cache;
+ *  nullable.
+ * @nr_misses: The buffer to return the number of contents parsed;
+ *  nullable.
+ *
+ * The contents inserted by calling pcdoc_element_new_content() are parsed
+ * once and kept in a small cache of the document, so the same content
+ * inserted again is copied instead of being parsed again.
+ *
+ * Since: 0.9.8
+ */
+PCA_EXPORT void
+purc_document_get_content_cache_stats(purc_document_t doc,
+        size_t *nr_hits, size_t *nr_misses);
+
 typedef enum {
     PCDOC_SPECIAL_ELEM_ROOT = 0,
     PCDOC_SPECIAL_ELEM_HEAD,
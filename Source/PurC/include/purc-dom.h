@@ -186,6 +186,14 @@ pcdom_node_destroy(pcdom_node_t *node);
 pcdom_node_t *
 pcdom_node_destroy_deep(pcdom_node_t *root);
 
+/*
+ * Clones a node and, if deep is true, its descendants in the same document.
+ * Only elements, text and comment nodes can be cloned; the content of
+ * a template element is not cloned.
+ */
+pcdom_node_t *
+pcdom_node_clone(pcdom_node_t *root, bool deep);
+
 const unsigned char *
 pcdom_node_name(pcdom_node_t *node,
                 size_t *len);
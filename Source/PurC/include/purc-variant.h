@@ -2449,6 +2449,33 @@ purc_variant_load_from_json_file(const char* file);
 PCA_EXPORT purc_variant_t
 purc_variant_load_from_json_stream(purc_rwstream_t stream);
 
+/** Do not create the variants of the members until they are accessed. */
+#define PCVRNT_LOAD_OPT_LAZY            0x0001
+
+/**
+ * purc_variant_load_from_json_stream_ex:
+ *
+ * @stream: A purc_rwstream_t stream.
+ * @opts: The loading options, can be 0 or %PCVRNT_LOAD_OPT_LAZY.
+ *
+ * Creates a variant from a stream which contains valid JSON data.
+ *
+ * If %PCVRNT_LOAD_OPT_LAZY is specified and the stream contains a plain
+ * JSON object, the function only builds an index of the text and returns
+ * a native entity which has the same members. A member is created when
+ * it is accessed via the property getter of the native entity; a member
+ * which is an object is another such native entity. Setting or erasing
+ * a member, or calling the getter of the native entity itself,
+ * creates the real object. For other data, the option is ignored.
+ *
+ * Returns: A variant on success, or %PURC_VARIANT_INVALID on failure.
+ *
+ * Since: 0.9.8
+ */
+PCA_EXPORT purc_variant_t
+purc_variant_load_from_json_stream_ex(purc_rwstream_t stream,
+        unsigned int opts);
+
 /**
  * purc_variant_cast_to_int32:
  *
@@ -275,8 +275,8 @@ typedef void (*cb_free_local_data) (void *key, void *local_data);
  *
  *  - `format-double`: This local data contains the format (should be a
  *     pointer to a static string) which will be used to serilize a variant
- *     of double (number) type. If not defined, use the default format
- *     (`%.17g`).
+ *     of double (number) type. If not defined, use a short form which
+ *     reads back as the same double, in the layout of `%.17g`.
  *  - `format-long-double`: This local data contains the format (should be
  *     a pointer to a static string), which will be used to serilize a
  *     variant of long double type. If not defined, use the default format
@@ -33,11 +33,16 @@
 #include "private/instance.h"
 #include "private/utils.h"
 #include "private/variant.h"
+#include "private/runners.h"
 
+#include <stdatomic.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define DEFAULT_RUNNER_NAME     "_self"
+#define ISOLATED_RUNNER_NAME    "_isolated"
 
 static void
 parse_info(const char *org, char **page_type,
@@ -152,6 +157,77 @@ fill_cor_rdr_info(purc_renderer_extra_info *rdr_info, purc_variant_t rdr)
     }
 }
 
+/*
+ * The coroutines loaded or called within `_isolated` share nothing with
+ * their curator but the messages, so they are spread over a pool of
+ * runners named `_isolated_0`, `_isolated_1`, ..., one per online CPU.
+ * The runners are created on demand and each one has its own thread,
+ * scheduler, atoms cache and variable manager; nothing of the current
+ * instance is touched by them.
+ *
+ * The counter is shared by all the instances of the process, so that the
+ * curators in different instances do not all start from `_isolated_0`.
+ */
+static atomic_uint nr_isolated_crtns;
+
+static unsigned int
+nr_isolated_runners(void)
+{
+    long nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return nr_cpus < 1 ? 1 : (unsigned int)nr_cpus;
+}
+
+static const char *
+get_isolated_runner_name(char *buf, size_t sz)
+{
+    unsigned int idx = atomic_fetch_add(&nr_isolated_crtns, 1) %
+        nr_isolated_runners();
+    snprintf(buf, sz, "%s_%u", ISOLATED_RUNNER_NAME, idx);
+    return buf;
+}
+
+/*
+ * Ask the isolated runners of the application to shut down. A runner
+ * stops once it has no coroutine, so the ones still running coroutines
+ * of other curators finish them first. Do not wait for the responses:
+ * a runner which is stopping by itself would never send one.
+ */
+void
+pcintr_shutdown_isolated_runners(void)
+{
+    struct pcinst *inst = pcinst_current();
+    unsigned int nr_runners = nr_isolated_runners();
+
+    for (unsigned int i = 0; i < nr_runners; i++) {
+        char runner_name[PURC_LEN_RUNNER_NAME + 1];
+        char endpoint_name[PURC_LEN_ENDPOINT_NAME + 1];
+
+        snprintf(runner_name, sizeof(runner_name), "%s_%u",
+                ISOLATED_RUNNER_NAME, i);
+        purc_assemble_endpoint_name_ex(PCRDR_LOCALHOST,
+                inst->app_name, runner_name,
+                endpoint_name, sizeof(endpoint_name) - 1);
+
+        purc_atom_t rid = purc_atom_try_string_ex(PURC_ATOM_BUCKET_DEF,
+                endpoint_name);
+        if (rid == 0)
+            continue;
+
+        pcrdr_msg *request = pcrdr_make_request_message(
+                PCRDR_MSG_TARGET_INSTANCE, rid,
+                PCRUN_OPERATION_shutdownInstance,
+                PCRDR_REQUESTID_NORETURN,
+                purc_get_endpoint(NULL),
+                PCRDR_MSG_ELEMENT_TYPE_VOID, NULL,
+                NULL,
+                PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+        if (request) {
+            purc_inst_move_message(rid, request);
+            pcrdr_release_message(request);
+        }
+    }
+}
+
 purc_atom_t
 pcintr_schedule_child_co(purc_vdom_t vdom, purc_atom_t curator,
         const char *runner, const char *rdr_target, purc_variant_t request,
@@ -169,9 +245,16 @@ pcintr_schedule_child_co(purc_vdom_t vdom, purc_atom_t curator,
     struct pcinst *inst = pcinst_current();
     const char *app_name = inst->app_name;
     const char *runner_name = runner;
+    char isolated_name[PURC_LEN_RUNNER_NAME + 1];
     if (!runner || strcmp(runner, DEFAULT_RUNNER_NAME) == 0) {
         runner_name = inst->runner_name;
     }
+    else if (strcmp(runner, ISOLATED_RUNNER_NAME) == 0) {
+        runner_name = get_isolated_runner_name(isolated_name,
+                sizeof(isolated_name));
+        inst->intr_heap->isolated_runners_used = 1;
+        create_runner = true;
+    }
 
     purc_assemble_endpoint_name_ex(PCRDR_LOCALHOST,
             app_name, runner_name,
@@ -215,7 +215,7 @@ on_child_finished(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
         return -1;
 
     int r;
-    r = pcintr_bind_template(frame->error_templates,
+    r = pcintr_bind_template(pcintr_get_error_templates(frame),
             ctxt->type, ctxt->contents);
 
     return r ? -1 : 0;
@@ -555,7 +555,7 @@ on_child_finished(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
     parent_frame = pcintr_stack_frame_get_parent(frame);
 
     int r;
-    r = pcintr_bind_template(parent_frame->except_templates,
+    r = pcintr_bind_template(pcintr_get_except_templates(parent_frame),
             ctxt->type, ctxt->contents);
 
     return r ? -1 : 0;
@@ -136,11 +136,11 @@ static void
 set_attr_val(pcintr_stack_t stack, struct pcintr_stack_frame *frame,
         size_t idx, purc_variant_t val)
 {
-    purc_variant_t v = pcutils_array_get(frame->attrs_result, idx);
+    purc_variant_t v = pcutils_array_get(&frame->attrs_result, idx);
     PURC_VARIANT_SAFE_CLEAR(v);
 
     stack->vcm_eval_pos = idx;
-    pcutils_array_set(frame->attrs_result, idx, val);
+    pcutils_array_set(&frame->attrs_result, idx, val);
     if (val) {
         purc_variant_ref(val);
     }
@@ -591,19 +591,19 @@ attr_found_val(struct pcintr_stack_frame *frame,
             || pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, NOSE_TO_TAIL)) == name) {
         ctxt->nosetotail = 1;
         purc_variant_t val = purc_variant_make_boolean(true);
-        pcutils_array_set(frame->attrs_result, idx, val);
+        pcutils_array_set(&frame->attrs_result, idx, val);
         return 0;
     }
 
     if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, SILENTLY)) == name) {
         purc_variant_t val = purc_variant_make_boolean(true);
-        pcutils_array_set(frame->attrs_result, idx, val);
+        pcutils_array_set(&frame->attrs_result, idx, val);
         return 0;
     }
 
     if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, MUST_YIELD)) == name) {
         purc_variant_t val = purc_variant_make_boolean(true);
-        pcutils_array_set(frame->attrs_result, idx, val);
+        pcutils_array_set(&frame->attrs_result, idx, val);
         return 0;
     }
 
@@ -924,7 +924,7 @@ eval_attr(pcintr_stack_t stack, struct pcintr_stack_frame *frame)
 
     for (; frame->eval_attr_pos < nr_params; frame->eval_attr_pos++) {
         attr = pcutils_array_get(attrs, frame->eval_attr_pos);
-        name = PCHVML_KEYWORD_ATOM(HVML, attr->key);
+        name = attr->key_atom;
         if (strcmp(attr->key, ATTR_NAME_IDD_BY) == 0) {
             val = pcintr_eval_vcm(stack, attr->val, frame->silently);
             set_attr_val(stack, frame, frame->eval_attr_pos, val);
@@ -164,15 +164,15 @@ regist_variant_listener(pcintr_stack_t stack, purc_variant_t observed,
         purc_atom_t op, struct pcvar_listener** listener)
 {
     if (op == pcvariant_atom_grow) {
-        *listener = purc_variant_register_post_listener(observed,
+        *listener = pcvariant_register_batch_listener(observed,
                 PCVAR_OPERATION_GROW, base_variant_msg_listener, stack);
     }
     else if (op == pcvariant_atom_shrink) {
-        *listener = purc_variant_register_post_listener(observed,
+        *listener = pcvariant_register_batch_listener(observed,
                 PCVAR_OPERATION_SHRINK, base_variant_msg_listener, stack);
     }
     else if (op == pcvariant_atom_change) {
-        *listener = purc_variant_register_post_listener(observed,
+        *listener = pcvariant_register_batch_listener(observed,
                 PCVAR_OPERATION_CHANGE, base_variant_msg_listener, stack);
     }
     else {
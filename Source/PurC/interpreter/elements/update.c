@@ -841,7 +841,7 @@ update_variant_tuple(purc_variant_t dst, purc_variant_t src,
 static int
 update_elements(pcintr_stack_t stack,
         purc_variant_t elems, purc_variant_t at, purc_variant_t to,
-        purc_variant_t src,
+        purc_variant_t src, purc_variant_t tpl,
         pcintr_attribute_op with_eval,
         purc_variant_t template_data_type,
         enum hvml_update_op operator);
@@ -1203,6 +1203,10 @@ update_dest(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
         purc_variant_t src, pcintr_attribute_op with_eval, bool individually)
 {
     int ret = -1;
+
+    /* the observers get the changes in one notification */
+    struct pcvar_batch *batch = pcvariant_begin_batch(dest);
+
     enum purc_variant_type type = purc_variant_get_type(dest);
     switch (type) {
     case PURC_VARIANT_TYPE_OBJECT:
@@ -1237,6 +1241,8 @@ update_dest(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
         purc_set_error(PURC_ERROR_NOT_ALLOWED);
         break;
     }
+
+    pcvariant_end_batch(batch);
     return ret;
 }
 
@@ -1279,7 +1285,7 @@ is_no_return()
 
 static int
 update_target_child(pcintr_stack_t stack, pcdoc_element_t target,
-        const char *to, purc_variant_t src,
+        const char *to, purc_variant_t src, purc_variant_t tpl,
         pcintr_attribute_op with_eval, purc_variant_t template_data_type,
         enum hvml_update_op operator)
 {
@@ -1304,8 +1310,16 @@ update_target_child(pcintr_stack_t stack, pcdoc_element_t target,
 
     pcdoc_operation_k op = convert_operation(operator);
     if (op != PCDOC_OP_UNKNOWN) {
-        pcintr_util_new_content(stack->doc, target, op, s, 0,
-                template_data_type, true, is_no_return());
+        pcdoc_node node = { PCDOC_NODE_VOID, { NULL } };
+        if (tpl) {
+            node = pcintr_util_new_content_from_template(stack->doc, target,
+                    op, tpl, src, template_data_type, true, is_no_return());
+        }
+
+        if (node.type == PCDOC_NODE_VOID) {
+            pcintr_util_new_content(stack->doc, target, op, s, 0,
+                    template_data_type, true, is_no_return());
+        }
         if (t)
             free(t);
 
@@ -1433,8 +1447,8 @@ update_target_attr(pcintr_stack_t stack, pcdoc_element_t target,
 static int
 update_target(pcintr_stack_t stack, pcdoc_element_t target,
         purc_variant_t at, purc_variant_t to, purc_variant_t src,
-        pcintr_attribute_op with_eval, purc_variant_t template_data_type,
-        enum hvml_update_op operator)
+        purc_variant_t tpl, pcintr_attribute_op with_eval,
+        purc_variant_t template_data_type, enum hvml_update_op operator)
 {
     const char *s_to = "displace";
     if (to != PURC_VARIANT_INVALID) {
@@ -1447,7 +1461,7 @@ update_target(pcintr_stack_t stack, pcdoc_element_t target,
     }
 
     if (!s_at || strcmp(s_at, AT_KEY_CONTENT) == 0) {
-        return update_target_child(stack, target, s_to, src, with_eval,
+        return update_target_child(stack, target, s_to, src, tpl, with_eval,
                 template_data_type, operator);
     }
     if (strcmp(s_at, AT_KEY_TEXT_CONTENT) == 0) {
@@ -1467,7 +1481,7 @@ update_target(pcintr_stack_t stack, pcdoc_element_t target,
 int
 update_elements(pcintr_stack_t stack,
         purc_variant_t elems, purc_variant_t at, purc_variant_t to,
-        purc_variant_t src,
+        purc_variant_t src, purc_variant_t tpl,
         pcintr_attribute_op with_eval,
         purc_variant_t template_data_type,
         enum hvml_update_op operator)
@@ -1478,7 +1492,7 @@ update_elements(pcintr_stack_t stack,
         target = pcdvobjs_get_element_from_elements(elems, idx++);
         if (!target)
             break;
-        int r = update_target(stack, target, at, to, src, with_eval,
+        int r = update_target(stack, target, at, to, src, tpl, with_eval,
                 template_data_type, operator);
         if (r)
             return -1;
@@ -1559,11 +1573,16 @@ process(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
     purc_variant_t template_data_type  = ctxt->template_data_type;
     int ret = -1;
 
+    /* the content expanded from a template can be inserted by the template */
+    purc_variant_t tpl = PURC_VARIANT_INVALID;
+    if (ctxt->with && purc_variant_is_native(ctxt->with))
+        tpl = ctxt->with;
+
     /* FIXME: what if array of elements? */
     enum purc_variant_type type = purc_variant_get_type(on);
     if (type == PURC_VARIANT_TYPE_NATIVE) {
         if (pcdvobjs_is_elements(on)) {
-            ret = update_elements(&co->stack, on, at, to, src, with_eval,
+            ret = update_elements(&co->stack, on, at, to, src, tpl, with_eval,
                 template_data_type, ctxt->op);
             goto out;
         }
@@ -1591,8 +1610,8 @@ process(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
             pcdoc_element_t elem;
             elem = pcdvobjs_get_element_from_elements(elems, 0);
             if (elem) {
-                ret = update_elements(&co->stack, elems, at, to, src, with_eval,
-                        template_data_type, ctxt->op);
+                ret = update_elements(&co->stack, elems, at, to, src, tpl,
+                        with_eval, template_data_type, ctxt->op);
             }
             purc_variant_unref(elems);
             goto out;
@@ -62,10 +62,16 @@
 #define PCINTR_EXCLAMATION_EVENT_SOURCE       "_eventSource"
 #define PCINTR_EXCLAMATION_EVENT_REQUEST_ID   "_eventRequestId"
 
+struct pcintr_tpl_builder;
+
 struct pcvdom_template {
     struct pcvcm_node            *vcm;
     bool                          to_free;
     purc_variant_t                type;
+
+    // made on the first expansion; see pcintr_template_expansion()
+    struct pcintr_tpl_builder    *builder;
+    bool                          no_builder;
 };
 
 struct pcintr_observer_task {
@@ -434,9 +440,24 @@ int
 pcintr_bind_template(purc_variant_t templates,
         purc_variant_t type, purc_variant_t contents);
 
+// the templates of the frame; made on first call
+purc_variant_t
+pcintr_get_except_templates(struct pcintr_stack_frame *frame);
+purc_variant_t
+pcintr_get_error_templates(struct pcintr_stack_frame *frame);
+
 purc_variant_t
 pcintr_template_expansion(purc_variant_t val);
 
+/* insert the last expansion of the template without parsing it again;
+   returns a void node if the expansion can not be inserted in this way,
+   and the caller should call pcintr_util_new_content() then. */
+pcdoc_node
+pcintr_util_new_content_from_template(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation_k op,
+        purc_variant_t tpl, purc_variant_t expansion,
+        purc_variant_t data_type, bool sync_to_rdr, bool no_return);
+
 purc_variant_t
 pcintr_template_get_type(purc_variant_t val);
 
@@ -502,6 +523,9 @@ pcintr_schedule_child_co_from_string(const char *hvml, purc_atom_t curator,
         const char *runner, const char *rdr_target, purc_variant_t request,
         const char *body_id, bool create_runner);
 
+void
+pcintr_shutdown_isolated_runners(void);
+
 
 /* for bind named variable */
 bool
@@ -63,6 +63,7 @@
 #define ATTR_NAME_IDD_BY    "idd-by"
 #define BUFF_MIN            1024
 #define BUFF_MAX            1024 * 1024 * 4
+#define MAX_FREE_FRAMES     32
 
 static void
 stack_frame_release(struct pcintr_stack_frame *frame)
@@ -91,17 +92,15 @@ stack_frame_release(struct pcintr_stack_frame *frame)
     PURC_VARIANT_SAFE_CLEAR(frame->error_templates);
     PURC_VARIANT_SAFE_CLEAR(frame->elem_id);
 
-    if (frame->attrs_result) {
-        size_t nr_result = pcutils_array_length(frame->attrs_result);
-        for (size_t i = 0; i < nr_result; i++) {
-            purc_variant_t v = pcutils_array_get(frame->attrs_result, i);
-            if (v) {
-                purc_variant_unref(v);
-            }
+    size_t nr_result = pcutils_array_length(&frame->attrs_result);
+    for (size_t i = 0; i < nr_result; i++) {
+        purc_variant_t v = pcutils_array_get(&frame->attrs_result, i);
+        if (v) {
+            purc_variant_unref(v);
         }
-        pcutils_array_destroy(frame->attrs_result, true);
-        frame->attrs_result = NULL;
     }
+    pcutils_array_clean(&frame->attrs_result);
+    frame->lazy_symvals = 0;
 }
 
 static void
@@ -120,6 +119,7 @@ stack_frame_pseudo_destroy(struct pcintr_stack_frame_pseudo *frame_pseudo)
         return;
 
     stack_frame_pseudo_release(frame_pseudo);
+    pcutils_array_destroy(&frame_pseudo->frame.attrs_result, false);
     free(frame_pseudo);
 }
 
@@ -139,6 +139,7 @@ stack_frame_normal_destroy(struct pcintr_stack_frame_normal *frame_normal)
         return;
 
     stack_frame_normal_release(frame_normal);
+    pcutils_array_destroy(&frame_normal->frame.attrs_result, false);
     free(frame_normal);
 }
 
@@ -288,6 +289,18 @@ stack_release(pcintr_stack_t stack)
     }
     PC_ASSERT(stack->nr_frames == 0);
 
+    if (stack->const_attr_vals) {
+        pchash_table_delete(stack->const_attr_vals);
+        stack->const_attr_vals = NULL;
+    }
+
+    list_for_each_entry_safe(p, n, &stack->free_frames, node) {
+        list_del(&p->node);
+        --stack->nr_free_frames;
+        destroy_stack_frame(p);
+    }
+    PC_ASSERT(stack->nr_free_frames == 0);
+
     release_scoped_variables(stack);
 
     pcintr_destroy_observer_list(&stack->intr_observers);
@@ -315,6 +328,11 @@ stack_release(pcintr_stack_t stack)
         stack->vcm_ctxt = NULL;
     }
 
+    if (stack->pending_content) {
+        purc_rwstream_destroy(stack->pending_content);
+        stack->pending_content = NULL;
+    }
+
     if (stack->curr_edom_elem_text_content) {
         pcutils_str_destroy(stack->curr_edom_elem_text_content,
                 stack->mraw, true);
@@ -351,6 +369,13 @@ coroutine_release(pcintr_coroutine_t co)
         struct pcintr_heap *heap = pcintr_get_heap();
         PC_ASSERT(heap && co->owner == heap);
 
+        // release the containers dropped by the steps of the coroutine
+        // while its stack is still alive
+        pcintr_coroutine_t curr = heap->running_coroutine;
+        pcintr_set_current_co(co);
+        pcvariant_release_dying(&co->dying);
+        pcintr_set_current_co(curr);
+
         stack_release(&co->stack);
         pcvdom_document_unref(co->vdom);
 
@@ -437,6 +462,7 @@ static void
 stack_init(pcintr_stack_t stack)
 {
     list_head_init(&stack->frames);
+    list_head_init(&stack->free_frames);
     list_head_init(&stack->intr_observers);
     list_head_init(&stack->hvml_observers);
     stack->scoped_variables = RB_ROOT;
@@ -677,7 +703,15 @@ pop_stack_frame(pcintr_stack_t stack)
         case STACK_FRAME_TYPE_NORMAL:
             frame_normal = container_of(frame,
                     struct pcintr_stack_frame_normal, frame);
-            stack_frame_normal_destroy(frame_normal);
+            if (stack->nr_free_frames < MAX_FREE_FRAMES) {
+                // keep the frame for the next push
+                stack_frame_normal_release(frame_normal);
+                list_add(&frame->node, &stack->free_frames);
+                ++stack->nr_free_frames;
+            }
+            else {
+                stack_frame_normal_destroy(frame_normal);
+            }
             break;
         case STACK_FRAME_TYPE_PSEUDO:
             frame_pseudo = container_of(frame,
@@ -784,42 +818,58 @@ init_symvals_with_vals(struct pcintr_stack_frame *frame)
     if (frame->type == STACK_FRAME_TYPE_PSEUDO)
         return 0;
 
-    // $0%
-    if (init_percent_symval(frame))
-        return -1;
+    // $0% and $0! are made when they are used first time
+    frame->lazy_symvals = (1U << PURC_SYMBOL_VAR_PERCENT_SIGN) |
+        (1U << PURC_SYMBOL_VAR_EXCLAMATION);
 
     // $0@
     if (init_at_symval(frame))
         return -1;
 
-    // $0!
-    if (init_exclamation_symval(frame))
-        return -1;
+    return 0;
+}
+
+static int
+make_lazy_symval(struct pcintr_stack_frame *frame,
+        enum purc_symbol_var symbol)
+{
+    frame->lazy_symvals &= ~(1U << symbol);
+
+    switch (symbol) {
+    case PURC_SYMBOL_VAR_PERCENT_SIGN:
+        return init_percent_symval(frame);
+    case PURC_SYMBOL_VAR_EXCLAMATION:
+        return init_exclamation_symval(frame);
+    default:
+        break;
+    }
 
     return 0;
 }
 
+/* the templates are made when they are bound first time */
+purc_variant_t
+pcintr_get_except_templates(struct pcintr_stack_frame *frame)
+{
+    if (frame->except_templates == PURC_VARIANT_INVALID)
+        frame->except_templates = purc_variant_make_object_0();
+    return frame->except_templates;
+}
+
+purc_variant_t
+pcintr_get_error_templates(struct pcintr_stack_frame *frame)
+{
+    if (frame->error_templates == PURC_VARIANT_INVALID)
+        frame->error_templates = purc_variant_make_object_0();
+    return frame->error_templates;
+}
+
 static int
 init_stack_frame(pcintr_stack_t stack, struct pcintr_stack_frame* frame)
 {
     frame->owner           = stack;
     frame->silently        = 0;
     frame->must_yield      = 0;
-
-    frame->except_templates = purc_variant_make_object_0();
-    frame->error_templates  = purc_variant_make_object_0();
-
-    if (frame->except_templates == PURC_VARIANT_INVALID ||
-            frame->error_templates == PURC_VARIANT_INVALID)
-    {
-        return -1;
-    }
-
-    frame->attrs_result = pcutils_array_create();
-    if (!frame->attrs_result) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return -1;
-    }
     return 0;
 }
 
@@ -948,11 +998,25 @@ static struct pcintr_stack_frame_normal*
 stack_frame_normal_create(pcintr_stack_t stack)
 {
     struct pcintr_stack_frame_normal *frame_normal;
-    frame_normal = (struct pcintr_stack_frame_normal*)calloc(1,
-            sizeof(*frame_normal));
-    if (!frame_normal) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return NULL;
+    if (stack->nr_free_frames > 0) {
+        struct list_head *head = stack->free_frames.next;
+        list_del(head);
+        --stack->nr_free_frames;
+
+        // reset the frame but keep the buffer of the attribute results
+        frame_normal = container_of(head,
+                struct pcintr_stack_frame_normal, frame.node);
+        pcutils_array_t attrs_result = frame_normal->frame.attrs_result;
+        memset(frame_normal, 0, sizeof(*frame_normal));
+        frame_normal->frame.attrs_result = attrs_result;
+    }
+    else {
+        frame_normal = (struct pcintr_stack_frame_normal*)calloc(1,
+                sizeof(*frame_normal));
+        if (!frame_normal) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return NULL;
+        }
     }
 
     struct pcintr_stack_frame *frame = &frame_normal->frame;
@@ -1059,9 +1123,8 @@ walk_attr(void *key, void *val, void *ud)
     struct pcvdom_element *element = data->element;
     PC_ASSERT(element);
 
-    purc_atom_t atom = PCHVML_KEYWORD_ATOM(HVML, attr->key);
     // NOTE: we only dispatch those keyworded-attr to caller
-    return data->cb(frame, element, atom, attr, data->ud);
+    return data->cb(frame, element, attr->key_atom, attr, data->ud);
 }
 
 int
@@ -1290,6 +1353,8 @@ on_popping(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
             insert_cached_text_node(frame->owner->doc, !stack->inherit);
         }
         ok = frame->ops.on_popping(&co->stack, frame->ctxt);
+        if (ok && frame == stack->pending_content_frame)
+            pcintr_util_send_pending_content(stack);
         if (co->stack.exited)
             PC_ASSERT(ok);
     }
@@ -2018,6 +2083,11 @@ purc_run(purc_cond_handler handler)
     purc_runloop_set_idle_func(runloop, pcintr_schedule, inst);
     purc_runloop_run();
 
+    if (heap->isolated_runners_used) {
+        pcintr_shutdown_isolated_runners();
+        heap->isolated_runners_used = 0;
+    }
+
     return 0;
 }
 
@@ -2407,6 +2477,118 @@ out:
     return false;
 }
 
+/*
+ * The builder of a template whose content is a string or a concatenation
+ * of strings and expressions. It keeps the static parts and the values of
+ * the expressions (the slots) of the last expansion, so the expansion can
+ * be inserted into the document by filling a fragment parsed once instead
+ * of parsing the expanded markup again.
+ */
+struct pcintr_tpl_builder {
+    size_t                        nr_slots;
+
+    // nr_slots + 1 static parts; owned by the vcm tree
+    const char                  **parts;
+    size_t                       *part_lens;
+
+    // the expressions and their values of the last expansion
+    struct pcvcm_node           **slots;
+    char                        **vals;
+    size_t                       *val_lens;
+
+    // the last expansion
+    purc_variant_t                last;
+
+    // the fragment compiled for the document
+    purc_document_t               doc;
+    pcdoc_fragment_t              frag;
+    bool                          no_frag;
+};
+
+static void
+tpl_builder_destroy(struct pcintr_tpl_builder *builder)
+{
+    if (builder->frag)
+        pcdoc_fragment_delete(builder->doc, builder->frag);
+    if (builder->doc)
+        purc_document_unref(builder->doc);
+
+    if (builder->vals) {
+        for (size_t i = 0; i < builder->nr_slots; i++)
+            free(builder->vals[i]);
+    }
+    PURC_VARIANT_SAFE_CLEAR(builder->last);
+
+    free(builder->parts);
+    free(builder->part_lens);
+    free(builder->slots);
+    free(builder->vals);
+    free(builder->val_lens);
+    free(builder);
+}
+
+static struct pcintr_tpl_builder *
+tpl_builder_create(struct pcvcm_node *vcm)
+{
+    size_t nr_children = 1;
+    struct pcvcm_node *child = NULL;
+
+    if (vcm->type == PCVCM_NODE_TYPE_FUNC_CONCAT_STRING) {
+        nr_children = pcvcm_node_children_count(vcm);
+        child = pcvcm_node_first_child(vcm);
+    }
+    else if (vcm->type != PCVCM_NODE_TYPE_STRING) {
+        return NULL;
+    }
+
+    struct pcintr_tpl_builder *builder = calloc(1, sizeof(*builder));
+    if (builder == NULL)
+        return NULL;
+
+    /* at most one static part before and after every expression */
+    builder->parts = calloc(nr_children + 1, sizeof(char *));
+    builder->part_lens = calloc(nr_children + 1, sizeof(size_t));
+    builder->slots = calloc(nr_children, sizeof(struct pcvcm_node *));
+    builder->vals = calloc(nr_children, sizeof(char *));
+    builder->val_lens = calloc(nr_children, sizeof(size_t));
+    if (builder->parts == NULL || builder->part_lens == NULL ||
+            builder->slots == NULL || builder->vals == NULL ||
+            builder->val_lens == NULL)
+        goto failed;
+
+    builder->parts[0] = "";
+    if (child == NULL) {
+        builder->parts[0] = (const char *)vcm->sz_ptr[1];
+        builder->part_lens[0] = vcm->sz_ptr[0];
+        return builder;
+    }
+
+    /* the adjacent strings are joined by the parser already */
+    for (; child; child = (struct pcvcm_node *)pctree_node_next(
+                &child->tree_node)) {
+        size_t n = builder->nr_slots;
+        if (child->type == PCVCM_NODE_TYPE_STRING &&
+                builder->part_lens[n] == 0) {
+            builder->parts[n] = (const char *)child->sz_ptr[1];
+            builder->part_lens[n] = child->sz_ptr[0];
+        }
+        else if (child->type == PCVCM_NODE_TYPE_STRING) {
+            goto failed;
+        }
+        else {
+            builder->slots[n] = child;
+            builder->nr_slots++;
+            builder->parts[n + 1] = "";
+        }
+    }
+
+    return builder;
+
+failed:
+    tpl_builder_destroy(builder);
+    return NULL;
+}
+
 static struct pcvdom_template*
 template_create(void)
 {
@@ -2426,6 +2608,12 @@ template_cleaner(struct pcvdom_template *tpl)
     if (!tpl)
         return;
 
+    if (tpl->builder) {
+        tpl_builder_destroy(tpl->builder);
+        tpl->builder = NULL;
+    }
+    tpl->no_builder = false;
+
     if (tpl->vcm && tpl->to_free) {
         pcvcm_node_destroy(tpl->vcm);
     }
@@ -2672,6 +2860,7 @@ pcintr_set_symbol_var(struct pcintr_stack_frame *frame,
     purc_variant_ref(val);
     PURC_VARIANT_SAFE_CLEAR(frame->symbol_vars[symbol]);
     frame->symbol_vars[symbol] = val;
+    frame->lazy_symvals &= ~(1U << symbol);
 
     return 0;
 }
@@ -2684,6 +2873,10 @@ pcintr_get_symbol_var(struct pcintr_stack_frame *frame,
     PC_ASSERT(symbol >= 0);
     PC_ASSERT(symbol < PURC_SYMBOL_VAR_MAX);
 
+    if ((frame->lazy_symvals & (1U << symbol)) &&
+            make_lazy_symval(frame, symbol))
+        return PURC_VARIANT_INVALID;
+
     return frame->symbol_vars[symbol];
 }
 
@@ -3225,34 +3418,65 @@ template_walker(struct pcvcm_node *vcm, void *ctxt)
     purc_variant_t v = pcvcm_eval(vcm, stack, false);
     PC_ASSERT(v != PURC_VARIANT_INVALID);
 
-    if (purc_variant_is_string(v)) {
-        const char *s = purc_variant_get_string_const(v);
+    /* the string is immutable, no need to copy it */
+    ud->val = v;
+    return 0;
+}
+
+static purc_variant_t
+tpl_builder_expand(struct pcintr_tpl_builder *builder, pcintr_stack_t stack)
+{
+    size_t total = 0;
 
-        size_t chunk = 128;
-        struct pcutils_stringbuilder sb;
-        pcutils_stringbuilder_init(&sb, chunk);
-        int n = pcutils_stringbuilder_snprintf(&sb, "%s", s);
-        if (n < 0 || (size_t)n != strlen(s)) {
-            pcutils_stringbuilder_reset(&sb);
-            purc_variant_unref(v);
-            ud->r = -1;
-            return -1;
+    for (size_t i = 0; i < builder->nr_slots; i++) {
+        purc_variant_t v = pcvcm_eval(builder->slots[i], stack, false);
+        if (v == PURC_VARIANT_INVALID)
+            return PURC_VARIANT_INVALID;
+
+        char *buf = NULL;
+        ssize_t n = purc_variant_stringify_alloc(&buf, v);
+        purc_variant_unref(v);
+        if (n < 0) {
+            free(buf);
+            return PURC_VARIANT_INVALID;
         }
 
-        char *ssv = pcutils_stringbuilder_build(&sb);
-        if (ssv) {
-            ud->val = purc_variant_make_string_reuse_buff(ssv, strlen(ssv), true);
-            PC_ASSERT(v);
+        free(builder->vals[i]);
+        builder->vals[i] = buf;
+        builder->val_lens[i] = (size_t)n;
+        total += (size_t)n;
+    }
+
+    for (size_t i = 0; i <= builder->nr_slots; i++)
+        total += builder->part_lens[i];
+
+    char *str = malloc(total + 1);
+    if (str == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    char *p = str;
+    for (size_t i = 0; i <= builder->nr_slots; i++) {
+        memcpy(p, builder->parts[i], builder->part_lens[i]);
+        p += builder->part_lens[i];
+        if (i < builder->nr_slots) {
+            memcpy(p, builder->vals[i], builder->val_lens[i]);
+            p += builder->val_lens[i];
         }
-        pcutils_stringbuilder_reset(&sb);
     }
-    else {
-        ud->val = v;
-        purc_variant_ref(ud->val);
+    *p = 0;
+
+    purc_variant_t v = purc_variant_make_string_reuse_buff(str,
+            total + 1, false);
+    if (v == PURC_VARIANT_INVALID) {
+        free(str);
+        return PURC_VARIANT_INVALID;
     }
 
-    purc_variant_unref(v);
-    return 0;
+    PURC_VARIANT_SAFE_CLEAR(builder->last);
+    builder->last = purc_variant_ref(v);
+    return v;
 }
 
 purc_variant_t
@@ -3261,6 +3485,19 @@ pcintr_template_expansion(purc_variant_t val)
     pcintr_stack_t stack = pcintr_get_stack();
     PC_ASSERT(stack);
 
+    if (check_template_variant(val))
+        return PURC_VARIANT_INVALID;
+
+    struct pcvdom_template *tpl;
+    tpl = (struct pcvdom_template*)purc_variant_native_get_entity(val);
+    if (tpl->builder == NULL && !tpl->no_builder && tpl->vcm) {
+        tpl->builder = tpl_builder_create(tpl->vcm);
+        tpl->no_builder = (tpl->builder == NULL);
+    }
+
+    if (tpl->builder)
+        return tpl_builder_expand(tpl->builder, stack);
+
     struct template_walk_data ud = {
         .stack        = stack,
         .r            = 0,
@@ -3414,17 +3651,86 @@ pcintr_util_new_text_content(purc_document_t doc, pcdoc_element_t elem,
     return 0;
 }
 
-pcdoc_node
-pcintr_util_new_content(purc_document_t doc,
-        pcdoc_element_t elem, pcdoc_operation_k op,
-        const char *content, size_t len, purc_variant_t data_type,
-        bool sync_to_rdr, bool no_return)
+#define MAX_PENDING_CONTENT     (1024 * 1024)
+
+void
+pcintr_util_send_pending_content(pcintr_stack_t stack)
 {
-    pcdoc_node node;
-    insert_cached_text_node(doc, sync_to_rdr);
+    purc_rwstream_t out = stack->pending_content;
+    if (out == NULL)
+        return;
 
-    node = pcdoc_element_new_content(doc, elem, op, content, len);
+    /* detach the contents first: sending a request flushes them again */
+    pcdoc_element_t elem = stack->pending_content_elem;
+    stack->pending_content = NULL;
+    stack->pending_content_elem = NULL;
+    stack->pending_content_frame = NULL;
+
+    /* the stream may be rewound to drop a content failed to serialize */
+    size_t sz_content = (size_t)purc_rwstream_tell(out);
+    char *p = (char*)purc_rwstream_get_mem_buffer(out, NULL);
+    if (sz_content > 0) {
+        p[sz_content] = 0;
+        const char *request_id = stack->pending_content_no_return ?
+            PCINTR_RDR_NORETURN_REQUEST_ID : NULL;
+        pcintr_rdr_send_dom_req_simple_raw(stack,
+                PCRDR_K_OPERATION_APPEND, request_id, elem, NULL,
+                stack->pending_content_type, p, sz_content);
+    }
+    purc_rwstream_destroy(out);
+}
+
+/*
+ * The contents appended to the same element one after another, for example
+ * by an `update` in an `iterate`, are serialized into one buffer and sent to
+ * the renderer in one request, when the frame of the parent element pops,
+ * when another request is sent to the renderer, or when the coroutine stops
+ * running. The document itself is changed at once.
+ */
+static purc_rwstream_t
+pending_content_stream(pcintr_stack_t stack, pcdoc_element_t elem,
+        pcdoc_operation_k op, pcrdr_msg_data_type type, bool no_return)
+{
+    struct pcintr_stack_frame *frame = pcintr_stack_get_bottom_frame(stack);
+    struct pcintr_stack_frame *parent = NULL;
+    if (frame)
+        parent = pcintr_stack_frame_get_parent(frame);
+
+    if (stack->pending_content) {
+        off_t sz_content = purc_rwstream_tell(stack->pending_content);
+        if (op == PCDOC_OP_APPEND && parent &&
+                stack->pending_content_elem == elem &&
+                stack->pending_content_frame == parent &&
+                stack->pending_content_type == type &&
+                stack->pending_content_no_return == no_return &&
+                sz_content < MAX_PENDING_CONTENT)
+            return stack->pending_content;
+
+        pcintr_util_send_pending_content(stack);
+    }
+
+    /* the contents made before the page loaded are not sent at all */
+    if (op != PCDOC_OP_APPEND || parent == NULL ||
+            (stack->co->stage != CO_STAGE_OBSERVING && !stack->inherit))
+        return NULL;
 
+    stack->pending_content = purc_rwstream_new_buffer(BUFF_MIN, BUFF_MAX);
+    if (stack->pending_content) {
+        stack->pending_content_elem = elem;
+        stack->pending_content_frame = parent;
+        stack->pending_content_type = type;
+        stack->pending_content_no_return = no_return;
+    }
+
+    return stack->pending_content;
+}
+
+/* send the new content to the renderer */
+static void
+sync_new_content(purc_document_t doc, pcdoc_element_t elem,
+        pcdoc_operation_k op, pcdoc_node node, purc_variant_t data_type,
+        bool no_return)
+{
     pcrdr_msg_data_type type = doc->def_text_type;
     if (data_type) {
         /* use the type from archetype `type` attribute */
@@ -3433,14 +3739,17 @@ pcintr_util_new_content(purc_document_t doc,
     }
 
     pcintr_stack_t stack = pcintr_get_stack();
-    if (sync_to_rdr && node.type != PCDOC_NODE_VOID &&
-            stack && stack->co->target_page_handle) {
+    if (stack && stack->co->target_page_handle) {
 
         unsigned opt = 0;
-        purc_rwstream_t out = NULL;
-        out = purc_rwstream_new_buffer(BUFF_MIN, BUFF_MAX);
-        if (out == NULL) {
-            goto out;
+        purc_rwstream_t out;
+        out = pending_content_stream(stack, elem, op, type, no_return);
+        bool pending = (out != NULL);
+        if (!pending) {
+            out = purc_rwstream_new_buffer(BUFF_MIN, BUFF_MAX);
+            if (out == NULL) {
+                return;
+            }
         }
 
         opt |= PCDOC_SERIALIZE_OPT_UNDEF;
@@ -3448,11 +3757,20 @@ pcintr_util_new_content(purc_document_t doc,
         opt |= PCDOC_SERIALIZE_OPT_WITHOUT_TEXT_INDENT;
         opt |= PCDOC_SERIALIZE_OPT_FULL_DOCTYPE;
         opt |= PCDOC_SERIALIZE_OPT_WITH_HVML_HANDLE;
+        off_t pos = pending ? purc_rwstream_tell(out) : 0;
         int sret = pcdoc_serialize_descendants_to_stream(doc, node.elem,
         opt, out);
+        if (pending) {
+            if (0 != sret) {
+                purc_rwstream_seek(out, pos, SEEK_SET);
+                pcintr_util_send_pending_content(stack);
+            }
+            return;
+        }
+
         if (0 != sret) {
             purc_rwstream_destroy(out);
-            goto out;
+            return;
         }
 
         size_t sz_content = 0;
@@ -3463,6 +3781,71 @@ pcintr_util_new_content(purc_document_t doc,
                 request_id, elem, NULL, type, p, sz_content);
         purc_rwstream_destroy(out);
     }
+}
+
+pcdoc_node
+pcintr_util_new_content(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation_k op,
+        const char *content, size_t len, purc_variant_t data_type,
+        bool sync_to_rdr, bool no_return)
+{
+    pcdoc_node node;
+    insert_cached_text_node(doc, sync_to_rdr);
+
+    node = pcdoc_element_new_content(doc, elem, op, content, len);
+    if (sync_to_rdr && node.type != PCDOC_NODE_VOID)
+        sync_new_content(doc, elem, op, node, data_type, no_return);
+
+    return node;
+}
+
+pcdoc_node
+pcintr_util_new_content_from_template(purc_document_t doc,
+        pcdoc_element_t elem, pcdoc_operation_k op,
+        purc_variant_t tpl, purc_variant_t expansion,
+        purc_variant_t data_type, bool sync_to_rdr, bool no_return)
+{
+    pcdoc_node node = { PCDOC_NODE_VOID, { NULL } };
+
+    if (!purc_variant_is_native(tpl) ||
+            purc_variant_native_get_ops(tpl) != &ops_tpl)
+        goto out;
+
+    struct pcvdom_template *t;
+    t = (struct pcvdom_template*)purc_variant_native_get_entity(tpl);
+    struct pcintr_tpl_builder *builder = t->builder;
+    if (builder == NULL || builder->last != expansion)
+        goto out;
+
+    if (builder->doc != doc) {
+        if (builder->frag)
+            pcdoc_fragment_delete(builder->doc, builder->frag);
+        if (builder->doc)
+            purc_document_unref(builder->doc);
+        builder->frag = NULL;
+        builder->doc = purc_document_ref(doc);
+        builder->no_frag = false;
+    }
+
+    if (builder->frag == NULL && !builder->no_frag) {
+        /* the markup is parsed in the context of the first target */
+        builder->frag = pcdoc_fragment_new(doc, elem, builder->parts,
+                builder->part_lens, builder->nr_slots);
+        if (builder->frag == NULL) {
+            builder->no_frag = true;
+            purc_clr_error();
+        }
+    }
+
+    if (builder->frag == NULL)
+        goto out;
+
+    insert_cached_text_node(doc, sync_to_rdr);
+
+    node = pcdoc_element_new_content_from_fragment(doc, elem, op,
+            builder->frag, (const char **)builder->vals, builder->val_lens);
+    if (sync_to_rdr && node.type != PCDOC_NODE_VOID)
+        sync_new_content(doc, elem, op, node, data_type, no_return);
 
 out:
     return node;
@@ -3545,6 +3928,75 @@ pcintr_is_variable_token(const char *str)
     return pcregex_is_match(HVML_VARIABLE_REGEX, str);
 }
 
+/* whether the value of the VCM tree is a scalar literal */
+static inline bool
+is_const_scalar(struct pcvcm_node *node)
+{
+    switch (node->type) {
+    case PCVCM_NODE_TYPE_UNDEFINED:
+    case PCVCM_NODE_TYPE_STRING:
+    case PCVCM_NODE_TYPE_NULL:
+    case PCVCM_NODE_TYPE_BOOLEAN:
+    case PCVCM_NODE_TYPE_NUMBER:
+    case PCVCM_NODE_TYPE_LONG_INT:
+    case PCVCM_NODE_TYPE_ULONG_INT:
+    case PCVCM_NODE_TYPE_LONG_DOUBLE:
+        return true;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+static void
+release_const_attr_val(void *val)
+{
+    purc_variant_unref((purc_variant_t)val);
+}
+
+/*
+ * The value of a constant attribute is evaluated once for a coroutine,
+ * and the scalar is shared by all executions of the element. The vDOM
+ * may be shared by the coroutines of different instances, so the values
+ * are kept by the stack instead of the vDOM.
+ *
+ * Only the attributes of the vDOM of the coroutine are cached: a vDOM
+ * loaded at runtime (e.g. by `define` or `load`) may be released before
+ * the coroutine exits, and the address of an attribute might be reused.
+ */
+static purc_variant_t
+eval_const_attr(pcintr_stack_t stack, struct pcvdom_attr *attr)
+{
+    purc_variant_t val;
+
+    pchash_entry_t entry = NULL;
+    if (stack->const_attr_vals) {
+        entry = pchash_table_lookup_entry(stack->const_attr_vals, attr);
+        if (entry) {
+            val = (purc_variant_t)pchash_entry_val(entry);
+            return purc_variant_ref(val);
+        }
+    }
+
+    if (attr->parent == NULL ||
+            pcvdom_document_from_node(&attr->parent->node) != stack->vdom)
+        return pcvcm_eval(attr->val, stack, false);
+
+    if (stack->const_attr_vals == NULL) {
+        stack->const_attr_vals = pchash_kptr_table_new(0,
+                NULL, NULL, NULL, release_const_attr_val);
+        if (stack->const_attr_vals == NULL)
+            return pcvcm_eval(attr->val, stack, false);
+    }
+
+    val = pcvcm_eval(attr->val, stack, false);
+    if (val && pchash_table_insert(stack->const_attr_vals, attr, val) == 0)
+        purc_variant_ref(val);
+
+    return val;
+}
+
 int
 pcintr_stack_frame_eval_attr_and_content_full(pcintr_stack_t stack,
         struct pcintr_stack_frame *frame, before_eval_attr_fn before_eval_attr,
@@ -3562,14 +4014,7 @@ pcintr_stack_frame_eval_attr_and_content_full(pcintr_stack_t stack,
     struct pcvdom_attr *attr = NULL;
     purc_variant_t val;
 
-    bool is_operation_tag = false;
-    const char *name = elem->tag_name;
-    const struct pchvml_tag_entry* entry = pchvml_tag_static_search(name,
-            strlen(name));
-    if (entry &&
-            (entry->cats & (PCHVML_TAGCAT_TEMPLATE | PCHVML_TAGCAT_VERB))) {
-        is_operation_tag = true;
-    }
+    bool is_operation_tag = elem->is_operation;
 
     while (frame->eval_step != STACK_FRAME_EVAL_STEP_DONE) {
         switch (frame->eval_step) {
@@ -3585,14 +4030,22 @@ pcintr_stack_frame_eval_attr_and_content_full(pcintr_stack_t stack,
                 if (!attr->val) {
                     val = purc_variant_make_undefined();
                 }
+                else if (is_const_scalar(attr->val)) {
+                    val = eval_const_attr(stack, attr);
+                }
                 else if (stack->vcm_ctxt) {
+                    // a long evaluation may be preempted here and resumed
+                    // by the next step with PURC_ERROR_AGAIN.
+                    stack->vcm_preemptible = 1;
                     val = pcvcm_eval_again(attr->val, stack, frame->silently,
                             stack->timeout);
                     stack->timeout = false;
                 }
                 else {
+                    stack->vcm_preemptible = 1;
                     val = pcvcm_eval(attr->val, stack, frame->silently);
                 }
+                stack->vcm_preemptible = 0;
                 ret = purc_get_last_error();
                 if (!val) {
                     goto out;
@@ -3617,7 +4070,7 @@ pcintr_stack_frame_eval_attr_and_content_full(pcintr_stack_t stack,
                         frame->elem_id = purc_variant_ref(val);
                     }
                 }
-                pcutils_array_set(frame->attrs_result, frame->eval_attr_pos,
+                pcutils_array_set(&frame->attrs_result, frame->eval_attr_pos,
                         val);
             }
             if (ignore_content) {
@@ -3642,6 +4095,7 @@ pcintr_stack_frame_eval_attr_and_content_full(pcintr_stack_t stack,
                 struct pcvdom_content *content = PCVDOM_CONTENT_FROM_NODE(node);
                 struct pcvcm_node *vcm = content->vcm;
 
+                stack->vcm_preemptible = 1;
                 if (stack->vcm_ctxt) {
                     val = pcvcm_eval_again(vcm, stack, frame->silently,
                             stack->timeout);
@@ -3650,6 +4104,7 @@ pcintr_stack_frame_eval_attr_and_content_full(pcintr_stack_t stack,
                 else {
                     val = pcvcm_eval(vcm, stack, frame->silently);
                 }
+                stack->vcm_preemptible = 0;
                 ret = purc_get_last_error();
                 if (!val) {
                     goto out;
@@ -3697,9 +4152,8 @@ pcintr_walk_attrs(struct pcintr_stack_frame *frame,
     size_t nr = pcutils_array_length(element->attrs);
     for (size_t i = 0; i < nr; i++) {
         struct pcvdom_attr *attr = pcutils_array_get(element->attrs, i);
-        purc_variant_t val = pcutils_array_get(frame->attrs_result, i);
-        purc_atom_t name = PCHVML_KEYWORD_ATOM(HVML, attr->key);
-        int r = cb(frame, element, name, val, attr, ud);
+        purc_variant_t val = pcutils_array_get(&frame->attrs_result, i);
+        int r = cb(frame, element, attr->key_atom, val, attr, ud);
         if (r) {
             return r;
         }
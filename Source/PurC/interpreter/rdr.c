@@ -42,11 +42,12 @@
 #define LAYOUT_STYLE_KEY        "layoutStyle"
 #define TOOLKIT_STYLE_KEY       "toolkitStyle"
 
-#define BUFF_MIN                1024
-#define BUFF_MAX                1024 * 1024 * 4
 #define LEN_BUFF_LONGLONGINT    128
 
 #define DEF_LEN_ONE_WRITE       1024 * 10
+#define MAX_LEN_ONE_WRITE       1024 * 1024
+#define NR_WRITES_IN_FLIGHT     8
+#define WAIT_WRITE_TIMEOUT      10              // ms
 
 #define RDR_KEY_METHOD          "method"
 #define RDR_KEY_ARG             "arg"
@@ -951,111 +952,175 @@ out:
     return ret;
 }
 
-static pcrdr_msg *
-rdr_page_control_load_large_page(struct pcrdr_conn *conn,
-        pcrdr_msg_target target, uint64_t target_value,
-        pcrdr_msg_data_type data_type,
-        const char *doc_content, size_t len_content)
+/*
+ * The writer for a large page. The document is serialized straight into
+ * the buffer of the writer, and the content is sent to the renderer in
+ * chunks by `writeBegin` and `writeMore` requests as the buffer fills up.
+ * The writer does not wait for the response of every chunk: up to
+ * NR_WRITES_IN_FLIGHT chunks can be sent before the first one is
+ * acknowledged, and the size of the chunks doubles from DEF_LEN_ONE_WRITE
+ * up to MAX_LEN_ONE_WRITE. The last chunk is sent by a `writeEnd` request
+ * after all others are acknowledged.
+ */
+struct page_writer {
+    struct pcrdr_conn          *conn;
+    pcrdr_msg_target            target;
+    uint64_t                    target_value;
+    pcrdr_msg_data_type         data_type;
+
+    char                       *buf;
+    size_t                      len_buf;
+    size_t                      sz_buf;
+
+    // the size of the next chunk
+    size_t                      len_chunk;
+    // the number of the chunks sent
+    size_t                      nr_chunks;
+    // the number of the chunks not acknowledged yet
+    size_t                      nr_in_flight;
+
+    bool                        failed;
+};
+
+static int
+on_page_chunk_written(pcrdr_conn* conn,
+        const char *request_id, int state,
+        void *context, const pcrdr_msg *response_msg)
 {
-    pcrdr_msg *response_msg = NULL;
-    pcrdr_msg_element_type element_type = PCRDR_MSG_ELEMENT_TYPE_VOID;
-    purc_variant_t data = PURC_VARIANT_INVALID;
-    size_t len_wrotten;
-    size_t len_to_write = 0;
+    UNUSED_PARAM(conn);
+    UNUSED_PARAM(request_id);
 
-    // writeBegin
-    const char *start = doc_content;
-    const char *end;
-    pcutils_string_check_utf8_len(start, DEF_LEN_ONE_WRITE, NULL, &end);
-    if (end > start) {
-        len_to_write = end - start;
+    struct page_writer *writer = context;
+    writer->nr_in_flight--;
 
-        data = purc_variant_make_string_static(start, false);
-        len_wrotten = len_to_write;
+    if (state != PCRDR_RESPONSE_RESULT ||
+            response_msg->retCode != PCRDR_SC_OK) {
+        PC_ERROR("failed to write content to rdr\n");
+        writer->failed = true;
     }
-    else {
-        LOG_ERROR("No valid character in document content\n");
-        goto failed;
+
+    return 0;
+}
+
+/* the response handler refers to the writer, so we always wait for
+   the responses, even if the writer failed. */
+static void
+wait_for_page_chunks(struct page_writer *writer, size_t max_in_flight)
+{
+    while (writer->nr_in_flight > max_in_flight) {
+        pcrdr_wait_and_dispatch_message(writer->conn, WAIT_WRITE_TIMEOUT);
     }
+}
 
-    response_msg = pcintr_rdr_send_request_and_wait_response(
-            conn, target, target_value, PCRDR_OPERATION_WRITEBEGIN, NULL,
-            element_type, NULL, NULL, data_type, data, len_to_write);
-    purc_variant_unref(data);
-    if (response_msg == NULL) {
-        goto failed;
+static int
+send_page_chunk(struct page_writer *writer)
+{
+    const char *end;
+    pcutils_string_check_utf8_len(writer->buf, writer->len_chunk, NULL, &end);
+    if (end == writer->buf) {
+        PC_WARN("no valid character for rdr\n");
+        return -1;
     }
 
-    if (response_msg->retCode != PCRDR_SC_OK) {
-        PC_ERROR("failed to write content to rdr\n");
-        goto failed;
+    size_t len = end - writer->buf;
+    pcrdr_msg *msg = pcrdr_make_request_message(
+            writer->target, writer->target_value,
+            writer->nr_chunks ?
+                PCRDR_OPERATION_WRITEMORE : PCRDR_OPERATION_WRITEBEGIN,
+            NULL, NULL,
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+    if (msg == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
     }
 
-    if (len_wrotten == len_content) {
-        goto done;
+    msg->dataType = writer->data_type;
+    msg->data = purc_variant_make_string_ex(writer->buf, len, false);
+    if (msg->data == PURC_VARIANT_INVALID) {
+        pcrdr_release_message(msg);
+        return -1;
     }
 
-writting:
-    len_to_write = 0;
-    if (len_wrotten + DEF_LEN_ONE_WRITE > len_content) {
-        // writeEnd
-        data = purc_variant_make_string_static(doc_content + len_wrotten,
-                false);
-        response_msg = pcintr_rdr_send_request_and_wait_response(
-                conn, target, target_value, PCRDR_OPERATION_WRITEEND, NULL,
-                element_type, NULL, NULL, data_type, data, 0);
-        purc_variant_unref(data);
-        if (response_msg == NULL) {
-            goto failed;
-        }
+    wait_for_page_chunks(writer, NR_WRITES_IN_FLIGHT - 1);
+    int r = writer->failed ? -1 : pcrdr_send_request(writer->conn, msg,
+            PCRDR_TIME_DEF_EXPECTED, writer, on_page_chunk_written);
+    pcrdr_release_message(msg);
+    if (r)
+        return -1;
 
-        if (response_msg->retCode != PCRDR_SC_OK) {
-            PC_ERROR("failed to write content to rdr\n");
-            goto failed;
-        }
-        goto done;
-    }
-    else {
-        // writeMore
-        start = doc_content + len_wrotten;
-        pcutils_string_check_utf8_len(start, DEF_LEN_ONE_WRITE, NULL, &end);
-        if (end > start) {
-            len_to_write = end - start;
-            len_wrotten += len_to_write;
-            data = purc_variant_make_string_static(start, false);
-        }
-        else {
-            PC_WARN("no valid character for rdr\n");
-            goto failed;
-        }
+    writer->nr_in_flight++;
+    writer->nr_chunks++;
+    if (writer->len_chunk < MAX_LEN_ONE_WRITE)
+        writer->len_chunk *= 2;
 
-        response_msg = pcintr_rdr_send_request_and_wait_response(
-                conn, target, target_value, PCRDR_OPERATION_WRITEMORE, NULL,
-                element_type, NULL, NULL, data_type, data, len_to_write);
-        purc_variant_unref(data);
-        if (response_msg == NULL) {
-            goto failed;
-        }
+    writer->len_buf -= len;
+    memmove(writer->buf, writer->buf + len, writer->len_buf);
+    return 0;
+}
 
-        if (response_msg->retCode != PCRDR_SC_OK) {
-            PC_ERROR("failed to write content to rdr\n");
-            goto failed;
+static ssize_t
+write_page_contents(void *ctxt, const void *buf, size_t count)
+{
+    struct page_writer *writer = ctxt;
+    if (writer->failed)
+        return -1;
+
+    if (writer->len_buf + count > writer->sz_buf) {
+        size_t sz = writer->sz_buf ? writer->sz_buf : DEF_LEN_ONE_WRITE;
+        while (sz < writer->len_buf + count)
+            sz *= 2;
+
+        char *p = realloc(writer->buf, sz);
+        if (p == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            writer->failed = true;
+            return -1;
         }
+        writer->buf = p;
+        writer->sz_buf = sz;
+    }
+
+    memcpy(writer->buf + writer->len_buf, buf, count);
+    writer->len_buf += count;
 
-        if (len_wrotten == len_content) {
-            goto done;
+    /* keep some content for the last request */
+    while (writer->len_buf > writer->len_chunk) {
+        if (send_page_chunk(writer)) {
+            writer->failed = true;
+            return -1;
         }
-        goto writting;
     }
 
+    return count;
+}
+
+static pcrdr_msg *
+finish_page_writer(struct page_writer *writer, const char *operation)
+{
+    pcrdr_msg *response_msg = NULL;
+    purc_variant_t data = PURC_VARIANT_INVALID;
+
+    wait_for_page_chunks(writer, 0);
+    if (writer->failed)
+        goto done;
+
+    data = purc_variant_make_string_ex(writer->buf, writer->len_buf, false);
+    if (data == PURC_VARIANT_INVALID)
+        goto done;
+
+    /* a small page is loaded by a single request */
+    response_msg = pcintr_rdr_send_request_and_wait_response(
+            writer->conn, writer->target, writer->target_value,
+            writer->nr_chunks ? PCRDR_OPERATION_WRITEEND : operation, NULL,
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            writer->data_type, data, 0);
+    purc_variant_unref(data);
+
 done:
+    free(writer->buf);
+    writer->buf = NULL;
     return response_msg;
-
-failed:
-    if (response_msg) {
-        pcrdr_release_message(response_msg);
-    }
-    return NULL;
 }
 
 bool
@@ -1112,7 +1177,15 @@ pcintr_rdr_page_control_load(pcintr_stack_t stack)
     else {
         unsigned opt = 0;
 
-        out = purc_rwstream_new_buffer(BUFF_MIN, BUFF_MAX);
+        struct page_writer writer = {
+            .conn = inst->conn_to_rdr,
+            .target = target,
+            .target_value = target_value,
+            .data_type = data_type,
+            .len_chunk = DEF_LEN_ONE_WRITE,
+        };
+
+        out = purc_rwstream_new_for_dump(&writer, write_page_contents);
         if (out == NULL) {
             goto failed;
         }
@@ -1124,36 +1197,13 @@ pcintr_rdr_page_control_load(pcintr_stack_t stack)
         opt |= PCDOC_SERIALIZE_OPT_WITH_HVML_HANDLE;
 
         if (0 != purc_document_serialize_contents_to_stream(doc, opt, out)) {
-            goto failed;
+            writer.failed = true;
         }
 
-        size_t sz_content = 0;
-        size_t sz_buff = 0;
-        char *p = (char*)purc_rwstream_get_mem_buffer_ex(out, &sz_content,
-                &sz_buff,true);
-        req_data = purc_variant_make_string_reuse_buff(p, sz_content, false);
-        if (req_data == PURC_VARIANT_INVALID) {
-            free(p);
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            goto failed;
-        }
-
-        if (sz_content > DEF_LEN_ONE_WRITE) {
-            response_msg = rdr_page_control_load_large_page(inst->conn_to_rdr,
-                        target, target_value, data_type,
-                        p, sz_content);
-        }
-        else {
-            response_msg = pcintr_rdr_send_request_and_wait_response(
-                    inst->conn_to_rdr, target, target_value, operation, NULL,
-                    element_type, NULL, NULL, data_type, req_data, 0);
-        }
-        purc_variant_unref(req_data);
+        purc_rwstream_destroy(out);
+        out = NULL;
 
-        if (out) {
-            purc_rwstream_destroy(out);
-            out = NULL;
-        }
+        response_msg = finish_page_writer(&writer, operation);
     }
 
     if (response_msg == NULL) {
@@ -1271,6 +1321,9 @@ pcintr_rdr_send_dom_req(pcintr_stack_t stack, int op, const char *request_id,
         return NULL;
     }
 
+    /* keep the order of the requests */
+    pcintr_util_send_pending_content(stack);
+
     pcintr_coroutine_t co = stack->co;
     if (co->target_page_handle == 0 || co->target_dom_handle == 0) {
         if (!co->stack.inherit) {
@@ -44,6 +44,7 @@
 #define SCHEDULE_SLEEP          10 * 1000       // usec
 #define IDLE_EVENT_TIMEOUT      100             // ms
 #define TIME_SLIECE             0.005           // s
+#define RELEASE_BUDGET          2               // ms
 
 #define BUILTIN_VAR_CRTN        PURC_PREDEF_VARNAME_CRTN
 
@@ -482,7 +483,12 @@ execute_one_step_for_ready_co(struct pcinst *inst, pcintr_coroutine_t co)
     pcintr_set_current_co(co);
 
     pcintr_coroutine_set_state(co, CO_STATE_RUNNING);
+
+    // the containers dropped by the step are released by the scheduler
+    // in the context of the coroutine
+    struct pcvariant_dying *dying = pcvariant_defer_release(&co->dying);
     pcintr_execute_one_step_for_ready_co(co);
+    pcvariant_defer_release(dying);
 
     int err = purc_get_last_error();
     if (err != PURC_ERROR_AGAIN) {
@@ -533,8 +539,7 @@ execute_one_step(struct pcinst *inst)
         }
 
 #if 1
-        struct timespec begin;
-        clock_gettime(CLOCK_MONOTONIC, &begin);
+        clock_gettime(CLOCK_MONOTONIC, &heap->slice_begin);
         struct pcintr_stack_frame *frame;
         while (co->state == CO_STATE_READY) {
             frame = pcintr_stack_get_bottom_frame(&co->stack);
@@ -543,11 +548,17 @@ execute_one_step(struct pcinst *inst)
             if (must_yield) {
                 break;
             }
-            double diff = purc_get_elapsed_seconds(&begin, NULL);
+            double diff = purc_get_elapsed_seconds(&heap->slice_begin, NULL);
             if (diff > TIME_SLIECE) {
                 break;
             }
         }
+
+        // the coroutine yielded, stopped, or used up its time slice
+        // while still ready; show what it made so far
+        pcintr_set_current_co(co);
+        pcintr_util_send_pending_content(&co->stack);
+        pcintr_set_current_co(NULL);
 #else
             execute_one_step_for_ready_co(inst, co);
 #endif
@@ -760,6 +771,38 @@ again:
     return is_busy;
 }
 
+static bool
+release_deferred_in(struct list_head *crtns)
+{
+    bool busy = false;
+    pcintr_coroutine_t p, q;
+    list_for_each_entry_safe(p, q, crtns, ln) {
+        pcintr_coroutine_t co = p;
+        if (co->dying.nr == 0) {
+            continue;
+        }
+
+        pcintr_set_current_co(co);
+        if (pcvariant_release_deferred(&co->dying, RELEASE_BUDGET) > 0) {
+            busy = true;
+        }
+        pcintr_set_current_co(NULL);
+    }
+
+    return busy;
+}
+
+// release the containers dropped by the steps of the coroutines
+// return whether busy
+static bool
+release_deferred(struct pcinst *inst)
+{
+    struct pcintr_heap *heap = inst->intr_heap;
+    bool crtns_busy = release_deferred_in(&heap->crtns);
+    bool stopped_busy = release_deferred_in(&heap->stopped_crtns);
+    return crtns_busy || stopped_busy;
+}
+
 void
 pcintr_schedule(void *ctxt)
 {
@@ -784,8 +827,12 @@ again:
     // 2. dispatch event for observing / stopped coroutines
     event_is_busy = dispatch_event(inst);
 
-    // 3. its busy, goto next scheduler without sleep
-    if (step_is_busy || event_is_busy) {
+    // 3. release the containers dropped by the steps within a budget,
+    // and leave the remaining ones to the next round
+    bool release_is_busy = release_deferred(inst);
+
+    // 4. its busy, goto next scheduler without sleep
+    if (step_is_busy || event_is_busy || release_is_busy) {
         pcintr_update_timestamp(inst);
         goto again;
     }
@@ -832,6 +879,23 @@ int pcintr_yield(
     return 0;
 }
 
+bool pcintr_preempt_if_slice_expired(void)
+{
+    pcintr_coroutine_t co = pcintr_get_coroutine();
+    if (co == NULL || co->state != CO_STATE_RUNNING)
+        return false;
+
+    struct pcintr_heap *heap = co->owner;
+    if (purc_get_elapsed_seconds(&heap->slice_begin, NULL) <= TIME_SLIECE)
+        return false;
+
+    /* the coroutine is still ready; the step will be executed again in the
+       next round, after the other coroutines and the events got a chance. */
+    pcintr_coroutine_set_state(co, CO_STATE_READY);
+    purc_set_error(PURC_ERROR_AGAIN);
+    return true;
+}
+
 void pcintr_resume(pcintr_coroutine_t co, pcrdr_msg *msg)
 {
     UNUSED_PARAM(msg);
@@ -861,9 +925,13 @@ static int
 serial_symbol_vars(const char *symbol, int id,
         struct pcintr_stack_frame *frame, purc_rwstream_t stm)
 {
+    purc_variant_t val = pcintr_get_symbol_var(frame, id);
+    if (val == PURC_VARIANT_INVALID)
+        return -1;
+
     purc_rwstream_write(stm, symbol, strlen(symbol));
     size_t len_expected = 0;
-    purc_variant_serialize(frame->symbol_vars[id],
+    purc_variant_serialize(val,
             stm, 0,
             PCVRNT_SERIALIZE_OPT_REAL_EJSON |
             PCVRNT_SERIALIZE_OPT_BSEQUENCE_BASE64 |
@@ -911,7 +979,7 @@ dump_stack_frame(pcintr_stack_t stack,
                 pcvcm_dump_stack(stack->vcm_ctxt, stm, 2, true);
             }
             else {
-                purc_variant_t val = pcutils_array_get(frame->attrs_result, i);
+                purc_variant_t val = pcutils_array_get(&frame->attrs_result, i);
                 if (val) {
                     char *val_buf = pcvariant_to_string(val);
                     snprintf(buf, DUMP_BUF_SIZE, "    %s: %s\n", attr->key,
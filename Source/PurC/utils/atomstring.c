@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <stdatomic.h>
 
 #include "purc-ports.h"
 #include "purc-utils.h"
@@ -34,6 +35,7 @@
 #include "private/instance.h"
 #include "private/map.h"
 #include "private/utils.h"
+#include "private/tls.h"
 
 #if PURC_ATOM_BUCKET_BITS > 16
 #error "Too many bits reserved for bucket"
@@ -71,6 +73,85 @@ static purc_rwlock atom_rwlock;
 static char *atom_block = NULL;
 static int  atom_block_offset = 0;
 
+/*
+ * The atoms found are also kept in a small direct-mapped cache of every
+ * thread, so that looking up an existing atom does not take atom_rwlock.
+ * The cache keeps its own copy of the string. Since the sequence of an
+ * atom never changes and is never reused, the only thing which can make
+ * an entry stale is the removal of an atom; the generation of a bucket is
+ * increased by every removal from the bucket, and the entries of an older
+ * generation of their bucket are ignored.
+ */
+#define ATOM_CACHE_SIZE         256     // must be a power of 2
+#define ATOM_CACHE_KEY_LEN      40      // including the terminating null
+
+struct atom_cache_entry {
+    unsigned int    generation;
+    purc_atom_t     atom;
+    char            key[ATOM_CACHE_KEY_LEN];
+};
+
+struct atom_cache {
+    struct atom_cache_entry entries[ATOM_CACHE_SIZE];
+};
+
+PURC_DEFINE_THREAD_LOCAL(struct atom_cache, atom_cache);
+
+static atomic_uint atom_generations[PURC_ATOM_BUCKETS_NR];
+
+/* returns the slot of the string in the cache, or -1 if it is too long */
+static inline int
+atom_cache_slot(int bucket, const char *string, size_t *len)
+{
+    uint32_t hash = 2166136261U ^ (uint32_t)bucket;
+    size_t n = 0;
+
+    for (; string[n]; n++) {
+        if (n + 1 >= ATOM_CACHE_KEY_LEN)
+            return -1;
+        hash ^= (uint8_t)string[n];
+        hash *= 16777619U;
+    }
+
+    *len = n;
+    return (int)(hash & (ATOM_CACHE_SIZE - 1));
+}
+
+static inline purc_atom_t
+atom_cache_find(int bucket, const char *string, int *slot, size_t *len)
+{
+    *slot = atom_cache_slot(bucket, string, len);
+    if (*slot < 0)
+        return 0;
+
+    struct atom_cache *cache = PURC_GET_THREAD_LOCAL(atom_cache);
+    if (cache == NULL)
+        return 0;
+
+    struct atom_cache_entry *entry = cache->entries + *slot;
+    if (entry->atom && ATOM_TO_BUCKET(entry->atom) == bucket &&
+            entry->generation == atomic_load_explicit(
+                atom_generations + bucket, memory_order_acquire) &&
+            memcmp(entry->key, string, *len + 1) == 0)
+        return entry->atom;
+
+    return 0;
+}
+
+static inline void
+atom_cache_put(int slot, const char *string, size_t len,
+        purc_atom_t atom, unsigned int generation)
+{
+    struct atom_cache *cache = PURC_GET_THREAD_LOCAL(atom_cache);
+    if (slot < 0 || cache == NULL || atom == 0)
+        return;
+
+    struct atom_cache_entry *entry = cache->entries + slot;
+    entry->generation = generation;
+    entry->atom = atom;
+    memcpy(entry->key, string, len + 1);
+}
+
 static void atom_init_bucket(struct atom_bucket *bucket)
 {
     assert (bucket->atom_seq_id == 0);
@@ -119,12 +200,21 @@ purc_atom_try_string_ex(int bucket, const char *string)
     if (string == NULL || atom_bucket == NULL)
         return 0;
 
+    int slot;
+    size_t len;
+    atom = atom_cache_find(bucket, string, &slot, &len);
+    if (atom)
+        return atom;
+
     purc_rwlock_reader_lock(&atom_rwlock);
+    unsigned int generation = atomic_load_explicit(atom_generations + bucket,
+            memory_order_relaxed);
     if ((entry = pcutils_uomap_find(atom_bucket->atom_map, string))) {
         atom = (purc_atom_t)(uintptr_t)pcutils_uomap_entry_val(entry);
     }
     purc_rwlock_reader_unlock(&atom_rwlock);
 
+    atom_cache_put(slot, string, len, atom, generation);
     return atom;
 }
 
@@ -146,6 +236,8 @@ purc_atom_remove_string_ex(int bucket, const char *string)
         pcutils_uomap_erase_entry_nolock(atom_bucket->atom_map, entry);
         atom = ATOM_TO_SEQUENCE(atom);
         atom_bucket->quarks[atom] = NULL;
+        atomic_fetch_add_explicit(atom_generations + bucket, 1,
+                memory_order_release);
         ret = true;
     }
     else {
@@ -217,14 +309,28 @@ atom_from_string(struct atom_bucket *bucket, const char *string,
 }
 
 static inline purc_atom_t
-atom_from_string_locked(struct atom_bucket *bucket, const char *string,
+atom_from_string_locked(int bucket, const char *string,
         bool duplicate, bool *newly_created)
 {
     purc_atom_t atom = 0;
+    int slot;
+    size_t len;
+
+    atom = atom_cache_find(bucket, string, &slot, &len);
+    if (atom) {
+        if (newly_created)
+            *newly_created = false;
+        return atom;
+    }
+
     purc_rwlock_writer_lock(&atom_rwlock);
-    atom = atom_from_string(bucket, string, duplicate, newly_created);
+    unsigned int generation = atomic_load_explicit(atom_generations + bucket,
+            memory_order_relaxed);
+    atom = atom_from_string(atom_get_bucket(bucket), string, duplicate,
+            newly_created);
     purc_rwlock_writer_unlock(&atom_rwlock);
 
+    atom_cache_put(slot, string, len, atom, generation);
     return atom;
 }
 
@@ -234,8 +340,7 @@ purc_atom_from_string_ex2(int bucket, const char *string, bool *newly_created)
     if (!string)
         return 0;
 
-    return atom_from_string_locked(atom_get_bucket(bucket), string,
-            true, newly_created);
+    return atom_from_string_locked(bucket, string, true, newly_created);
 }
 
 purc_atom_t
@@ -245,8 +350,7 @@ purc_atom_from_static_string_ex2(int bucket, const char *string,
     if (!string)
         return 0;
 
-    return atom_from_string_locked(atom_get_bucket(bucket), string,
-            false, newly_created);
+    return atom_from_string_locked(bucket, string, false, newly_created);
 }
 
 const char *
@@ -55,6 +55,35 @@ pcutils_mraw_realloc_tail(pcutils_mraw_t *mraw, void *data, void *begin,
                          size_t size, size_t begin_len, size_t new_size,
                          bool *is_valid);
 
+static inline bool
+pcutils_mraw_is_small(size_t size)
+{
+    return size >= sizeof(void *) && size <= PCUTILS_MRAW_SMALL_MAX;
+}
+
+/* put a freed block into the cache; the block has been poisoned */
+static inline void
+pcutils_mraw_cache_put(pcutils_mraw_t *mraw, void *data, size_t size)
+{
+    if (pcutils_mraw_is_small(size)) {
+        void **head = &mraw->small_cache[size / PCUTILS_MEM_ALIGN_STEP];
+
+#if defined(PCHTML_HAVE_ADDRESS_SANITIZER)
+        ASAN_UNPOISON_MEMORY_REGION(data, sizeof(void *));
+#endif
+        memcpy(data, head, sizeof(void *));
+#if defined(PCHTML_HAVE_ADDRESS_SANITIZER)
+        ASAN_POISON_MEMORY_REGION(data, sizeof(void *));
+#endif
+
+        *head = data;
+        return;
+    }
+
+    pcutils_bst_insert(mraw->cache, pcutils_bst_root_ref(mraw->cache),
+                      size, data);
+}
+
 
 pcutils_mraw_t *
 pcutils_mraw_create(void)
@@ -103,6 +132,7 @@ pcutils_mraw_clean(pcutils_mraw_t *mraw)
 {
     pcutils_mem_clean(mraw->mem);
     pcutils_bst_clean(mraw->cache);
+    memset(mraw->small_cache, 0, sizeof(mraw->small_cache));
 }
 
 pcutils_mraw_t *
@@ -170,9 +200,9 @@ pcutils_mraw_mem_alloc(pcutils_mraw_t *mraw, size_t length)
                                       diff + pcutils_mraw_meta_size());
 #endif
 
-            pcutils_bst_insert(mraw->cache,
-                              pcutils_bst_root_ref(mraw->cache), diff,
-                              pcutils_mraw_data_begin(&chunk->data[chunk->length]));
+            pcutils_mraw_cache_put(mraw,
+                    pcutils_mraw_data_begin(&chunk->data[chunk->length]),
+                    diff);
 
             chunk->length = chunk->size;
         }
@@ -205,7 +235,23 @@ pcutils_mraw_alloc(pcutils_mraw_t *mraw, size_t size)
 
     size = pcutils_mem_align(size);
 
-    if (mraw->cache->tree_length != 0) {
+    if (pcutils_mraw_is_small(size)) {
+        void **head = &mraw->small_cache[size / PCUTILS_MEM_ALIGN_STEP];
+
+        data = *head;
+        if (data != NULL) {
+
+#if defined(PCHTML_HAVE_ADDRESS_SANITIZER)
+            uint8_t *real_data = ((uint8_t *) data) - pcutils_mraw_meta_size();
+            ASAN_UNPOISON_MEMORY_REGION(real_data,
+                                        (size + pcutils_mraw_meta_size()));
+#endif
+
+            memcpy(head, data, sizeof(void *));
+            return data;
+        }
+    }
+    else if (mraw->cache->tree_length != 0) {
         data = pcutils_bst_remove_close(mraw->cache,
                                        pcutils_bst_root_ref(mraw->cache),
                                        size, NULL);
@@ -365,8 +411,7 @@ pcutils_mraw_realloc(pcutils_mraw_t *mraw, void *data, size_t new_size)
 #if defined(PCHTML_HAVE_ADDRESS_SANITIZER)
             ASAN_POISON_MEMORY_REGION(begin, size + pcutils_mraw_meta_size());
 #endif
-            pcutils_bst_insert(mraw->cache, pcutils_bst_root_ref(mraw->cache),
-                              size, data);
+            pcutils_mraw_cache_put(mraw, data, size);
             return NULL;
         }
 
@@ -383,8 +428,8 @@ pcutils_mraw_realloc(pcutils_mraw_t *mraw, void *data, size_t new_size)
 #if defined(PCHTML_HAVE_ADDRESS_SANITIZER)
             ASAN_POISON_MEMORY_REGION(begin, new_size + pcutils_mraw_meta_size());
 #endif
-            pcutils_bst_insert(mraw->cache, pcutils_bst_root_ref(mraw->cache),
-                              new_size, pcutils_mraw_data_begin(begin));
+            pcutils_mraw_cache_put(mraw, pcutils_mraw_data_begin(begin),
+                    new_size);
         }
 
         return data;
@@ -414,8 +459,7 @@ pcutils_mraw_free(pcutils_mraw_t *mraw, void *data)
     ASAN_POISON_MEMORY_REGION(real_data, size + pcutils_mraw_meta_size());
 #endif
 
-    pcutils_bst_insert(mraw->cache, pcutils_bst_root_ref(mraw->cache),
-                      size, data);
+    pcutils_mraw_cache_put(mraw, data, size);
 
     return NULL;
 }
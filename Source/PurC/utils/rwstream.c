@@ -28,6 +28,7 @@
 #include "purc-utils.h"
 #include "private/errors.h"
 #include "private/instance.h"
+#include "private/rwstream.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -255,6 +256,59 @@ purc_rwstream_t purc_rwstream_new_from_mem (void* mem, size_t sz)
     return (purc_rwstream_t)rws;
 }
 
+struct romem_rwstream
+{
+    struct mem_rwstream mem;
+    pcrws_cb_release release;
+    void *ctxt;
+};
+
+static int romem_destroy (purc_rwstream_t rws)
+{
+    struct romem_rwstream* romem = (struct romem_rwstream *)rws;
+    if (romem->release) {
+        romem->release(romem->ctxt);
+    }
+    free(rws);
+    return 0;
+}
+
+static rwstream_funcs romem_funcs = {
+    mem_seek,
+    mem_tell,
+    mem_read,
+    NULL,
+    mem_flush,
+    romem_destroy,
+    mem_get_mem_buffer
+};
+
+purc_rwstream_t
+pcrwstream_new_from_readonly_mem(const void *mem, size_t sz,
+        pcrws_cb_release release, void *ctxt)
+{
+    if (mem == NULL && sz > 0) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    struct romem_rwstream* rws = (struct romem_rwstream*) calloc(
+            1, sizeof(struct romem_rwstream));
+    if (rws == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    rws->mem.rwstream.funcs = &romem_funcs;
+    rws->mem.base = (uint8_t *)mem;
+    rws->mem.here = rws->mem.base;
+    rws->mem.stop = rws->mem.base + sz;
+    rws->release = release;
+    rws->ctxt = ctxt;
+
+    return (purc_rwstream_t)rws;
+}
+
 purc_rwstream_t purc_rwstream_new_from_file (const char* file, const char* mode)
 {
     FILE* fp = fopen(file, mode);
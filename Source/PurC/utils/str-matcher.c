@@ -0,0 +1,290 @@
+/*
+ * @file str-matcher.c
+ * @date 2026/10/18
+ * @brief The implementation of the multiple-pattern string matcher.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#define _GNU_SOURCE
+#include "config.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "purc-errors.h"
+#include "private/errors.h"
+#include "private/str-matcher.h"
+
+/*
+ * The matcher is an Aho-Corasick automaton compiled to a full DFA.
+ * The bytes which appear in the patterns are mapped to classes 1 ... n,
+ * all other bytes to class 0, so the transition table only has n + 1
+ * columns. Every state records the longest pattern which ends at it
+ * (following the dictionary suffix links), that is all we need to find
+ * the leftmost-longest match.
+ *
+ * A matcher for a single pattern does not build the automaton at all;
+ * it uses memmem() instead.
+ */
+struct pcutils_str_matcher {
+    /* the number of patterns */
+    size_t          nr_patterns;
+
+    /* the only pattern when nr_patterns is 1 */
+    char           *single;
+    size_t          len_single;
+
+    /* the number of byte classes */
+    size_t          nr_classes;
+
+    /* the number of states */
+    size_t          nr_states;
+
+    /* the transition table: nr_states x nr_classes */
+    uint32_t       *delta;
+
+    /* the depth of every state in the trie */
+    uint32_t       *depth;
+
+    /* the index of the longest pattern ends at every state; -1 for none */
+    int32_t        *out_idx;
+
+    /* the length of the pattern in out_idx */
+    uint32_t       *out_len;
+
+    /* the byte to class map */
+    uint16_t        classes[256];
+};
+
+static int
+build_automaton(struct pcutils_str_matcher *matcher,
+        const char **patterns, const size_t *lengths)
+{
+    size_t nr_bytes = 0;
+    size_t nr_classes = 1;
+    uint32_t *fail = NULL;
+    uint32_t *queue = NULL;
+
+    memset(matcher->classes, 0, sizeof(matcher->classes));
+    for (size_t i = 0; i < matcher->nr_patterns; i++) {
+        const uint8_t *p = (const uint8_t *)patterns[i];
+        for (size_t j = 0; j < lengths[i]; j++) {
+            if (matcher->classes[p[j]] == 0)
+                matcher->classes[p[j]] = (uint16_t)nr_classes++;
+        }
+        nr_bytes += lengths[i];
+    }
+
+    if (nr_bytes >= UINT32_MAX)
+        goto failed;
+
+    size_t max_states = nr_bytes + 1;
+    matcher->nr_classes = nr_classes;
+    matcher->delta = calloc(max_states * nr_classes, sizeof(uint32_t));
+    matcher->depth = calloc(max_states, sizeof(uint32_t));
+    matcher->out_idx = malloc(max_states * sizeof(int32_t));
+    matcher->out_len = calloc(max_states, sizeof(uint32_t));
+    fail = calloc(max_states, sizeof(uint32_t));
+    queue = malloc(max_states * sizeof(uint32_t));
+    if (matcher->delta == NULL || matcher->depth == NULL ||
+            matcher->out_idx == NULL || matcher->out_len == NULL ||
+            fail == NULL || queue == NULL)
+        goto failed;
+
+    for (size_t i = 0; i < max_states; i++)
+        matcher->out_idx[i] = -1;
+
+    /* build the trie; state 0 is the root, and no edge of the trie
+       goes back to the root, so zero in delta means no edge */
+    size_t nr_states = 1;
+    for (size_t i = 0; i < matcher->nr_patterns; i++) {
+        const uint8_t *p = (const uint8_t *)patterns[i];
+        uint32_t s = 0;
+        for (size_t j = 0; j < lengths[i]; j++) {
+            uint32_t *next = matcher->delta + s * nr_classes +
+                matcher->classes[p[j]];
+            if (*next == 0) {
+                matcher->depth[nr_states] = matcher->depth[s] + 1;
+                *next = (uint32_t)nr_states++;
+            }
+            s = *next;
+        }
+
+        /* keep the first one for duplicated patterns */
+        if (matcher->out_idx[s] < 0) {
+            matcher->out_idx[s] = (int32_t)i;
+            matcher->out_len[s] = (uint32_t)lengths[i];
+        }
+    }
+    matcher->nr_states = nr_states;
+
+    /* compute the failure links in breadth-first order and turn the trie
+       into a DFA in the meantime */
+    size_t head = 0, tail = 0;
+    for (size_t c = 0; c < nr_classes; c++) {
+        uint32_t t = matcher->delta[c];
+        if (t) {
+            fail[t] = 0;
+            queue[tail++] = t;
+        }
+    }
+
+    while (head < tail) {
+        uint32_t s = queue[head++];
+        uint32_t *row = matcher->delta + s * nr_classes;
+        const uint32_t *fail_row = matcher->delta + fail[s] * nr_classes;
+
+        if (matcher->out_idx[s] < 0) {
+            matcher->out_idx[s] = matcher->out_idx[fail[s]];
+            matcher->out_len[s] = matcher->out_len[fail[s]];
+        }
+
+        for (size_t c = 0; c < nr_classes; c++) {
+            uint32_t t = row[c];
+            if (t) {
+                fail[t] = fail_row[c];
+                queue[tail++] = t;
+            }
+            else {
+                row[c] = fail_row[c];
+            }
+        }
+    }
+
+    free(fail);
+    free(queue);
+    return 0;
+
+failed:
+    free(fail);
+    free(queue);
+    return -1;
+}
+
+struct pcutils_str_matcher *
+pcutils_str_matcher_new(const char **patterns, const size_t *lengths,
+        size_t nr_patterns)
+{
+    struct pcutils_str_matcher *matcher;
+
+    if (nr_patterns == 0 || nr_patterns > INT32_MAX) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < nr_patterns; i++) {
+        if (patterns[i] == NULL || lengths[i] == 0) {
+            pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+            return NULL;
+        }
+    }
+
+    matcher = calloc(1, sizeof(*matcher));
+    if (matcher == NULL)
+        goto failed;
+
+    matcher->nr_patterns = nr_patterns;
+    if (nr_patterns == 1) {
+        matcher->single = malloc(lengths[0]);
+        if (matcher->single == NULL)
+            goto failed;
+        memcpy(matcher->single, patterns[0], lengths[0]);
+        matcher->len_single = lengths[0];
+    }
+    else if (build_automaton(matcher, patterns, lengths)) {
+        goto failed;
+    }
+
+    return matcher;
+
+failed:
+    pcutils_str_matcher_delete(matcher);
+    pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return NULL;
+}
+
+void pcutils_str_matcher_delete(struct pcutils_str_matcher *matcher)
+{
+    if (matcher) {
+        free(matcher->single);
+        free(matcher->delta);
+        free(matcher->depth);
+        free(matcher->out_idx);
+        free(matcher->out_len);
+        free(matcher);
+    }
+}
+
+const char *
+pcutils_str_matcher_find(const struct pcutils_str_matcher *matcher,
+        const char *str, size_t len, size_t *idx, size_t *len_matched)
+{
+    if (matcher->single) {
+        const char *found = memmem(str, len,
+                matcher->single, matcher->len_single);
+        if (found) {
+            if (idx)
+                *idx = 0;
+            if (len_matched)
+                *len_matched = matcher->len_single;
+        }
+        return found;
+    }
+
+    const uint8_t *p = (const uint8_t *)str;
+    const uint32_t *delta = matcher->delta;
+    const size_t nr_classes = matcher->nr_classes;
+    uint32_t s = 0;
+
+    bool found = false;
+    size_t found_start = 0, found_len = 0, found_idx = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        s = delta[s * nr_classes + matcher->classes[p[i]]];
+
+        /* No future match can start at or before the candidate,
+           so the candidate is the leftmost-longest one. */
+        if (found && i + 1 - matcher->depth[s] > found_start)
+            break;
+
+        if (matcher->out_idx[s] >= 0) {
+            size_t l = matcher->out_len[s];
+            size_t start = i + 1 - l;
+            if (!found || start < found_start ||
+                    (start == found_start && l > found_len)) {
+                found = true;
+                found_start = start;
+                found_len = l;
+                found_idx = (size_t)matcher->out_idx[s];
+            }
+        }
+    }
+
+    if (!found)
+        return NULL;
+
+    if (idx)
+        *idx = found_idx;
+    if (len_matched)
+        *len_matched = found_len;
+    return str + found_start;
+}
@@ -34,11 +34,7 @@
 
 #define BUFF_MIN                1024
 #define BUFF_KEY                1024
-
-static int
-build_query(purc_rwstream_t rws, const char *k, purc_variant_t v,
-        const char *numeric_prefix, char arg_separator,
-        unsigned int flags);
+#define BUFF_ENCODE             1024
 
 void
 pcutils_broken_down_url_clear(struct purc_broken_down_url *broken_down)
@@ -406,252 +402,205 @@ pcutils_url_get_query_value_alloc(
     return true;
 }
 
+/* 1 for the bytes which are kept as is in the query string */
+static const unsigned char query_unreserved[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+/* The context of building a query string: the whole query is written to
+   one stream, and the key of the current member is kept in one buffer,
+   which grows and shrinks as we go down and up the nested containers. */
+struct query_builder {
+    purc_rwstream_t rws;
+    const char     *numeric_prefix;
+    char            arg_separator;
+    unsigned int    flags;
+    unsigned int    serialize_flags;
+
+    char           *key;
+    size_t          len_key;
+    size_t          sz_key;
+};
+
+static int
+build_query(struct query_builder *qb, purc_variant_t v, bool has_key);
+
 static int
-encode_string(purc_rwstream_t rws, const char *s,
+encode_string(purc_rwstream_t rws, const char *s, size_t nr,
         unsigned int flags)
 {
-    char space[4];
-    size_t nr_space;
-    if (flags & PCUTILS_URL_OPT_RFC1738) {
-        space[0] = '+';
-        space[1] = 0;
-        nr_space = 1;
-    }
-    else {
-        space[0] = '%';
-        space[1] = '2';
-        space[2] = '0';
-        space[3] = 0;
-        nr_space = 3;
-    }
+    char buff[BUFF_ENCODE];
+    size_t len = 0;
 
-    size_t nr = strlen(s);
     for (size_t i = 0; i < nr; i++) {
-        const char byte = s[i];
-        if (byte == 0x20) {
-            purc_rwstream_write(rws, &space, nr_space);
+        const unsigned char byte = (unsigned char)s[i];
+
+        /* leave room for one escaped byte */
+        if (len + 3 > sizeof(buff)) {
+            purc_rwstream_write(rws, buff, len);
+            len = 0;
+        }
+
+        if (query_unreserved[byte]) {
+            buff[len++] = byte;
         }
-        else if (byte == 0x2A
-            || byte == 0x2D
-            || byte == 0x2E
-            || (byte >= 0x30 && byte <= 0x39)
-            || (byte >= 0x41 && byte <= 0x5A)
-            || byte == 0x5F
-            || (byte >= 0x61 && byte <= 0x7A)) {
-            purc_rwstream_write(rws, &byte, 1);
+        else if (byte == 0x20 && (flags & PCUTILS_URL_OPT_RFC1738)) {
+            buff[len++] = '+';
         }
         else {
-            purc_rwstream_write(rws, "%", 1);
-            char v = upperNibbleToASCIIHexDigit(byte);
-            purc_rwstream_write(rws, &v, 1);
-
-            v = lowerNibbleToASCIIHexDigit(byte);
-            purc_rwstream_write(rws, &v, 1);
+            buff[len++] = '%';
+            buff[len++] = upperNibbleToASCIIHexDigit(byte);
+            buff[len++] = lowerNibbleToASCIIHexDigit(byte);
         }
     }
+
+    if (len > 0)
+        purc_rwstream_write(rws, buff, len);
     return 0;
 }
 
-static int
-encode_object(purc_rwstream_t rws, const char *k, purc_variant_t v,
-        const char *numeric_prefix, char arg_separator,
-        unsigned int flags)
+/* append the pieces (NULL for none) to the current key;
+   returns the previous length of the key */
+static ssize_t
+push_key(struct query_builder *qb, const char *s1, const char *s2,
+        const char *s3)
 {
-    int ret = -1;
-    size_t nr_k = k ? strlen(k) : 0;
-    char *key = NULL;
-    purc_variant_t ok;
-    purc_variant_t ov;
-    ssize_t nr_size = purc_variant_object_get_size(v);
-    if (nr_size == 0) {
-        ret = 0;
-        goto out;
-    }
-    foreach_key_value_in_variant_object(v, ok, ov)
-        const char *sk = purc_variant_get_string_const(ok);
-        size_t nr_sk = strlen(sk);
-        if (k) {
-            key = (char*)malloc(nr_k + nr_sk + 3);
-#if 0
-            sprintf(key, "%s[%s]", k, sk);
-#else
-            strcpy(key, k);
-            strcat(key, "[");
-            strcat(key, sk);
-            strcat(key, "]");
-#endif
-        }
-        else {
-            key = strdup(sk);
-        }
-        if (!key) {
+    size_t old_len = qb->len_key;
+    size_t l1 = s1 ? strlen(s1) : 0;
+    size_t l2 = s2 ? strlen(s2) : 0;
+    size_t l3 = s3 ? strlen(s3) : 0;
+    size_t new_len = old_len + l1 + l2 + l3;
+
+    if (new_len >= qb->sz_key) {
+        size_t sz = qb->sz_key * 2;
+        while (sz <= new_len)
+            sz *= 2;
+
+        char *key = (char *)realloc(qb->key, sz);
+        if (key == NULL) {
             purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            ret = PURC_ERROR_OUT_OF_MEMORY;
-            goto out;
-        }
-
-        if (purc_rwstream_tell(rws) > 0) {
-            purc_rwstream_write(rws, &arg_separator, 1);
-        }
-
-        ret = build_query(rws, key, ov, numeric_prefix,
-                arg_separator, flags);
-        free(key);
-        if (ret != PURC_ERROR_OK) {
-            goto out;
-        }
-    end_foreach;
-
-out:
-    return ret;
+            return -1;
+        }
+        qb->key = key;
+        qb->sz_key = sz;
+    }
+
+    char *p = qb->key + old_len;
+    if (l1)
+        memcpy(p, s1, l1);
+    if (l2)
+        memcpy(p + l1, s2, l2);
+    if (l3)
+        memcpy(p + l1 + l2, s3, l3);
+    qb->key[new_len] = 0;
+    qb->len_key = new_len;
+    return (ssize_t)old_len;
 }
 
-static int
-encode_array(purc_rwstream_t rws, const char *k, purc_variant_t v,
-        const char *numeric_prefix, char arg_separator,
-        unsigned int flags)
+static inline void
+write_separator(struct query_builder *qb)
 {
-    int ret = -1;
-    char key[BUFF_KEY];
-    purc_variant_t ov;
-    size_t idx;
-    ssize_t nr_size = purc_variant_array_get_size(v);
-    if (nr_size == 0) {
-        ret = 0;
-        goto out;
+    if (purc_rwstream_tell(qb->rws) > 0) {
+        purc_rwstream_write(qb->rws, &qb->arg_separator, 1);
     }
-    foreach_value_in_variant_array(v, ov, idx)
-        if (k) {
-            snprintf(key, BUFF_KEY, "%s[%ld]", k, idx);
-        }
-        else if (numeric_prefix) {
-            snprintf(key, BUFF_KEY, "%s%ld", numeric_prefix, idx);
-        }
-        else {
-            snprintf(key, BUFF_KEY, "%ld", idx);
-        }
-
-        if (purc_rwstream_tell(rws) > 0) {
-            purc_rwstream_write(rws, &arg_separator, 1);
-        }
-
-        ret = build_query(rws, key, ov, numeric_prefix,
-                arg_separator, flags);
-        if (ret != PURC_ERROR_OK) {
-            goto out;
-        }
-    end_foreach;
-
-out:
-    return ret;
 }
 
 static int
-encode_set(purc_rwstream_t rws, const char *k, purc_variant_t v,
-        const char *numeric_prefix, char arg_separator,
-        unsigned int flags)
+encode_object(struct query_builder *qb, purc_variant_t v, bool has_key)
 {
-    int ret = -1;
-    char key[BUFF_KEY];
+    int ret = 0;
+    purc_variant_t ok;
     purc_variant_t ov;
-    size_t idx = 0;
-    ssize_t nr_size = purc_variant_set_get_size(v);
-    if (nr_size == 0) {
-        ret = 0;
-        goto out;
-    }
-    foreach_value_in_variant_set_order(v, ov)
-        if (k) {
-            snprintf(key, BUFF_KEY, "%s[%ld]", k, idx);
-        }
-        else if (numeric_prefix) {
-            snprintf(key, BUFF_KEY, "%s%ld", numeric_prefix, idx);
-        }
-        else {
-            snprintf(key, BUFF_KEY, "%ld", idx);
-        }
 
-        if (purc_rwstream_tell(rws) > 0) {
-            purc_rwstream_write(rws, &arg_separator, 1);
+    foreach_key_value_in_variant_object(v, ok, ov)
+        const char *sk = purc_variant_get_string_const(ok);
+        ssize_t old_len = has_key ? push_key(qb, "[", sk, "]") :
+            push_key(qb, NULL, sk, NULL);
+        if (old_len < 0) {
+            ret = -1;
+            break;
         }
 
-        ret = build_query(rws, key, ov, numeric_prefix,
-                arg_separator, flags);
+        write_separator(qb);
+        ret = build_query(qb, ov, true);
+        qb->len_key = old_len;
         if (ret != PURC_ERROR_OK) {
-            goto out;
+            break;
         }
-        idx++;
     end_foreach;
 
-out:
     return ret;
 }
 
+/* arrays, sets, and tuples */
 static int
-encode_tuple(purc_rwstream_t rws, const char *k, purc_variant_t v,
-        const char *numeric_prefix, char arg_separator,
-        unsigned int flags)
+encode_linear_container(struct query_builder *qb, purc_variant_t v,
+        bool has_key)
 {
-    int ret = -1;
-    char key[BUFF_KEY];
-    purc_variant_t ov;
-    size_t idx = 0;
+    int ret = 0;
+    size_t sz = 0;
 
-    purc_variant_t *members;
-    size_t sz;
-    members = tuple_members(v, &sz);
-    if (sz == 0) {
-        ret = 0;
-        goto out;
-    }
-    for (idx = 0; idx < sz; idx++) {
-        ov = members[idx];
-        if (k) {
-            snprintf(key, BUFF_KEY, "%s[%ld]", k, idx);
-        }
-        else if (numeric_prefix) {
-            snprintf(key, BUFF_KEY, "%s%ld", numeric_prefix, idx);
+    purc_variant_linear_container_size(v, &sz);
+    for (size_t idx = 0; idx < sz; idx++) {
+        purc_variant_t ov = purc_variant_linear_container_get(v, idx);
+        char index[24];
+        snprintf(index, sizeof(index), "%zu", idx);
+
+        ssize_t old_len;
+        if (has_key) {
+            old_len = push_key(qb, "[", index, "]");
         }
         else {
-            snprintf(key, BUFF_KEY, "%ld", idx);
+            old_len = push_key(qb, qb->numeric_prefix, index, NULL);
         }
-
-        if (purc_rwstream_tell(rws) > 0) {
-            purc_rwstream_write(rws, &arg_separator, 1);
+        if (old_len < 0) {
+            ret = -1;
+            break;
         }
 
-        ret = build_query(rws, key, ov, numeric_prefix,
-                arg_separator, flags);
+        write_separator(qb);
+        ret = build_query(qb, ov, true);
+        qb->len_key = old_len;
         if (ret != PURC_ERROR_OK) {
-            goto out;
+            break;
         }
     }
 
-out:
     return ret;
 }
 
 static int
-build_query(purc_rwstream_t rws, const char *k, purc_variant_t v,
-        const char *numeric_prefix, char arg_separator,
-        unsigned int flags)
+build_query(struct query_builder *qb, purc_variant_t v, bool has_key)
 {
     enum purc_variant_type type;
-    int ret = -1;
-    char *key = NULL;
-    size_t len_expected = 0;
-    unsigned int serialize_flags;
-    char buff[2];
-
-    if (flags & PCUTILS_URL_OPT_REAL_EJSON) {
-        serialize_flags = PCVRNT_SERIALIZE_OPT_REAL_EJSON;
-    }
-    else {
-        serialize_flags = PCVRNT_SERIALIZE_OPT_REAL_JSON;
-    }
+    const char *s;
+    size_t len;
 
     type = purc_variant_get_type(v);
     switch (type) {
+    case PURC_VARIANT_TYPE_OBJECT:
+        return encode_object(qb, v, has_key);
+
+    case PURC_VARIANT_TYPE_ARRAY:
+    case PURC_VARIANT_TYPE_SET:
+    case PURC_VARIANT_TYPE_TUPLE:
+        return encode_linear_container(qb, v, has_key);
+
     case PURC_VARIANT_TYPE_UNDEFINED:
     case PURC_VARIANT_TYPE_NULL:
     case PURC_VARIANT_TYPE_BOOLEAN:
@@ -662,176 +611,48 @@ build_query(purc_rwstream_t rws, const char *k, purc_variant_t v,
     case PURC_VARIANT_TYPE_BSEQUENCE:
     case PURC_VARIANT_TYPE_DYNAMIC:
     case PURC_VARIANT_TYPE_NATIVE:
-        {
-            if (k) {
-                key = strdup(k);
-            }
-            else if (numeric_prefix) {
-                key = (char*)malloc(strlen(numeric_prefix) + 2);
-#if 0
-                sprintf(key, "%s0", numeric_prefix);
-#else
-                strcpy(key, numeric_prefix);
-                strcat(key, "0");
-#endif
-            }
-            else {
-#if 0
-                key = (char*)malloc(2);
-#else
-                key = buff;
-#endif
-                key[0] = '0';
-                key[1] = 0;
-            }
-
-            if (!key) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                goto out;
-            }
-
-            encode_string(rws, key, flags);
-            purc_rwstream_write(rws, "=", 1);
-            ssize_t r = purc_variant_serialize(v, rws, 0, serialize_flags,
-                    &len_expected);
-            ret = r != -1 ? 0 : -1;
-        }
+    case PURC_VARIANT_TYPE_EXCEPTION:
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+    case PURC_VARIANT_TYPE_STRING:
         break;
 
+    default:
+        return -1;
+    }
+
+    /* a scalar at the top level */
+    if (!has_key) {
+        if (push_key(qb, qb->numeric_prefix, "0", NULL) < 0)
+            return -1;
+    }
+
+    encode_string(qb->rws, qb->key, qb->len_key, qb->flags);
+    purc_rwstream_write(qb->rws, "=", 1);
+
+    switch (type) {
     case PURC_VARIANT_TYPE_EXCEPTION:
-        {
-            if (k) {
-                key = strdup(k);
-            }
-            else if (numeric_prefix) {
-                key = (char*)malloc(strlen(numeric_prefix) + 2);
-#if 0
-                sprintf(key, "%s0", numeric_prefix);
-#else
-                strcpy(key, numeric_prefix);
-                strcat(key, "0");
-#endif
-            }
-            else {
-#if 0
-                key = (char*)malloc(2);
-#else
-                key = buff;
-#endif
-                key[0] = '0';
-                key[1] = 0;
-            }
-
-            if (!key) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                goto out;
-            }
-
-            encode_string(rws, key, flags);
-            purc_rwstream_write(rws, "=", 1);
-            const char *s = purc_variant_get_exception_string_const(v);
-            encode_string(rws, s, flags);
-        }
+        s = purc_variant_get_exception_string_const(v);
+        encode_string(qb->rws, s, strlen(s), qb->flags);
         break;
 
     case PURC_VARIANT_TYPE_ATOMSTRING:
-        {
-            if (k) {
-                key = strdup(k);
-            }
-            else if (numeric_prefix) {
-                key = (char*)malloc(strlen(numeric_prefix) + 2);
-#if 0
-                sprintf(key, "%s0", numeric_prefix);
-#else
-                strcpy(key, numeric_prefix);
-                strcat(key, "0");
-#endif
-            }
-            else {
-#if 0
-                key = (char*)malloc(2);
-#else
-                key = buff;
-#endif
-                key[0] = '0';
-                key[1] = 0;
-            }
-
-            if (!key) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                goto out;
-            }
-
-            encode_string(rws, key, flags);
-            purc_rwstream_write(rws, "=", 1);
-            const char *s = purc_variant_get_atom_string_const(v);
-            encode_string(rws, s, flags);
-        }
+        s = purc_variant_get_atom_string_const(v);
+        encode_string(qb->rws, s, strlen(s), qb->flags);
         break;
 
     case PURC_VARIANT_TYPE_STRING:
-        {
-            if (k) {
-                key = strdup(k);
-            }
-            else if (numeric_prefix) {
-                key = (char*)malloc(strlen(numeric_prefix) + 2);
-#if 0
-                sprintf(key, "%s0", numeric_prefix);
-#else
-                strcpy(key, numeric_prefix);
-                strcat(key, "0");
-#endif
-            }
-            else {
-#if 0
-                key = (char*)malloc(2);
-#else
-                key = buff;
-#endif
-                key[0] = '0';
-                key[1] = 0;
-            }
-
-            if (!key) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                goto out;
-            }
-
-            encode_string(rws, key, flags);
-            purc_rwstream_write(rws, "=", 1);
-            const char *s = purc_variant_get_string_const(v);
-            ret = encode_string(rws, s, flags);
-        }
+        s = purc_variant_get_string_const_ex(v, &len);
+        encode_string(qb->rws, s, len, qb->flags);
         break;
 
-
-    case PURC_VARIANT_TYPE_OBJECT:
-        ret = encode_object(rws, k, v, numeric_prefix, arg_separator,
-                flags);
-        break;
-    case PURC_VARIANT_TYPE_ARRAY:
-        ret = encode_array(rws, k, v, numeric_prefix, arg_separator,
-                flags);
-        break;
-    case PURC_VARIANT_TYPE_SET:
-        ret = encode_set(rws, k, v, numeric_prefix, arg_separator,
-                flags);
-        break;
-    case PURC_VARIANT_TYPE_TUPLE:
-        ret = encode_tuple(rws, k, v, numeric_prefix, arg_separator,
-                flags);
-        break;
     default:
+        if (purc_variant_serialize(v, qb->rws, 0, qb->serialize_flags,
+                    NULL) == -1)
+            return -1;
         break;
     }
 
-out:
-    if (key && key != buff) {
-        free(key);
-    }
-    return ret;
+    return 0;
 }
 
 purc_variant_t
@@ -850,7 +671,29 @@ pcutils_url_build_query(purc_variant_t v, const char *numeric_prefix,
         goto out;
     }
 
-    err = build_query(rws, NULL, v, numeric_prefix, arg_separator, flags);
+    struct query_builder qb;
+    qb.rws = rws;
+    qb.numeric_prefix = numeric_prefix;
+    qb.arg_separator = arg_separator;
+    qb.flags = flags;
+    if (flags & PCUTILS_URL_OPT_REAL_EJSON) {
+        qb.serialize_flags = PCVRNT_SERIALIZE_OPT_REAL_EJSON;
+    }
+    else {
+        qb.serialize_flags = PCVRNT_SERIALIZE_OPT_REAL_JSON;
+    }
+    qb.len_key = 0;
+    qb.sz_key = BUFF_KEY;
+    qb.key = (char *)malloc(qb.sz_key);
+    if (!qb.key) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        purc_rwstream_destroy(rws);
+        goto out;
+    }
+    qb.key[0] = 0;
+
+    err = build_query(&qb, v, false);
+    free(qb.key);
     if (err == PURC_ERROR_OK) {
         size_t sz_buffer = 0;
         size_t sz_content = 0;
@@ -21,6 +21,7 @@
 
 #include "purc-errors.h"
 #include "private/utils.h"
+#include "private/dtoa.h"
 #include "private/errors.h"
 #include "private/printbuf.h"
 #include "private/debug.h"
@@ -301,7 +302,7 @@ int pcutils_parse_double(const char *buf, size_t len, double *retval)
 
     COPY_STRING(buf, len);
 
-    *retval = strtod(buf, &end);
+    *retval = pcutils_strtod(buf, &end);
     if (buf + len == end)
         return 0; // It worked
     return 1;
@@ -402,7 +402,14 @@ bool purc_variant_string_chars(purc_variant_t string, size_t *nr_chars)
         IS_TYPE(string, PURC_VARIANT_TYPE_ATOMSTRING) ||
         IS_TYPE(string, PURC_VARIANT_TYPE_EXCEPTION)) {
 
-        *nr_chars = string->extra_size;
+        if (string->flags & PCVRNT_FLAG_STRING_SHARED) {
+            /* extra_data is used by the owner */
+            *nr_chars = pcutils_string_utf8_chars(
+                    (const char *)string->sz_ptr[1], string->sz_ptr[0] - 1);
+        }
+        else {
+            *nr_chars = string->extra_size;
+        }
         return true;
     }
 
@@ -420,11 +427,77 @@ void pcvariant_string_release (purc_variant_t string)
             pcvariant_stat_set_extra_size (string, 0);
             free ((void *)string->sz_ptr[1]);
         }
+        else if (string->flags & PCVRNT_FLAG_STRING_SHARED) {
+            purc_variant_unref ((purc_variant_t)string->extra_data);
+            string->extra_data = NULL;
+        }
     }
     else
         pcinst_set_error (PCVRNT_ERROR_INVALID_TYPE);
 }
 
+purc_variant_t
+pcvariant_make_string_shared(purc_variant_t owner, const char *str,
+        size_t len)
+{
+    PC_ASSERT(owner && str && str[len] == '\0');
+
+    /* a short string is stored in the variant anyway */
+    if (len < PCVRNT_SZ_BYTES)
+        return purc_variant_make_string_ex(str, len, false);
+
+    /* do not make a chain of owners */
+    if (owner->type == PURC_VARIANT_TYPE_STRING &&
+            (owner->flags & PCVRNT_FLAG_STRING_SHARED))
+        owner = (purc_variant_t)owner->extra_data;
+
+    purc_variant_t value = pcvariant_get(PURC_VARIANT_TYPE_STRING);
+    if (value == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    /* VWNOTE: keep PCVRNT_FLAG_STRING_STATIC, so that the functions
+       accessing the buffer of a static string work for a shared one. */
+    value->type = PURC_VARIANT_TYPE_STRING;
+    value->flags = PCVRNT_FLAG_STRING_STATIC | PCVRNT_FLAG_STRING_SHARED;
+    value->refc = 1;
+    value->sz_ptr[0] = (uintptr_t)len + 1;
+    value->sz_ptr[1] = (uintptr_t)str;
+    value->extra_data = purc_variant_ref(owner);
+
+    return value;
+}
+
+bool pcvariant_string_unshare(purc_variant_t string)
+{
+    PC_ASSERT(IS_TYPE(string, PURC_VARIANT_TYPE_STRING));
+
+    if (!(string->flags & PCVRNT_FLAG_STRING_SHARED))
+        return true;
+
+    const char *str = (const char *)string->sz_ptr[1];
+    size_t sz = (size_t)string->sz_ptr[0];
+    char *new_buf = malloc(sz);
+    if (new_buf == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+    memcpy(new_buf, str, sz);
+
+    purc_variant_t owner = (purc_variant_t)string->extra_data;
+
+    string->flags = PCVRNT_FLAG_EXTRA_SIZE;
+    string->extra_size = pcutils_string_utf8_chars(new_buf, sz - 1);
+    string->sz_ptr[1] = (uintptr_t)new_buf;
+    // VWNOTE: sz_ptr[0] will be set in pcvariant_stat_set_extra_size
+    string->sz_ptr[0] = 0;
+    pcvariant_stat_set_extra_size(string, sz);
+
+    purc_variant_unref(owner);
+    return true;
+}
+
 purc_variant_t
 purc_variant_make_atom(purc_atom_t atom)
 {
@@ -74,6 +74,7 @@ struct reverse_checker {
     pcutils_map           *input;     // key/val: variant old /variant new
     pcutils_map           *cache;     // as above
     pcutils_map           *output;    // as above
+    pcutils_map           *checked;   // sets checked by their index
 };
 
 static purc_variant_t
@@ -253,6 +254,58 @@ rebuild_ex(purc_variant_t val, pcutils_map *cache)
     }
 }
 
+static void*
+ref(const void *v)
+{
+    return purc_variant_ref((purc_variant_t)v);
+}
+
+static void
+unref(void *v)
+{
+    purc_variant_unref((purc_variant_t)v);
+}
+
+/*
+ * A set which does not belong to another set is the top of the chain, so
+ * there is no need to rebuild it for the check: one lookup in its index
+ * with the new member tells whether the member is still unique.
+ *
+ * This only holds if one member of the set changes; when a second member
+ * of the same set shows up, fall back to rebuilding the whole set, which
+ * sees all new members in the cache. A conflict found by the lookup is
+ * confirmed by the rebuilding as well, which also sets the error.
+ */
+static bool
+check_set_by_index(purc_variant_t parent, struct set_node *node,
+        struct reverse_checker *checker)
+{
+    if (!purc_variant_is_set(parent) ||
+            pcvar_container_belongs_to_set(parent))
+        return false;
+
+    if (checker->checked == NULL) {
+        checker->checked = pcutils_map_create(ref, unref, NULL, NULL,
+                comp, false);
+        if (checker->checked == NULL)
+            return false;
+    }
+    else if (pcutils_map_find(checker->checked, parent)) {
+        return false;
+    }
+
+    struct pcutils_map_entry *p;
+    p = pcutils_map_find(checker->cache, node->val);
+    if (p == NULL)
+        return false;
+
+    if (!pcvar_set_is_unique_after_change(parent, node,
+                (purc_variant_t)p->val))
+        return false;
+
+    return pcutils_map_insert(checker->checked, parent, NULL) == 0;
+}
+
 static int
 reverse_check_chain(pcutils_map *chain, struct reverse_checker *checker)
 {
@@ -272,6 +325,12 @@ reverse_check_chain(pcutils_map *chain, struct reverse_checker *checker)
             purc_variant_t parent;
             parent = (purc_variant_t)entry->val;
 
+            if (check_set_by_index(parent, (struct set_node*)entry->key,
+                        checker)) {
+                pcutils_map_it_next(&it);
+                continue;
+            }
+
             // rebuild _new value for edge parent
             purc_variant_t _new = rebuild_ex(parent, checker->cache);
             if (_new == PURC_VARIANT_INVALID) {
@@ -382,18 +441,6 @@ again:
     goto again;
 }
 
-static void*
-ref(const void *v)
-{
-    return purc_variant_ref((purc_variant_t)v);
-}
-
-static void
-unref(void *v)
-{
-    purc_variant_unref((purc_variant_t)v);
-}
-
 int
 pcvar_reverse_check(purc_variant_t _old, purc_variant_t _new)
 {
@@ -433,6 +480,8 @@ pcvar_reverse_check(purc_variant_t _old, purc_variant_t _new)
         r = reverse_check(&checker);
     } while (0);
 
+    if (checker.checked)
+        pcutils_map_destroy(checker.checked);
     if (checker.output)
         pcutils_map_destroy(checker.output);
     if (checker.cache)
@@ -540,9 +589,49 @@ wind_up(struct reverse_checker *checker)
     return r ? -1 : 0;
 }
 
+/* readjust the sets directly if all parents of `val` are sets */
+static bool
+adjust_parent_sets(purc_variant_t val)
+{
+    struct pcutils_map *chain;
+    chain = get_chain(val);
+    if (!chain || pcutils_map_get_size(chain) == 0)
+        return true;
+
+    struct pcutils_map_entry *entry;
+    struct pcutils_map_iterator it;
+    bool all_sets = true;
+    it = pcutils_map_it_begin_first(chain);
+    while ((entry = pcutils_map_it_value(&it))) {
+        if (!purc_variant_is_set((purc_variant_t)entry->val)) {
+            all_sets = false;
+            break;
+        }
+        pcutils_map_it_next(&it);
+    }
+    pcutils_map_it_end(&it);
+
+    if (!all_sets)
+        return false;
+
+    it = pcutils_map_it_begin_first(chain);
+    while ((entry = pcutils_map_it_value(&it))) {
+        int r = pcvar_readjust_set((purc_variant_t)entry->val,
+                (struct set_node*)entry->key);
+        PC_ASSERT(r == 0);
+        pcutils_map_it_next(&it);
+    }
+    pcutils_map_it_end(&it);
+
+    return true;
+}
+
 void
 pcvar_adjust_set_by_descendant(purc_variant_t val)
 {
+    if (adjust_parent_sets(val))
+        return;
+
     copy_key_fn copy_key = ref;
     free_key_fn free_key = unref;
     copy_val_fn copy_val = ref;
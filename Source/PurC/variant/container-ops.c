@@ -25,12 +25,15 @@
 #include "config.h"
 #include "private/variant.h"
 #include "private/errors.h"
+#include "private/hashtable.h"
+#include "private/utils.h"
 #include "variant-internals.h"
 #include "purc-errors.h"
 #include "purc-utils.h"
 
 
 #include <limits.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
@@ -183,6 +186,7 @@ bool
 pcvariant_object_clear(purc_variant_t object, bool silently)
 {
     bool ret = false;
+    struct pcvar_batch *batch = NULL;
     if (object == PURC_VARIANT_INVALID) {
         SET_SILENT_ERROR(PURC_ERROR_INVALID_VALUE);
         goto end;
@@ -193,6 +197,7 @@ pcvariant_object_clear(purc_variant_t object, bool silently)
         goto end;
     }
 
+    batch = pcvariant_begin_batch(object);
     purc_variant_t key;
     purc_variant_t value;
     UNUSED_VARIABLE(value);
@@ -204,6 +209,7 @@ pcvariant_object_clear(purc_variant_t object, bool silently)
     ret = true;
 
 end:
+    pcvariant_end_batch(batch);
     return ret;
 }
 
@@ -211,6 +217,7 @@ bool
 pcvariant_array_clear(purc_variant_t array, bool silently)
 {
     bool ret = false;
+    struct pcvar_batch *batch = NULL;
     if (array == PURC_VARIANT_INVALID) {
         SET_SILENT_ERROR(PURC_ERROR_INVALID_VALUE);
         goto end;
@@ -221,6 +228,7 @@ pcvariant_array_clear(purc_variant_t array, bool silently)
         goto end;
     }
 
+    batch = pcvariant_begin_batch(array);
     purc_variant_t val;
     size_t curr;
     UNUSED_VARIABLE(val);
@@ -233,6 +241,7 @@ pcvariant_array_clear(purc_variant_t array, bool silently)
     ret = true;
 
 end:
+    pcvariant_end_batch(batch);
     return ret;
 }
 
@@ -240,6 +249,7 @@ bool
 pcvariant_set_clear(purc_variant_t set, bool silently)
 {
     bool ret = false;
+    struct pcvar_batch *batch = NULL;
     if (set == PURC_VARIANT_INVALID) {
         SET_SILENT_ERROR(PURC_ERROR_INVALID_VALUE);
         goto end;
@@ -250,6 +260,7 @@ pcvariant_set_clear(purc_variant_t set, bool silently)
         goto end;
     }
 
+    batch = pcvariant_begin_batch(set);
     purc_variant_t v;
     foreach_value_in_variant_set_safe(set, v)
         if (-1 == purc_variant_set_remove(set, v, PCVRNT_NR_METHOD_IGNORE)) {
@@ -259,6 +270,7 @@ pcvariant_set_clear(purc_variant_t set, bool silently)
     ret = true;
 
 end:
+    pcvariant_end_batch(batch);
     return ret;
 }
 
@@ -292,19 +304,6 @@ clone_if_necessary(purc_variant_t val)
     return purc_variant_ref(val);
 }
 
-static bool
-add_object_member(void* dst, purc_variant_t key,
-        purc_variant_t value, bool silently)
-{
-    UNUSED_PARAM(silently);
-    purc_variant_t cloned = clone_if_necessary(value);
-    if (cloned == PURC_VARIANT_INVALID)
-        return false;
-    bool ok = purc_variant_object_set((purc_variant_t)dst, key, cloned);
-    purc_variant_unref(cloned);
-    return ok;
-}
-
 static bool
 remove_object_member(void* dst, purc_variant_t key, purc_variant_t value,
         bool silently)
@@ -425,7 +424,8 @@ object_displace(purc_variant_t dst, purc_variant_t src, bool silently)
         goto end;
     }
 
-    if(!object_foreach(src, add_object_member, dst, silently)) {
+    if (pcvar_obj_merge(dst, src, PCVRNT_CR_METHOD_OVERWRITE,
+                clone_if_necessary) < 0) {
         goto end;
     }
     ret = true;
@@ -484,6 +484,225 @@ end:
     return ret;
 }
 
+/*
+ * The multiset of the members to remove from an array.
+ *
+ * purc_variant_compare_ex() with PCVRNT_COMPARE_METHOD_AUTO compares
+ * a member of the array with a member to remove as numbers when the former
+ * is a number, and as stringified texts otherwise. So when the members of
+ * the array are all numbers, we key the bag by the numerified values;
+ * when they are all non-numbers, by the stringified texts. Then every
+ * member of the array finds its equal in O(1), instead of comparing it
+ * with every member to remove.
+ */
+struct member_bag_slot {
+    bool        used;
+    size_t      count;
+    uint64_t    key;    // the bits of the number, or the hash of the text
+    double      number;
+    char       *text;
+};
+
+struct member_bag {
+    bool        numeric;
+    size_t      mask;
+    struct member_bag_slot *slots;
+};
+
+static inline bool
+is_numeric_variant(purc_variant_t v)
+{
+    enum purc_variant_type type = purc_variant_get_type(v);
+    return type == PURC_VARIANT_TYPE_NUMBER ||
+        type == PURC_VARIANT_TYPE_LONGINT ||
+        type == PURC_VARIANT_TYPE_ULONGINT ||
+        type == PURC_VARIANT_TYPE_LONGDOUBLE;
+}
+
+static inline uint64_t
+number_key(double d)
+{
+    union {
+        double      d;
+        uint64_t    u;
+    } bits;
+
+    bits.d = (d == 0) ? 0.0 : d;     // -0.0 equals to 0.0
+    return bits.u;
+}
+
+static inline size_t
+key_to_slot(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key;
+}
+
+static bool
+member_bag_init(struct member_bag *bag, bool numeric, size_t nr_members)
+{
+    size_t nr_slots = 16;
+    while (nr_slots < nr_members * 2)
+        nr_slots <<= 1;
+
+    bag->numeric = numeric;
+    bag->mask = nr_slots - 1;
+    bag->slots = calloc(nr_slots, sizeof(struct member_bag_slot));
+    if (bag->slots == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+
+    return true;
+}
+
+static void
+member_bag_release(struct member_bag *bag)
+{
+    for (size_t i = 0; i <= bag->mask; i++) {
+        if (bag->slots[i].text)
+            free(bag->slots[i].text);
+    }
+    free(bag->slots);
+}
+
+static char *
+member_bag_stringify(purc_variant_t v, uint64_t *key)
+{
+    char *text = NULL;
+    if (purc_variant_stringify_alloc(&text, v) < 0 || text == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    *key = pchash_fnv1a_str_hash(text);
+    return text;
+}
+
+static struct member_bag_slot *
+member_bag_find_text(struct member_bag *bag, uint64_t key, const char *text)
+{
+    size_t i = key_to_slot(key) & bag->mask;
+    while (bag->slots[i].used) {
+        struct member_bag_slot *slot = bag->slots + i;
+        if (slot->key == key && strcmp(slot->text, text) == 0)
+            return slot;
+        i = (i + 1) & bag->mask;
+    }
+
+    return bag->slots + i;
+}
+
+static struct member_bag_slot *
+member_bag_find_number(struct member_bag *bag, uint64_t key)
+{
+    size_t i = key_to_slot(key) & bag->mask;
+    while (bag->slots[i].used) {
+        if (bag->slots[i].key == key)
+            return bag->slots + i;
+        i = (i + 1) & bag->mask;
+    }
+
+    return bag->slots + i;
+}
+
+static bool
+member_bag_add(struct member_bag *bag, purc_variant_t v)
+{
+    struct member_bag_slot *slot;
+
+    if (bag->numeric) {
+        double d = purc_variant_numerify(v);
+        if (isnan(d))       // NaN equals to nothing
+            return true;
+
+        uint64_t key = number_key(d);
+        slot = member_bag_find_number(bag, key);
+        if (!slot->used) {
+            slot->used = true;
+            slot->key = key;
+            slot->number = d;
+        }
+    }
+    else {
+        uint64_t key;
+        char *text = member_bag_stringify(v, &key);
+        if (text == NULL)
+            return false;
+
+        slot = member_bag_find_text(bag, key, text);
+        if (slot->used) {
+            free(text);
+        }
+        else {
+            slot->used = true;
+            slot->key = key;
+            slot->text = text;
+        }
+    }
+
+    slot->count++;
+    return true;
+}
+
+/* Takes one member equal to v out of the bag; returns 1 if there is one,
+   0 if there is none, and -1 on failure. */
+static int
+member_bag_take(struct member_bag *bag, purc_variant_t v)
+{
+    struct member_bag_slot *slot;
+
+    if (bag->numeric) {
+        double d = purc_variant_numerify(v);
+        if (isnan(d))
+            return 0;
+
+        /* pcutils_equal_doubles() treats the numbers which are at most
+           two units in the last place apart as equal. */
+        static const int64_t deltas[] = { 0, -1, 1, -2, 2 };
+        uint64_t key = number_key(d);
+        for (size_t i = 0; i < PCA_TABLESIZE(deltas); i++) {
+            slot = member_bag_find_number(bag, key + deltas[i]);
+            if (slot->used && slot->count > 0 &&
+                    pcutils_equal_doubles(d, slot->number)) {
+                slot->count--;
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    uint64_t key;
+    char *text = member_bag_stringify(v, &key);
+    if (text == NULL)
+        return -1;
+
+    slot = member_bag_find_text(bag, key, text);
+    free(text);
+    if (slot->used && slot->count > 0) {
+        slot->count--;
+        return 1;
+    }
+
+    return 0;
+}
+
+static bool
+array_remove_linear(purc_variant_t dst, purc_variant_t src, size_t nr_src,
+        bool silently)
+{
+    for (size_t i = 0; i < nr_src; i++) {
+        purc_variant_t v = purc_variant_linear_container_get(src, i);
+        if (!remove_array_member(dst, v, PURC_VARIANT_INVALID, silently))
+            return false;
+    }
+
+    return true;
+}
+
 static bool
 array_remove(purc_variant_t dst, purc_variant_t src, bool silently)
 {
@@ -497,16 +716,67 @@ array_remove(purc_variant_t dst, purc_variant_t src, bool silently)
         goto end;
     }
 
-    if (type == PURC_VARIANT_TYPE_ARRAY) {
-        ret = array_foreach(src, remove_array_member, dst, silently);
+    size_t nr_src = 0, nr_dst = 0;
+    purc_variant_linear_container_size(src, &nr_src);
+    purc_variant_array_size(dst, &nr_dst);
+    if (nr_src == 0 || nr_dst == 0) {
+        ret = true;
+        goto end;
     }
-    else if (type == PURC_VARIANT_TYPE_SET) {
-        ret = set_foreach(src, remove_array_member, dst, silently);
+
+    /* The members of the array are compared as numbers or as texts,
+       depending on their types. If they are mixed, or there are only
+       a few members, we fall back to the linear searching. */
+    size_t nr_numeric = 0;
+    for (size_t i = 0; i < nr_dst; i++) {
+        if (is_numeric_variant(purc_variant_array_get(dst, i)))
+            nr_numeric++;
     }
-    else {
-        ret = tuple_foreach(src, append_array_member, dst, silently);
+
+    if ((nr_numeric > 0 && nr_numeric < nr_dst) || nr_src * nr_dst <= 64) {
+        ret = array_remove_linear(dst, src, nr_src, silently);
+        goto end;
+    }
+
+    struct member_bag bag;
+    if (!member_bag_init(&bag, nr_numeric > 0, nr_src))
+        goto end;
+
+    uint8_t *marks = NULL;
+    for (size_t i = 0; i < nr_src; i++) {
+        if (!member_bag_add(&bag,
+                    purc_variant_linear_container_get(src, i)))
+            goto done;
+    }
+
+    marks = calloc(nr_dst, sizeof(uint8_t));
+    if (marks == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto done;
     }
 
+    /* The members to remove take the first equal members of the array,
+       the same as removing them one by one in order. */
+    size_t nr_marked = 0;
+    for (size_t i = 0; i < nr_dst; i++) {
+        int r = member_bag_take(&bag, purc_variant_array_get(dst, i));
+        if (r < 0)
+            goto done;
+        if (r > 0) {
+            marks[i] = 1;
+            nr_marked++;
+        }
+    }
+
+    if (nr_marked > 0 && pcvar_arr_remove_marked(dst, marks, nr_dst))
+        goto done;
+
+    ret = true;
+
+done:
+    free(marks);
+    member_bag_release(&bag);
+
 end:
     return ret;
 }
@@ -629,6 +899,7 @@ pcvariant_container_displace(purc_variant_t dst,
         goto end;
     }
 
+    struct pcvar_batch *batch = pcvariant_begin_batch(dst);
     enum purc_variant_type type = purc_variant_get_type(dst);
     switch (type) {
         case PURC_VARIANT_TYPE_OBJECT:
@@ -647,6 +918,7 @@ pcvariant_container_displace(purc_variant_t dst,
             SET_SILENT_ERROR(PURC_ERROR_WRONG_DATA_TYPE);
             break;
     }
+    pcvariant_end_batch(batch);
 
 end:
     return ret;
@@ -668,6 +940,7 @@ pcvariant_container_remove(purc_variant_t dst,
         goto end;
     }
 
+    struct pcvar_batch *batch = pcvariant_begin_batch(dst);
     enum purc_variant_type type = purc_variant_get_type(dst);
     switch (type) {
         case PURC_VARIANT_TYPE_OBJECT:
@@ -686,6 +959,7 @@ pcvariant_container_remove(purc_variant_t dst,
             SET_SILENT_ERROR(PURC_ERROR_WRONG_DATA_TYPE);
             break;
     }
+    pcvariant_end_batch(batch);
 
 end:
     return ret;
@@ -712,10 +986,9 @@ pcvariant_array_append_another(purc_variant_t array,
         goto end;
     }
 
-    if(!array_foreach(another, append_array_member, array, silently)) {
-        goto end;
-    }
-    ret = true;
+    struct pcvar_batch *batch = pcvariant_begin_batch(array);
+    ret = array_foreach(another, append_array_member, array, silently);
+    pcvariant_end_batch(batch);
 
 end:
     return ret;
@@ -742,10 +1015,10 @@ pcvariant_array_prepend_another(purc_variant_t array,
         goto end;
     }
 
-    if(!array_reverse_foreach(another, prepend_array_member, array, silently)) {
-        goto end;
-    }
-    ret = true;
+    struct pcvar_batch *batch = pcvariant_begin_batch(array);
+    ret = array_reverse_foreach(another, prepend_array_member, array,
+            silently);
+    pcvariant_end_batch(batch);
 
 end:
     return ret;
@@ -776,8 +1049,10 @@ pcvariant_array_insert_another_before(purc_variant_t array, int idx,
     struct complex_ctxt c_ctxt;
     c_ctxt.ctxt = (uintptr_t) array;
     c_ctxt.extra = idx;
+    struct pcvar_batch *batch = pcvariant_begin_batch(array);
     ret = array_reverse_foreach(another, insert_before_array_member, &c_ctxt,
             silently);
+    pcvariant_end_batch(batch);
 end:
     return ret;
 }
@@ -807,8 +1082,10 @@ pcvariant_array_insert_another_after(purc_variant_t array, int idx,
     struct complex_ctxt c_ctxt;
     c_ctxt.ctxt = (uintptr_t) array;
     c_ctxt.extra = idx;
+    struct pcvar_batch *batch = pcvariant_begin_batch(array);
     ret = array_reverse_foreach(another, insert_after_array_member, &c_ctxt,
             silently);
+    pcvariant_end_batch(batch);
 
 end:
     return ret;
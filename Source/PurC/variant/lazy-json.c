@@ -0,0 +1,934 @@
+/**
+ * @file lazy-json.c
+ * @date 2026/10/18
+ * @brief The lazy loader of JSON documents.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "private/variant.h"
+#include "private/errors.h"
+#include "private/ejson.h"
+#include "private/dtoa.h"
+#include "purc-variant.h"
+#include "purc-utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * A lazy document keeps the text of a plain JSON document and a compact
+ * structural index of it: one node for every value (and every key) in
+ * the document order, so that the members of a container follow it, and
+ * `next` of a node skips its subtree.
+ *
+ * An object is represented by a native entity which only creates the
+ * variants of the members when they are accessed. An array, or an object
+ * to be changed, is materialized with the whole subtree; the materialized
+ * containers are recorded in `variants`, and all later accesses to them
+ * go to the variants, so the changes are visible from the lazy parents.
+ * The keys of a lazy object are sorted into `keys` when a member of it
+ * is accessed the first time, so a lookup does not scan the members.
+ *
+ * The loader falls back to the eJSON parser if the text is not plain
+ * JSON, or it contains a string with a `$` which may be substituted.
+ */
+
+#define LAZY_JSON_NAME          "lazy-json"
+#define LAZY_JSON_MAX_DEPTH     PCEJSON_DEFAULT_DEPTH
+#define LAZY_JSON_READ_SIZE     8192
+
+enum {
+    LJN_NULL = 0,
+    LJN_FALSE,
+    LJN_TRUE,
+    LJN_NUMBER,
+    LJN_STRING,
+    LJN_ARRAY,
+    LJN_OBJECT,
+};
+
+struct lj_node {
+    uint8_t         type;
+    /* for strings: whether there is any escape sequence */
+    uint8_t         escaped;
+    /* for containers: the number of members or items */
+    uint32_t        nr_children;
+    /* the index of the node after the subtree */
+    size_t          next;
+    /* the position in the text; the quotes are excluded for strings */
+    size_t          offset;
+    size_t          length;
+};
+
+/* a key of an object; the escaped keys are decoded into `decoded` */
+struct lj_key {
+    const char     *name;
+    size_t          len;
+    /* the index of the value node */
+    size_t          value;
+};
+
+struct lj_keys {
+    char           *decoded;
+    size_t          nr_keys;
+    struct lj_key   keys[];
+};
+
+struct lj_doc {
+    unsigned int    refc;
+
+    char           *text;
+    size_t          len_text;
+
+    struct lj_node *nodes;
+    size_t          nr_nodes;
+    size_t          sz_nodes;
+
+    /* the materialized containers, indexed by the nodes; nullable */
+    purc_variant_t *variants;
+    /* the sorted keys of the objects, indexed by the nodes; nullable */
+    struct lj_keys **keys;
+};
+
+struct lj_entity {
+    struct lj_doc  *doc;
+    size_t          idx;
+};
+
+static void
+doc_unref(struct lj_doc *doc)
+{
+    if (--doc->refc > 0)
+        return;
+
+    if (doc->variants) {
+        for (size_t i = 0; i < doc->nr_nodes; i++) {
+            if (doc->variants[i])
+                purc_variant_unref(doc->variants[i]);
+        }
+        free(doc->variants);
+    }
+
+    if (doc->keys) {
+        for (size_t i = 0; i < doc->nr_nodes; i++) {
+            if (doc->keys[i]) {
+                free(doc->keys[i]->decoded);
+                free(doc->keys[i]);
+            }
+        }
+        free(doc->keys);
+    }
+
+    free(doc->nodes);
+    free(doc->text);
+    free(doc);
+}
+
+static char *
+read_whole_stream(purc_rwstream_t stream, size_t *len)
+{
+    char *buf = NULL;
+    size_t sz = 0, n = 0;
+
+    for (;;) {
+        if (sz - n < LAZY_JSON_READ_SIZE + 1) {
+            size_t new_sz = sz ? sz * 2 : LAZY_JSON_READ_SIZE * 2;
+            char *new_buf = realloc(buf, new_sz);
+            if (new_buf == NULL) {
+                free(buf);
+                pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return NULL;
+            }
+            buf = new_buf;
+            sz = new_sz;
+        }
+
+        ssize_t r = purc_rwstream_read(stream, buf + n, sz - n - 1);
+        if (r <= 0)
+            break;
+        n += r;
+    }
+
+    /* read the null character as the end of the document */
+    buf[n] = 0;
+    *len = strlen(buf);
+    return buf;
+}
+
+static int
+add_node(struct lj_doc *doc, int type, size_t offset)
+{
+    if (doc->nr_nodes == doc->sz_nodes) {
+        size_t sz = doc->sz_nodes * 2;
+        struct lj_node *nodes = realloc(doc->nodes, sz * sizeof(*nodes));
+        if (nodes == NULL)
+            return -1;
+        doc->nodes = nodes;
+        doc->sz_nodes = sz;
+    }
+
+    struct lj_node *node = doc->nodes + doc->nr_nodes++;
+    node->type = type;
+    node->escaped = 0;
+    node->nr_children = 0;
+    node->next = doc->nr_nodes;
+    node->offset = offset;
+    node->length = 0;
+    return 0;
+}
+
+static inline const char *
+skip_spaces(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+        p++;
+    return p;
+}
+
+static int
+read_hex4(const char *p, const char *end, uint32_t *uc)
+{
+    if (end - p < 4)
+        return -1;
+
+    *uc = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        *uc <<= 4;
+        if (c >= '0' && c <= '9')
+            *uc |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            *uc |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            *uc |= c - 'A' + 10;
+        else
+            return -1;
+    }
+
+    return 0;
+}
+
+/* returns the closing quote of the string started at p, or NULL */
+static const char *
+scan_string(const char *p, const char *end, bool *escaped)
+{
+    uint32_t uc, low;
+
+    while (p < end) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"')
+            return p;
+
+        if (c < 0x20 || c == '$')
+            return NULL;
+
+        if (c != '\\') {
+            p++;
+            continue;
+        }
+
+        *escaped = true;
+        if (++p >= end)
+            return NULL;
+
+        switch (*p) {
+        case '"': case '\\': case '/':
+        case 'b': case 'f': case 'n': case 'r': case 't':
+            p++;
+            break;
+
+        case 'u':
+            if (read_hex4(p + 1, end, &uc))
+                return NULL;
+            p += 5;
+
+            if (uc >= 0xDC00 && uc <= 0xDFFF)
+                return NULL;
+
+            /* a high surrogate must be followed by a low one */
+            if (uc >= 0xD800 && uc <= 0xDBFF) {
+                if (end - p < 2 || p[0] != '\\' || p[1] != 'u' ||
+                        read_hex4(p + 2, end, &low) ||
+                        low < 0xDC00 || low > 0xDFFF)
+                    return NULL;
+                p += 6;
+            }
+            break;
+
+        default:
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+static const char *
+scan_digits(const char *p, const char *end)
+{
+    const char *start = p;
+    while (p < end && *p >= '0' && *p <= '9')
+        p++;
+    return (p == start) ? NULL : p;
+}
+
+/* returns the end of the number started at p, or NULL */
+static const char *
+scan_number(const char *p, const char *end)
+{
+    if (*p == '-')
+        p++;
+
+    if (p < end && *p == '0')
+        p++;
+    else if ((p = scan_digits(p, end)) == NULL)
+        return NULL;
+
+    if (p < end && *p == '.') {
+        if ((p = scan_digits(p + 1, end)) == NULL)
+            return NULL;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p < end && (*p == '+' || *p == '-'))
+            p++;
+        if ((p = scan_digits(p, end)) == NULL)
+            return NULL;
+    }
+
+    return p;
+}
+
+/* the container on the top of the stack gets a new member or item */
+static inline int
+count_child(struct lj_doc *doc, const size_t *stack, int depth)
+{
+    if (depth > 0) {
+        struct lj_node *top = doc->nodes + stack[depth - 1];
+        if (top->nr_children == UINT32_MAX)
+            return -1;
+        top->nr_children++;
+    }
+    return 0;
+}
+
+static inline bool
+in_array(struct lj_doc *doc, const size_t *stack, int depth)
+{
+    return depth > 0 && doc->nodes[stack[depth - 1]].type == LJN_ARRAY;
+}
+
+static int
+build_index(struct lj_doc *doc)
+{
+    const char *start = doc->text;
+    const char *end = start + doc->len_text;
+    const char *p, *q;
+    size_t stack[LAZY_JSON_MAX_DEPTH];
+    int depth = 0;
+    struct lj_node *top;
+    bool escaped;
+    int type;
+
+    /* a rough estimation to avoid reallocating too many times */
+    doc->sz_nodes = doc->len_text / 16 + 16;
+    doc->nodes = malloc(doc->sz_nodes * sizeof(struct lj_node));
+    if (doc->nodes == NULL)
+        goto failed;
+
+    p = skip_spaces(start, end);
+
+value:
+    if (p >= end)
+        goto failed;
+
+    /* the members of objects are counted by the keys */
+    if (in_array(doc, stack, depth) && count_child(doc, stack, depth))
+        goto failed;
+
+    switch (*p) {
+    case '{':
+    case '[':
+        if (depth == LAZY_JSON_MAX_DEPTH)
+            goto failed;
+
+        type = (*p == '{') ? LJN_OBJECT : LJN_ARRAY;
+        if (add_node(doc, type, p - start))
+            goto failed;
+        stack[depth++] = doc->nr_nodes - 1;
+
+        p = skip_spaces(p + 1, end);
+        if (p < end && (*p == '}' || *p == ']'))
+            goto close;
+        if (type == LJN_OBJECT)
+            goto key;
+        goto value;
+
+    case '"':
+        escaped = false;
+        if ((q = scan_string(p + 1, end, &escaped)) == NULL ||
+                add_node(doc, LJN_STRING, p + 1 - start))
+            goto failed;
+        doc->nodes[doc->nr_nodes - 1].escaped = escaped;
+        doc->nodes[doc->nr_nodes - 1].length = q - p - 1;
+        p = q + 1;
+        break;
+
+    case 't':
+        if (end - p < 4 || memcmp(p, "true", 4) ||
+                add_node(doc, LJN_TRUE, p - start))
+            goto failed;
+        p += 4;
+        break;
+
+    case 'f':
+        if (end - p < 5 || memcmp(p, "false", 5) ||
+                add_node(doc, LJN_FALSE, p - start))
+            goto failed;
+        p += 5;
+        break;
+
+    case 'n':
+        if (end - p < 4 || memcmp(p, "null", 4) ||
+                add_node(doc, LJN_NULL, p - start))
+            goto failed;
+        p += 4;
+        break;
+
+    default:
+        if ((q = scan_number(p, end)) == NULL ||
+                add_node(doc, LJN_NUMBER, p - start))
+            goto failed;
+        doc->nodes[doc->nr_nodes - 1].length = q - p;
+        p = q;
+        break;
+    }
+
+after_value:
+    p = skip_spaces(p, end);
+    if (depth == 0)
+        return (p == end) ? 0 : -1;
+
+    if (p >= end)
+        goto failed;
+
+    if (*p == ',') {
+        p = skip_spaces(p + 1, end);
+        if (doc->nodes[stack[depth - 1]].type == LJN_OBJECT)
+            goto key;
+        goto value;
+    }
+
+close:
+    top = doc->nodes + stack[depth - 1];
+    if (*p != ((top->type == LJN_OBJECT) ? '}' : ']'))
+        goto failed;
+    top->length = p + 1 - start - top->offset;
+    top->next = doc->nr_nodes;
+    depth--;
+    p++;
+    goto after_value;
+
+key:
+    if (p >= end || *p != '"' || count_child(doc, stack, depth))
+        goto failed;
+
+    escaped = false;
+    if ((q = scan_string(p + 1, end, &escaped)) == NULL ||
+            add_node(doc, LJN_STRING, p + 1 - start))
+        goto failed;
+    doc->nodes[doc->nr_nodes - 1].escaped = escaped;
+    doc->nodes[doc->nr_nodes - 1].length = q - p - 1;
+
+    p = skip_spaces(q + 1, end);
+    if (p >= end || *p != ':')
+        goto failed;
+    p = skip_spaces(p + 1, end);
+    goto value;
+
+failed:
+    return -1;
+}
+
+/* decode the escaped string into buf, which has len + 1 bytes at least;
+   returns the length of the result, which is never longer than the text */
+static size_t
+decode_string_to(const char *p, size_t len, char *buf)
+{
+    const char *end = p + len;
+    char *d = buf;
+    uint32_t uc, low;
+
+    while (p < end) {
+        if (*p != '\\') {
+            *d++ = *p++;
+            continue;
+        }
+
+        p++;
+        switch (*p) {
+        case 'b': *d++ = '\b'; p++; break;
+        case 'f': *d++ = '\f'; p++; break;
+        case 'n': *d++ = '\n'; p++; break;
+        case 'r': *d++ = '\r'; p++; break;
+        case 't': *d++ = '\t'; p++; break;
+        case 'u':
+            read_hex4(p + 1, end, &uc);
+            p += 5;
+            if (uc >= 0xD800 && uc <= 0xDBFF) {
+                read_hex4(p + 2, end, &low);
+                uc = 0x10000 + ((uc - 0xD800) << 10) + (low - 0xDC00);
+                p += 6;
+            }
+            d += pcutils_unichar_to_utf8(uc, (unsigned char *)d);
+            break;
+        default:
+            *d++ = *p++;
+            break;
+        }
+    }
+
+    *d = 0;
+    return d - buf;
+}
+
+static char *
+decode_string(const char *p, size_t len, size_t *len_decoded)
+{
+    char *buf = malloc(len + 1);
+    if (buf)
+        *len_decoded = decode_string_to(p, len, buf);
+    return buf;
+}
+
+static purc_variant_t
+make_string(struct lj_doc *doc, const struct lj_node *node)
+{
+    const char *p = doc->text + node->offset;
+
+    if (!node->escaped)
+        return purc_variant_make_string_ex(p, node->length, false);
+
+    size_t len;
+    char *buf = decode_string(p, node->length, &len);
+    if (buf == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    return purc_variant_make_string_reuse_buff(buf, len + 1, false);
+}
+
+/* materialize the subtree of the node; the containers are recorded */
+static purc_variant_t
+materialize(struct lj_doc *doc, size_t idx)
+{
+    const struct lj_node *node = doc->nodes + idx;
+    purc_variant_t ctnr = PURC_VARIANT_INVALID;
+    size_t i, n;
+
+    switch (node->type) {
+    case LJN_NULL:
+        return purc_variant_make_null();
+    case LJN_FALSE:
+        return purc_variant_make_boolean(false);
+    case LJN_TRUE:
+        return purc_variant_make_boolean(true);
+    case LJN_NUMBER:
+        return purc_variant_make_number(
+                pcutils_strtod(doc->text + node->offset, NULL));
+    case LJN_STRING:
+        return make_string(doc, node);
+    default:
+        break;
+    }
+
+    if (doc->variants == NULL) {
+        doc->variants = calloc(doc->nr_nodes, sizeof(purc_variant_t));
+        if (doc->variants == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    if (doc->variants[idx])
+        return purc_variant_ref(doc->variants[idx]);
+
+    if (node->type == LJN_ARRAY) {
+        ctnr = purc_variant_make_array_0();
+        if (ctnr == PURC_VARIANT_INVALID)
+            goto failed;
+
+        for (i = idx + 1, n = 0; n < node->nr_children;
+                i = doc->nodes[i].next, n++) {
+            purc_variant_t v = materialize(doc, i);
+            if (v == PURC_VARIANT_INVALID)
+                goto failed;
+
+            bool ok = purc_variant_array_append(ctnr, v);
+            purc_variant_unref(v);
+            if (!ok)
+                goto failed;
+        }
+    }
+    else {
+        ctnr = purc_variant_make_object_0();
+        if (ctnr == PURC_VARIANT_INVALID)
+            goto failed;
+
+        for (i = idx + 1, n = 0; n < node->nr_children;
+                i = doc->nodes[i + 1].next, n++) {
+            purc_variant_t k = make_string(doc, doc->nodes + i);
+            if (k == PURC_VARIANT_INVALID)
+                goto failed;
+
+            purc_variant_t v = materialize(doc, i + 1);
+            if (v == PURC_VARIANT_INVALID) {
+                purc_variant_unref(k);
+                goto failed;
+            }
+
+            bool ok = purc_variant_object_set(ctnr, k, v);
+            purc_variant_unref(k);
+            purc_variant_unref(v);
+            if (!ok)
+                goto failed;
+        }
+    }
+
+    doc->variants[idx] = ctnr;
+    return purc_variant_ref(ctnr);
+
+failed:
+    if (ctnr)
+        purc_variant_unref(ctnr);
+    return PURC_VARIANT_INVALID;
+}
+
+static inline purc_variant_t
+materialized(struct lj_doc *doc, size_t idx)
+{
+    return doc->variants ? doc->variants[idx] : PURC_VARIANT_INVALID;
+}
+
+static int
+compare_keys(const void *a, const void *b)
+{
+    const struct lj_key *ka = a;
+    const struct lj_key *kb = b;
+    size_t len = (ka->len < kb->len) ? ka->len : kb->len;
+
+    int r = memcmp(ka->name, kb->name, len);
+    if (r == 0 && ka->len != kb->len)
+        r = (ka->len < kb->len) ? -1 : 1;
+    if (r == 0)
+        r = (ka->value < kb->value) ? -1 : 1;
+    return r;
+}
+
+/* sort the keys of the object, and decode the escaped keys once */
+static struct lj_keys *
+sort_keys(struct lj_doc *doc, size_t idx)
+{
+    const struct lj_node *node = doc->nodes + idx;
+    struct lj_keys *keys;
+    size_t sz_decoded = 0;
+    size_t i, n, k;
+    char *d;
+
+    keys = malloc(sizeof(*keys) + sizeof(struct lj_key) * node->nr_children);
+    if (keys == NULL)
+        return NULL;
+
+    for (i = idx + 1, n = 0; n < node->nr_children;
+            i = doc->nodes[i + 1].next, n++) {
+        if (doc->nodes[i].escaped)
+            sz_decoded += doc->nodes[i].length + 1;
+    }
+
+    keys->decoded = NULL;
+    if (sz_decoded > 0 && (keys->decoded = malloc(sz_decoded)) == NULL) {
+        free(keys);
+        return NULL;
+    }
+
+    d = keys->decoded;
+    for (i = idx + 1, n = 0; n < node->nr_children;
+            i = doc->nodes[i + 1].next, n++) {
+        const struct lj_node *key = doc->nodes + i;
+        struct lj_key *lk = keys->keys + n;
+
+        lk->value = i + 1;
+        if (key->escaped) {
+            lk->name = d;
+            lk->len = decode_string_to(doc->text + key->offset,
+                    key->length, d);
+            d += lk->len + 1;
+        }
+        else {
+            lk->name = doc->text + key->offset;
+            lk->len = key->length;
+        }
+    }
+
+    qsort(keys->keys, n, sizeof(struct lj_key), compare_keys);
+
+    /* the last one wins if there are duplicated keys */
+    for (i = 0, k = 0; i < n; i++) {
+        if (i + 1 < n && keys->keys[i].len == keys->keys[i + 1].len &&
+                memcmp(keys->keys[i].name, keys->keys[i + 1].name,
+                    keys->keys[i].len) == 0)
+            continue;
+        keys->keys[k++] = keys->keys[i];
+    }
+    keys->nr_keys = k;
+
+    return keys;
+}
+
+/* returns the index of the value of the member, or 0 if not found */
+static size_t
+find_member(struct lj_doc *doc, size_t idx, const char *name)
+{
+    if (doc->keys == NULL) {
+        doc->keys = calloc(doc->nr_nodes, sizeof(struct lj_keys *));
+        if (doc->keys == NULL)
+            goto failed;
+    }
+
+    struct lj_keys *keys = doc->keys[idx];
+    if (keys == NULL) {
+        if ((keys = sort_keys(doc, idx)) == NULL)
+            goto failed;
+        doc->keys[idx] = keys;
+    }
+
+    struct lj_key key = { name, strlen(name), 0 };
+    size_t lo = 0, hi = keys->nr_keys;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const struct lj_key *lk = keys->keys + mid;
+        size_t len = (lk->len < key.len) ? lk->len : key.len;
+
+        int r = memcmp(key.name, lk->name, len);
+        if (r == 0) {
+            if (key.len == lk->len)
+                return lk->value;
+            r = (key.len < lk->len) ? -1 : 1;
+        }
+
+        if (r < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    purc_set_error(PCVRNT_ERROR_NO_SUCH_KEY);
+    return 0;
+
+failed:
+    pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return 0;
+}
+
+static purc_variant_t
+make_lazy_object(struct lj_doc *doc, size_t idx);
+
+static purc_variant_t
+member_getter(void *native_entity, const char *property_name,
+        size_t nr_args, purc_variant_t *argv, unsigned call_flags)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(call_flags);
+
+    struct lj_entity *entity = native_entity;
+    struct lj_doc *doc = entity->doc;
+    purc_variant_t obj = materialized(doc, entity->idx);
+
+    if (obj) {
+        purc_variant_t v = purc_variant_object_get_by_ckey(obj,
+                property_name);
+        return v ? purc_variant_ref(v) : PURC_VARIANT_INVALID;
+    }
+
+    size_t found = find_member(doc, entity->idx, property_name);
+    if (found == 0)
+        return PURC_VARIANT_INVALID;
+
+    if (doc->nodes[found].type == LJN_OBJECT && !materialized(doc, found))
+        return make_lazy_object(doc, found);
+    return materialize(doc, found);
+}
+
+static purc_variant_t
+self_getter(void *native_entity, const char *property_name,
+        size_t nr_args, purc_variant_t *argv, unsigned call_flags)
+{
+    UNUSED_PARAM(property_name);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+    UNUSED_PARAM(call_flags);
+
+    struct lj_entity *entity = native_entity;
+    return materialize(entity->doc, entity->idx);
+}
+
+static purc_variant_t
+member_setter(void *native_entity, const char *property_name,
+        size_t nr_args, purc_variant_t *argv, unsigned call_flags)
+{
+    UNUSED_PARAM(call_flags);
+
+    if (nr_args < 1) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        return PURC_VARIANT_INVALID;
+    }
+
+    struct lj_entity *entity = native_entity;
+    purc_variant_t obj = materialize(entity->doc, entity->idx);
+    if (obj == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    bool ok = purc_variant_object_set_by_ckey(obj, property_name, argv[0]);
+    purc_variant_unref(obj);
+    return ok ? purc_variant_make_boolean(true) : PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+member_eraser(void *native_entity, const char *property_name,
+        size_t nr_args, purc_variant_t *argv, unsigned call_flags)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+
+    struct lj_entity *entity = native_entity;
+    purc_variant_t obj = materialize(entity->doc, entity->idx);
+    if (obj == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    bool ok = purc_variant_object_remove_by_ckey(obj, property_name,
+            (call_flags & PCVRT_CALL_FLAG_SILENTLY));
+    purc_variant_unref(obj);
+    return purc_variant_make_boolean(ok);
+}
+
+static purc_nvariant_method
+property_getter(void *native_entity, const char *property_name)
+{
+    UNUSED_PARAM(native_entity);
+    return property_name ? member_getter : self_getter;
+}
+
+static purc_nvariant_method
+property_setter(void *native_entity, const char *property_name)
+{
+    UNUSED_PARAM(native_entity);
+    return property_name ? member_setter : NULL;
+}
+
+static purc_nvariant_method
+property_eraser(void *native_entity, const char *property_name)
+{
+    UNUSED_PARAM(native_entity);
+    return property_name ? member_eraser : NULL;
+}
+
+static void
+on_release(void *native_entity)
+{
+    struct lj_entity *entity = native_entity;
+    doc_unref(entity->doc);
+    free(entity);
+}
+
+static purc_variant_t
+make_lazy_object(struct lj_doc *doc, size_t idx)
+{
+    static const struct purc_native_ops ops = {
+        .property_getter = property_getter,
+        .property_setter = property_setter,
+        .property_eraser = property_eraser,
+        .on_release = on_release,
+    };
+
+    struct lj_entity *entity = malloc(sizeof(*entity));
+    if (entity == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    entity->doc = doc;
+    entity->idx = idx;
+
+    purc_variant_t v = purc_variant_make_native_entity(entity, &ops,
+            LAZY_JSON_NAME);
+    if (v == PURC_VARIANT_INVALID) {
+        free(entity);
+        return PURC_VARIANT_INVALID;
+    }
+
+    doc->refc++;
+    return v;
+}
+
+purc_variant_t
+pcvariant_load_lazy_json(purc_rwstream_t stream)
+{
+    purc_variant_t ret;
+    struct lj_doc *doc = calloc(1, sizeof(*doc));
+    if (doc == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    doc->refc = 1;
+    doc->text = read_whole_stream(stream, &doc->len_text);
+    if (doc->text == NULL) {
+        free(doc);
+        return PURC_VARIANT_INVALID;
+    }
+
+    if (!pcutils_string_check_utf8_len(doc->text, doc->len_text,
+                NULL, NULL) || build_index(doc)) {
+        /* not plain JSON; leave it to the eJSON parser */
+        ret = purc_variant_make_from_json_string(doc->text, doc->len_text);
+    }
+    else if (doc->nodes[0].type == LJN_OBJECT) {
+        ret = make_lazy_object(doc, 0);
+    }
+    else {
+        ret = materialize(doc, 0);
+    }
+
+    doc_unref(doc);
+    return ret;
+}
+
+bool
+pcvariant_is_lazy_json(purc_variant_t value)
+{
+    if (!purc_variant_is_native(value))
+        return false;
+
+    const char *name = purc_variant_native_get_name(value);
+    return name && strcmp(name, LAZY_JSON_NAME) == 0;
+}
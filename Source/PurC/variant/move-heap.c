@@ -160,6 +160,34 @@ move_variant_in(struct pcinst *inst, purc_variant_t v)
     move_heap.stat.sz_total_mem += sizeof(purc_variant);
 }
 
+/* The owner of a shared string does not move with it, so give the string
+   its own copy first. This is done on the heap of the instance, which
+   accounts the new buffer and releases the owner. */
+static bool
+unshare_string(purc_variant_t v)
+{
+    bool ok;
+
+    if (v->type != PURC_VARIANT_TYPE_STRING ||
+            !(v->flags & PCVRNT_FLAG_STRING_SHARED))
+        return true;
+
+    pcvariant_use_norm_heap();
+    ok = pcvariant_string_unshare(v);
+    pcvariant_use_move_heap();
+    return ok;
+}
+
+static bool
+move_key_in(struct pcinst *inst, purc_variant_t k)
+{
+    if (!unshare_string(k))
+        return false;
+
+    move_variant_in(inst, k);
+    return true;
+}
+
 static purc_variant_t
 move_or_clone_immutable(struct pcinst *inst, purc_variant_t v)
 {
@@ -168,6 +196,9 @@ move_or_clone_immutable(struct pcinst *inst, purc_variant_t v)
     if (IS_CONTAINER(v->type))
         return retv;
 
+    if (!unshare_string(v))
+        return retv;
+
     if (v == &inst->org_vrt_heap->v_undefined) {
         retv = &move_heap.v_undefined;
         v->refc--;
@@ -293,22 +324,26 @@ move_keys_in_cloned_object(struct travel_context *ctxt, purc_variant_t obj)
 
         switch (v->type) {
         case PURC_VARIANT_TYPE_ARRAY:
-            move_variant_in(ctxt->inst, k);
+            if (!move_key_in(ctxt->inst, k))
+                return false;
             move_keys_in_cloned_array(ctxt, v);
             break;
 
         case PURC_VARIANT_TYPE_OBJECT:
-            move_variant_in(ctxt->inst, k);
+            if (!move_key_in(ctxt->inst, k))
+                return false;
             move_keys_in_cloned_object(ctxt, v);
             break;
 
         case PURC_VARIANT_TYPE_SET:
-            move_variant_in(ctxt->inst, k);
+            if (!move_key_in(ctxt->inst, k))
+                return false;
             move_keys_in_cloned_set(ctxt, v);
             break;
 
         case PURC_VARIANT_TYPE_TUPLE:
-            move_variant_in(ctxt->inst, k);
+            if (!move_key_in(ctxt->inst, k))
+                return false;
             move_keys_in_cloned_tuple(ctxt, v);
             break;
 
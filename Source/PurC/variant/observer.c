@@ -25,10 +25,43 @@
 #include "purc-errors.h"
 #include "private/debug.h"
 #include "private/errors.h"
+#include "private/instance.h"
 #include "variant-internals.h"
 
 #include <stdlib.h>
 
+/* a range of the indices in an array */
+struct batch_range {
+    size_t              first;
+    size_t              count;
+};
+
+/* the changes of one kind of operations in a batch */
+struct batch_record {
+    /* for arrays */
+    struct batch_range *ranges;
+    size_t              nr_ranges;
+    size_t              sz_ranges;
+
+    /* for other containers */
+    purc_variant_t      keys;
+
+    bool                fired;
+};
+
+#define BATCH_OP_GROW       0
+#define BATCH_OP_SHRINK     1
+#define BATCH_OP_CHANGE     2
+#define NR_BATCH_OPS        3
+
+struct pcvar_batch {
+    struct pcvar_batch *next;
+    purc_variant_t      ctnr;
+    int                 depth;
+
+    struct batch_record records[NR_BATCH_OPS];
+};
+
 static pcvar_listener*
 register_listener(purc_variant_t v, unsigned int flags,
         pcvar_op_t op, pcvar_op_handler handler, void *ctxt)
@@ -101,6 +134,29 @@ purc_variant_register_post_listener(purc_variant_t v,
     return register_listener(v, PCVAR_LISTENER_POST, op, handler, ctxt);
 }
 
+struct pcvar_listener *
+pcvariant_register_batch_listener(purc_variant_t v,
+        pcvar_op_t op, pcvar_op_handler handler, void *ctxt)
+{
+    if ((op & PCVAR_OPERATION_ALL) != op) {
+        pcinst_set_error(PCVRNT_ERROR_WRONG_ARGS);
+        return NULL;
+    }
+
+    if (v == PURC_VARIANT_INVALID || !op || !handler) {
+        pcinst_set_error(PCVRNT_ERROR_WRONG_ARGS);
+        return NULL;
+    }
+
+    if (!IS_CONTAINER(v->type)) {
+        pcinst_set_error(PCVRNT_ERROR_NOT_SUPPORTED);
+        return NULL;
+    }
+
+    return register_listener(v, PCVAR_LISTENER_POST | PCVAR_LISTENER_BATCH,
+            op, handler, ctxt);
+}
+
 bool
 purc_variant_revoke_listener(purc_variant_t v,
         struct pcvar_listener *listener)
@@ -164,6 +220,274 @@ bool pcvariant_on_pre_fired(
     return true;
 }
 
+static inline struct pcvar_batch **
+batches_of_instance(void)
+{
+    struct pcinst *inst = pcinst_current();
+    return &inst->org_vrt_heap->batches;
+}
+
+static struct pcvar_batch *
+find_batch(purc_variant_t ctnr)
+{
+    struct pcvar_batch *batch = *batches_of_instance();
+    for (; batch; batch = batch->next) {
+        if (batch->ctnr == ctnr)
+            return batch;
+    }
+
+    return NULL;
+}
+
+bool
+pcvar_has_immediate_listener(purc_variant_t ctnr, pcvar_op_t op)
+{
+    bool batched = (find_batch(ctnr) != NULL);
+
+    struct pcvar_listener *p;
+    list_for_each_entry(p, &ctnr->listeners, list_node) {
+        if ((p->op & op) == 0)
+            continue;
+
+        /* will be called when the batch ends */
+        if (batched && (p->flags & PCVAR_LISTENER_BATCH))
+            continue;
+
+        return true;
+    }
+
+    return false;
+}
+
+static int
+batch_op_index(pcvar_op_t op)
+{
+    switch (op) {
+    case PCVAR_OPERATION_GROW:
+        return BATCH_OP_GROW;
+    case PCVAR_OPERATION_SHRINK:
+        return BATCH_OP_SHRINK;
+    case PCVAR_OPERATION_CHANGE:
+        return BATCH_OP_CHANGE;
+    default:
+        return -1;
+    }
+}
+
+static pcvar_op_t batch_ops[NR_BATCH_OPS] = {
+    PCVAR_OPERATION_GROW,
+    PCVAR_OPERATION_SHRINK,
+    PCVAR_OPERATION_CHANGE,
+};
+
+/* try to merge the index into the last range */
+static bool
+merge_index(struct batch_range *last, pcvar_op_t op, size_t idx)
+{
+    switch (op) {
+    case PCVAR_OPERATION_GROW:
+        /* appended after, or inserted before the range */
+        if (idx == last->first + last->count || idx == last->first) {
+            last->count++;
+            return true;
+        }
+        break;
+
+    case PCVAR_OPERATION_SHRINK:
+        /* removed at the same index, or the one before it */
+        if (idx == last->first) {
+            last->count++;
+            return true;
+        }
+        if (idx + 1 == last->first) {
+            last->first = idx;
+            last->count++;
+            return true;
+        }
+        break;
+
+    default:
+        if (idx >= last->first && idx < last->first + last->count)
+            return true;
+        if (idx == last->first + last->count) {
+            last->count++;
+            return true;
+        }
+        break;
+    }
+
+    return false;
+}
+
+static int
+record_index(struct batch_record *record, pcvar_op_t op, purc_variant_t pos)
+{
+    uint64_t idx;
+    if (!purc_variant_cast_to_ulongint(pos, &idx, false))
+        return -1;
+
+    if (record->nr_ranges > 0 &&
+            merge_index(record->ranges + record->nr_ranges - 1, op, idx))
+        return 0;
+
+    if (record->nr_ranges == record->sz_ranges) {
+        size_t sz = record->sz_ranges ? record->sz_ranges * 2 : 4;
+        struct batch_range *ranges = (struct batch_range *)realloc(
+                record->ranges, sz * sizeof(*ranges));
+        if (ranges == NULL)
+            return -1;
+        record->ranges = ranges;
+        record->sz_ranges = sz;
+    }
+
+    record->ranges[record->nr_ranges].first = idx;
+    record->ranges[record->nr_ranges].count = 1;
+    record->nr_ranges++;
+    return 0;
+}
+
+static int
+record_change(struct pcvar_batch *batch, pcvar_op_t op,
+        size_t nr_args, purc_variant_t *argv)
+{
+    int i = batch_op_index(op);
+    if (i < 0)
+        return -1;
+
+    struct batch_record *record = batch->records + i;
+    record->fired = true;
+    if (nr_args == 0)
+        return 0;
+
+    if (batch->ctnr->type == PURC_VARIANT_TYPE_ARRAY)
+        return record_index(record, op, argv[0]);
+
+    if (record->keys == PURC_VARIANT_INVALID) {
+        record->keys = purc_variant_make_array_0();
+        if (record->keys == PURC_VARIANT_INVALID)
+            return -1;
+    }
+
+    return purc_variant_array_append(record->keys, argv[0]) ? 0 : -1;
+}
+
+static purc_variant_t
+make_change_records(purc_variant_t ctnr, struct batch_record *record)
+{
+    if (ctnr->type != PURC_VARIANT_TYPE_ARRAY) {
+        if (record->keys)
+            return purc_variant_ref(record->keys);
+        return purc_variant_make_array_0();
+    }
+
+    purc_variant_t records = purc_variant_make_array_0();
+    if (records == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    for (size_t i = 0; i < record->nr_ranges; i++) {
+        purc_variant_t first, count, range;
+        first = purc_variant_make_ulongint(record->ranges[i].first);
+        count = purc_variant_make_ulongint(record->ranges[i].count);
+        range = purc_variant_make_array(2, first, count);
+        PURC_VARIANT_SAFE_CLEAR(first);
+        PURC_VARIANT_SAFE_CLEAR(count);
+
+        if (range == PURC_VARIANT_INVALID ||
+                !purc_variant_array_append(records, range)) {
+            PURC_VARIANT_SAFE_CLEAR(range);
+            purc_variant_unref(records);
+            return PURC_VARIANT_INVALID;
+        }
+        purc_variant_unref(range);
+    }
+
+    return records;
+}
+
+struct pcvar_batch *
+pcvariant_begin_batch(purc_variant_t ctnr)
+{
+    if (ctnr == PURC_VARIANT_INVALID || !IS_CONTAINER(ctnr->type))
+        return NULL;
+
+    struct pcvar_batch *batch = find_batch(ctnr);
+    if (batch) {
+        batch->depth++;
+        return batch;
+    }
+
+    /* no need to batch if nobody accepts the aggregated records */
+    bool found = false;
+    struct pcvar_listener *p;
+    list_for_each_entry(p, &ctnr->listeners, list_node) {
+        if (p->flags & PCVAR_LISTENER_BATCH) {
+            found = true;
+            break;
+        }
+    }
+
+    if (!found)
+        return NULL;
+
+    batch = (struct pcvar_batch *)calloc(1, sizeof(*batch));
+    if (batch == NULL)
+        return NULL;
+
+    struct pcvar_batch **batches = batches_of_instance();
+    batch->ctnr = purc_variant_ref(ctnr);
+    batch->depth = 1;
+    batch->next = *batches;
+    *batches = batch;
+    return batch;
+}
+
+void
+pcvariant_end_batch(struct pcvar_batch *batch)
+{
+    if (batch == NULL || --batch->depth > 0)
+        return;
+
+    struct pcvar_batch **pp = batches_of_instance();
+    while (*pp != batch)
+        pp = &(*pp)->next;
+    *pp = batch->next;
+
+    purc_variant_t ctnr = batch->ctnr;
+    for (int i = 0; i < NR_BATCH_OPS; i++) {
+        struct batch_record *record = batch->records + i;
+        if (!record->fired)
+            continue;
+
+        pcvar_op_t op = batch_ops[i];
+        purc_variant_t records = make_change_records(ctnr, record);
+        if (records == PURC_VARIANT_INVALID) {
+            purc_clr_error();
+            records = purc_variant_make_null();
+        }
+
+        struct pcvar_listener *p, *n;
+        list_for_each_entry_reverse_safe(p, n, &ctnr->listeners, list_node) {
+            if ((p->op & op) == 0)
+                continue;
+
+            if ((p->flags & PCVAR_LISTENER_PRE_OR_POST) == PCVAR_LISTENER_PRE)
+                break;
+
+            if (p->flags & PCVAR_LISTENER_BATCH) {
+                bool ok = p->handler(ctnr, op, p->ctxt, 1, &records);
+                PC_ASSERT(ok);
+            }
+        }
+
+        purc_variant_unref(records);
+        free(record->ranges);
+        PURC_VARIANT_SAFE_CLEAR(record->keys);
+    }
+
+    purc_variant_unref(ctnr);
+    free(batch);
+}
+
 void pcvariant_on_post_fired(
         purc_variant_t source,  // the source variant.
         pcvar_op_t op,          // the operation identifier.
@@ -177,6 +501,9 @@ void pcvariant_on_post_fired(
     struct list_head *listeners;
     listeners = &source->listeners;
 
+    struct pcvar_batch *batch = NULL;
+    bool batch_checked = false;
+
     struct pcvar_listener *p, *n;
     list_for_each_entry_reverse_safe(p, n, listeners, list_node) {
         struct pcvar_listener *curr = p;
@@ -187,6 +514,23 @@ void pcvariant_on_post_fired(
         if ((curr->flags & PCVAR_LISTENER_PRE_OR_POST) == PCVAR_LISTENER_PRE)
             break;
 
+        if ((curr->flags & PCVAR_LISTENER_BATCH) &&
+                batch_op_index(op) >= 0) {
+            if (!batch_checked) {
+                batch = find_batch(source);
+                /* notify one by one if failed to record the change */
+                if (batch && record_change(batch, op, nr_args, argv)) {
+                    purc_clr_error();
+                    batch = NULL;
+                }
+                batch_checked = true;
+            }
+
+            /* will be notified when the batch ends */
+            if (batch)
+                continue;
+        }
+
         bool ok = curr->handler(source, op, curr->ctxt, nr_args, argv);
         PC_ASSERT(ok);
     }
@@ -46,6 +46,7 @@
 #include "private/instance.h"
 #include "private/errors.h"
 #include "private/debug.h"
+#include "private/dtoa.h"
 
 #include "variant/variant-internals.h"
 
@@ -58,133 +59,248 @@
 
 static const char *hex_chars = "0123456789abcdefABCDEF";
 
-#define MY_WRITE(rws, buff, count)                                      \
+/* the size of the output buffer of the serializer */
+#define SZ_OUTPUT_BUFFER    8192
+
+/*
+ * The serializer writes to the stream through an output buffer, so that
+ * the stream is called for blocks of SZ_OUTPUT_BUFFER bytes instead of
+ * every separator and every escaped piece.
+ */
+struct serializer {
+    purc_rwstream_t rws;
+    unsigned int    flags;
+    size_t         *len_expected;
+
+    const char     *format_double;
+    const char     *format_long_double;
+
+    /* the number of bytes written to the stream actually */
+    ssize_t         nr_written;
+    /* writing to the stream failed */
+    bool            failed;
+
+    size_t          len;
+    char            buf[SZ_OUTPUT_BUFFER];
+};
+
+static int
+write_to_stream(struct serializer *s, const char *buf, size_t count)
+{
+    while (count > 0) {
+        ssize_t n = purc_rwstream_write(s->rws, buf, count);
+        if (n <= 0) {
+            if (s->flags & PCVRNT_SERIALIZE_OPT_IGNORE_ERRORS)
+                break;
+
+            s->failed = true;
+            return -1;
+        }
+
+        s->nr_written += n;
+        buf += n;
+        count -= n;
+    }
+
+    return 0;
+}
+
+static int
+flush_output(struct serializer *s)
+{
+    int r = 0;
+
+    if (s->len > 0 && !s->failed)
+        r = write_to_stream(s, s->buf, s->len);
+    s->len = 0;
+    return r;
+}
+
+static int
+write_output(struct serializer *s, const char *buf, size_t count)
+{
+    if (s->len_expected)
+        *s->len_expected += count;
+
+    if (s->failed)
+        return -1;
+
+    if (s->len + count > sizeof(s->buf)) {
+        if (flush_output(s))
+            return -1;
+
+        /* no need to copy a large block */
+        if (count >= sizeof(s->buf))
+            return write_to_stream(s, buf, count);
+    }
+
+    memcpy(s->buf + s->len, buf, count);
+    s->len += count;
+    return 0;
+}
+
+static int
+write_char(struct serializer *s, char c)
+{
+    if (s->len_expected)
+        *s->len_expected += 1;
+
+    if (s->failed)
+        return -1;
+
+    if (s->len == sizeof(s->buf) && flush_output(s))
+        return -1;
+
+    s->buf[s->len++] = c;
+    return 0;
+}
+
+static int
+fill_output(struct serializer *s, char c, size_t count)
+{
+    if (s->len_expected)
+        *s->len_expected += count;
+
+    while (count > 0) {
+        if (s->failed)
+            return -1;
+
+        if (s->len == sizeof(s->buf) && flush_output(s))
+            return -1;
+
+        size_t n = sizeof(s->buf) - s->len;
+        if (n > count)
+            n = count;
+        memset(s->buf + s->len, c, n);
+        s->len += n;
+        count -= n;
+    }
+
+    return 0;
+}
+
+#define MY_WRITE(s, buff, count)                                        \
+    do {                                                                \
+        if (write_output((s), (buff), (count)))                         \
+            goto failed;                                                \
+    } while (0)
+
+#define MY_PUTC(s, c)                                                   \
     do {                                                                \
-        const char* _buff = buff;                                       \
-        ssize_t n;                                                      \
-        size_t nr_left = (count);                                       \
-        if (len_expected)                                               \
-            *len_expected += (count);                                   \
-        while (1) {                                                     \
-            n = purc_rwstream_write((rws), _buff, nr_left);             \
-            if (n <= 0) {                                               \
-                if (flags & PCVRNT_SERIALIZE_OPT_IGNORE_ERRORS)      \
-                    break;                                              \
-                else                                                    \
-                    goto failed;                                        \
-            }                                                           \
-            else if ((size_t)n < nr_left) {                             \
-                nr_written += n;                                        \
-                _buff += n;                                             \
-                continue;                                               \
-            }                                                           \
-            else {                                                      \
-                nr_written += n;                                        \
-                break;                                                  \
-            }                                                           \
-        }                                                               \
+        if (write_char((s), (c)))                                       \
+            goto failed;                                                \
     } while (0)
 
-#define MY_CHECK(n)                                                     \
+#define MY_CHECK(r)                                                     \
     do {                                                                \
-        if ((n) < 0 &&                                                  \
-                !(flags & PCVRNT_SERIALIZE_OPT_IGNORE_ERRORS)) {     \
+        if ((r) < 0)                                                    \
             goto failed;                                                \
-        }                                                               \
-        else {                                                          \
-            nr_written += (n);                                          \
-        }                                                               \
     } while (0)
 
-static ssize_t
-serialize_string(purc_rwstream_t rws, const char* str,
-        size_t len, unsigned int flags, size_t *len_expected)
+#define ONES        UINT64_C(0x0101010101010101)
+#define HIGHS       UINT64_C(0x8080808080808080)
+
+/* whether any byte in x is zero */
+#define HAS_ZERO(x)         (((x) - ONES) & ~(x) & HIGHS)
+
+/* whether any byte in x is less than n (n <= 128) */
+#define HAS_LESS(x, n)      (((x) - ONES * (n)) & ~(x) & HIGHS)
+
+/* whether any byte in x equals to c */
+#define HAS_BYTE(x, c)      HAS_ZERO((x) ^ (ONES * (c)))
+
+#define NEED_ESCAPE(c, escape_slash)                                    \
+    ((c) < 0x20 || (c) == '"' || (c) == '\\' ||                         \
+        ((escape_slash) && (c) == '/'))
+
+/* returns the length of the leading bytes which need no escape;
+   eight bytes are checked at a time */
+static size_t
+span_plain_chars(const char *str, size_t len, bool escape_slash)
+{
+    size_t pos = 0;
+
+    while (pos < len) {
+        if (pos + sizeof(uint64_t) <= len) {
+            uint64_t x;
+            memcpy(&x, str + pos, sizeof(x));
+
+            if (!HAS_LESS(x, 0x20) && !HAS_BYTE(x, '"') &&
+                    !HAS_BYTE(x, '\\') &&
+                    !(escape_slash && HAS_BYTE(x, '/'))) {
+                pos += sizeof(uint64_t);
+                continue;
+            }
+        }
+
+        /* check the bytes in this word one by one */
+        size_t end = pos + sizeof(uint64_t);
+        if (end > len)
+            end = len;
+        for (; pos < end; pos++) {
+            unsigned char c = (unsigned char)str[pos];
+            if (NEED_ESCAPE(c, escape_slash))
+                return pos;
+        }
+    }
+
+    return pos;
+}
+
+static int
+serialize_string(struct serializer *s, const char* str, size_t len)
 {
-    int nr_written = 0;
-    size_t pos = 0, start_offset = 0;
-    unsigned char c;
-    char buff[3];
+    bool escape_slash = !(s->flags & PCVRNT_SERIALIZE_OPT_NOSLASHESCAPE);
+    char buff[6];
+
+    while (len > 0) {
+        size_t n = span_plain_chars(str, len, escape_slash);
+        if (n > 0) {
+            MY_WRITE(s, str, n);
+            str += n;
+            len -= n;
+            if (len == 0)
+                break;
+        }
 
-    while (len--) {
-        c = str[pos];
+        unsigned char c = (unsigned char)*str;
+        buff[0] = '\\';
         switch (c) {
         case '\b':
+            buff[1] = 'b';
+            break;
         case '\n':
+            buff[1] = 'n';
+            break;
         case '\r':
+            buff[1] = 'r';
+            break;
         case '\t':
+            buff[1] = 't';
+            break;
         case '\f':
+            buff[1] = 'f';
+            break;
         case '"':
         case '\\':
         case '/':
-            if ((flags & PCVRNT_SERIALIZE_OPT_NOSLASHESCAPE) && c == '/') {
-                pos++;
-                break;
-            }
-
-            if (pos - start_offset > 0)
-                MY_WRITE(rws, str + start_offset, pos - start_offset);
-
-            buff[0] = 0;
-            if (c == '\b') {
-                buff[0] = '\\';
-                buff[1] = 'b';
-            }
-            else if (c == '\n') {
-                buff[0] = '\\';
-                buff[1] = 'n';
-            }
-            else if (c == '\r') {
-                buff[0] = '\\';
-                buff[1] = 'r';
-            }
-            else if (c == '\t') {
-                buff[0] = '\\';
-                buff[1] = 't';
-            }
-            else if (c == '\f') {
-                buff[0] = '\\';
-                buff[1] = 'f';
-            }
-            else if (c == '"') {
-                buff[0] = '\\';
-                buff[1] = '\"';
-            }
-            else if (c == '\\') {
-                buff[0] = '\\';
-                buff[1] = '\\';
-            }
-            else if (c == '/') {
-                buff[0] = '\\';
-                buff[1] = '/';
-            }
-
-            if (buff[0])
-                MY_WRITE(rws, buff, 2);
-
-            start_offset = ++pos;
+            buff[1] = c;
             break;
-
         default:
-            if (c < ' ') {
-                char sbuf[7];
-                if (pos - start_offset > 0)
-                    MY_WRITE(rws, str + start_offset, pos - start_offset);
-
-                if (snprintf(sbuf, sizeof(sbuf), "\\u00%c%c",
-                            hex_chars[c >> 4], hex_chars[c & 0xf]) < 0)
-                    goto failed;
-
-                MY_WRITE(rws, sbuf, sizeof(sbuf) - 1);
-                start_offset = ++pos;
-            }
-            else
-                pos++;
+            buff[1] = 'u';
+            buff[2] = '0';
+            buff[3] = '0';
+            buff[4] = hex_chars[c >> 4];
+            buff[5] = hex_chars[c & 0xf];
+            break;
         }
+
+        MY_WRITE(s, buff, buff[1] == 'u' ? 6 : 2);
+        str++;
+        len--;
     }
-    if (pos - start_offset > 0)
-        MY_WRITE(rws, str + start_offset, pos - start_offset);
 
-    return nr_written;
+    return 0;
 
 failed:
     return -1;
@@ -257,12 +373,10 @@ static const char base64_pad = '=';
        characters followed by one "=" padding character.
    */
 
-static ssize_t serialize_bsequence_base64(purc_rwstream_t rws,
-        const void *_src, size_t srclength,
-        unsigned int flags, size_t *len_expected)
+static int serialize_bsequence_base64(struct serializer *s,
+        const void *_src, size_t srclength)
 {
     const unsigned char *src = _src;
-    ssize_t nr_written = 0;
     uint8_t input[3] = {0};
     uint8_t output[4];
     char buff[4];
@@ -284,7 +398,7 @@ static ssize_t serialize_bsequence_base64(purc_rwstream_t rws,
         buff[2] = base64_chars[output[2]];
         buff[3] = base64_chars[output[3]];
 
-        MY_WRITE(rws, buff, 4);
+        MY_WRITE(s, buff, 4);
     }
 
     /* Now we worry about padding. */
@@ -306,49 +420,49 @@ static ssize_t serialize_bsequence_base64(purc_rwstream_t rws,
             buff[2] = base64_chars[output[2]];
         buff[3] = base64_pad;
 
-        MY_WRITE(rws, buff, 4);
+        MY_WRITE(s, buff, 4);
     }
 
-    return nr_written;
+    return 0;
 
 failed:
     return -1;
 }
 
-static ssize_t
-serialize_bsequence(purc_rwstream_t rws, const char* content,
-        size_t sz_content, unsigned int flags, size_t *len_expected)
+static int
+serialize_bsequence(struct serializer *s, const char* content,
+        size_t sz_content)
 {
-    ssize_t nr_written = 0, n;
+    unsigned int flags = s->flags;
     size_t i;
 
     switch (flags & PCVRNT_SERIALIZE_OPT_BSEQUENCE_MASK) {
         case PCVRNT_SERIALIZE_OPT_BSEQUENCE_HEX_STRING:
-            MY_WRITE(rws, "\"", 1);
+            MY_PUTC(s, '"');
             for (i = 0; i < sz_content; i++) {
                 unsigned char byte = (unsigned char)content[i];
                 char buff[2];
                 buff [0] = hex_chars[(byte >> 4) & 0x0f];
                 buff [1] = hex_chars[byte & 0x0f];
-                MY_WRITE(rws, buff, 2);
+                MY_WRITE(s, buff, 2);
             }
-            MY_WRITE(rws, "\"", 1);
+            MY_PUTC(s, '"');
             break;
 
         case PCVRNT_SERIALIZE_OPT_BSEQUENCE_HEX:
-            MY_WRITE(rws, "bx", 2);
+            MY_WRITE(s, "bx", 2);
             for (i = 0; i < sz_content; i++) {
                 unsigned char byte = (unsigned char)content[i];
                 char buff[2];
                 buff [0] = hex_chars[(byte >> 4) & 0x0f];
                 buff [1] = hex_chars[byte & 0x0f];
-                MY_WRITE(rws, buff, 2);
+                MY_WRITE(s, buff, 2);
             }
             break;
 
         case PCVRNT_SERIALIZE_OPT_BSEQUENCE_BIN:
         case PCVRNT_SERIALIZE_OPT_BSEQUENCE_BIN_DOT:
-            MY_WRITE(rws, "bb", 2);
+            MY_WRITE(s, "bb", 2);
             for (i = 0; i < sz_content; i++) {
                 unsigned char byte = (unsigned char)content[i];
                 char buff[10];
@@ -368,20 +482,18 @@ serialize_bsequence(purc_rwstream_t rws, const char* content,
                     }
                 }
 
-                MY_WRITE(rws, buff, k);
+                MY_WRITE(s, buff, k);
             }
             break;
 
         case PCVRNT_SERIALIZE_OPT_BSEQUENCE_BASE64:
         default:
-            MY_WRITE(rws, "b64", 3);
-            n = serialize_bsequence_base64(rws, content, sz_content,
-                    flags, len_expected);
-            MY_CHECK(n);
+            MY_WRITE(s, "b64", 3);
+            MY_CHECK(serialize_bsequence_base64(s, content, sz_content));
             break;
     }
 
-    return nr_written;
+    return 0;
 
 failed:
     return -1;
@@ -405,11 +517,12 @@ static inline UNUSED_FUNCTION bool equal_long_doubles(long double a,
 /* strlen of character literals resolved at compile time */
 #define static_strlen(string_literal) (sizeof(string_literal) - sizeof(""))
 
-static ssize_t
-serialize_number(purc_rwstream_t rws, double d, size_t *len_expected)
+/* returns 1 if the number is written as an integer, 0 if not */
+static int
+serialize_number(struct serializer *s, double d)
 {
     char buf[128];
-    int size;
+    size_t size;
 
     /* Although JSON RFC does not support
      * NaN or Infinity as numeric values
@@ -430,12 +543,18 @@ serialize_number(purc_rwstream_t rws, double d, size_t *len_expected)
             size = static_strlen("-Infinity");
         }
     }
+    else if (d > -9223372036854775808.0 && d < 9223372036854775808.0 &&
+            d == (double)(int64_t)d && !(d == 0 && signbit(d))) {
+        /* an exact integer gives the same digits as "%.0f" */
+        size = pcutils_i64toa((int64_t)d, buf);
+    }
     else {
         double test;
+        int n;
 
         /* try to format the double without decimals */
-        size = snprintf(buf, sizeof(buf), "%.0f", d);
-        if (size < 0 || size >= (int)sizeof(buf)) {
+        n = snprintf(buf, sizeof(buf), "%.0f", d);
+        if (n < 0 || n >= (int)sizeof(buf)) {
             pcinst_set_error(PURC_ERROR_TOO_SMALL_BUFF);
             return -1;
         }
@@ -445,43 +564,47 @@ serialize_number(purc_rwstream_t rws, double d, size_t *len_expected)
             /* If not, return 0 and call serialize_double */
             return 0;
         }
+        size = n;
     }
 
-    if (len_expected)
-        *len_expected += size;
-    return purc_rwstream_write(rws, buf, size);
+    if (write_output(s, buf, size))
+        return -1;
+    return 1;
 }
 
-static ssize_t
-serialize_double(purc_rwstream_t rws, double d, int flags,
-        const char *format, size_t *len_expected)
+static int
+serialize_double(struct serializer *s, double d)
 {
     char buf[128], *p, *q;
     int size;
 
-    static const char *std_format = "%.17g";
+    const char *format = s->format_double;
     int format_drops_decimals = 0;
     int looks_numeric = 0;
 
     if (!format) {
-        format = std_format;
-    }
-
-    size = snprintf(buf, sizeof(buf), format, d);
-    // although unlikely, snprintf might fail
-    if (UNLIKELY(size < 0)) {
-        pcinst_set_error(PURC_ERROR_OUTPUT);
-        return -1;
+        /* a short form which reads back as the same double */
+        size = (int)pcutils_dtoa(d, buf);
+        p = strchr(buf, '.');
+        format_drops_decimals = 1;
     }
+    else {
+        size = snprintf(buf, sizeof(buf), format, d);
+        // although unlikely, snprintf might fail
+        if (UNLIKELY(size < 0)) {
+            pcinst_set_error(PURC_ERROR_OUTPUT);
+            return -1;
+        }
 
-    p = strchr(buf, ',');
-    if (p)
-        *p = '.';
-    else
-        p = strchr(buf, '.');
+        p = strchr(buf, ',');
+        if (p)
+            *p = '.';
+        else
+            p = strchr(buf, '.');
 
-    if (format == std_format || strstr(format, ".0f") == NULL)
-        format_drops_decimals = 1;
+        if (strstr(format, ".0f") == NULL)
+            format_drops_decimals = 1;
+    }
 
     looks_numeric = /* Looks like *some* kind of number */
         purc_isdigit((unsigned char)buf[0]) ||
@@ -497,7 +620,7 @@ serialize_double(purc_rwstream_t rws, double d, int flags,
         size += 2;
     }
 
-    if (p && (flags & PCVRNT_SERIALIZE_OPT_NOZERO)) {
+    if (p && (s->flags & PCVRNT_SERIALIZE_OPT_NOZERO)) {
         /* last useful digit, always keep 1 zero */
         p++;
         for (q = p; *q; q++) {
@@ -515,14 +638,11 @@ serialize_double(purc_rwstream_t rws, double d, int flags,
         // but if a custom one happens to do so, just silently truncate.
         size = sizeof(buf) - 1;
 
-    if (len_expected)
-        *len_expected += size;
-    return purc_rwstream_write(rws, buf, size);
+    return write_output(s, buf, size);
 }
 
-static ssize_t
-serialize_long_double(purc_rwstream_t rws, long double ld, int flags,
-        const char *format, size_t *len_expected)
+static int
+serialize_long_double(struct serializer *s, long double ld)
 {
     char buf[256], *p, *q;
     int size;
@@ -543,6 +663,7 @@ serialize_long_double(purc_rwstream_t rws, long double ld, int flags,
     }
     else {
         static const char *std_format = "%.17Lg";
+        const char *format = s->format_long_double;
         if (!format) {
             format = std_format;
         }
@@ -566,7 +687,7 @@ serialize_long_double(purc_rwstream_t rws, long double ld, int flags,
         else
             p = strchr(buf, '.');
 
-        if (p && (flags & PCVRNT_SERIALIZE_OPT_NOZERO)) {
+        if (p && (s->flags & PCVRNT_SERIALIZE_OPT_NOZERO)) {
             /* last useful digit, always keep 1 zero */
             p++;
             for (q = p; *q; q++) {
@@ -580,106 +701,104 @@ serialize_long_double(purc_rwstream_t rws, long double ld, int flags,
         }
 
         // append FL postfix
-        if (flags & PCVRNT_SERIALIZE_OPT_REAL_EJSON) {
+        if (s->flags & PCVRNT_SERIALIZE_OPT_REAL_EJSON) {
             strcat(buf, "FL");
             size += 2;
         }
     }
 
-    if (len_expected)
-        *len_expected += size;
-    return purc_rwstream_write(rws, buf, size);
+    return write_output(s, buf, size);
 }
 
-static ssize_t
-print_newline(purc_rwstream_t rws, unsigned int flags, size_t *len_expected)
+static inline int
+print_newline(struct serializer *s)
 {
-    ssize_t nr_written = 0;
+    if (s->flags & PCVRNT_SERIALIZE_OPT_PRETTY)
+        return write_char(s, '\n');
 
-    if (flags & PCVRNT_SERIALIZE_OPT_PRETTY) {
-        if (len_expected)
-            *len_expected += 1;
-        nr_written = purc_rwstream_write(rws, "\n", 1);
-    }
-
-    return nr_written;
+    return 0;
 }
 
-static ssize_t
-print_indent(purc_rwstream_t rws, int level, unsigned int flags,
-        size_t *len_expected)
+static inline int
+print_indent(struct serializer *s, int level)
 {
-    size_t n;
-    char buff[MAX_EMBEDDED_LEVELS * 2];
-
     if (level <= 0 || level > MAX_EMBEDDED_LEVELS)
         return 0;
 
-    if (flags & PCVRNT_SERIALIZE_OPT_PRETTY) {
-        if (flags & PCVRNT_SERIALIZE_OPT_PRETTY_TAB) {
-            n = level;
-            memset(buff, '\t', n);
-        }
-        else {
-            n = level * 2;
-            memset(buff, ' ', n);
-        }
-
-        if (len_expected)
-            *len_expected += n;
-        return purc_rwstream_write(rws, buff, n);
+    if (s->flags & PCVRNT_SERIALIZE_OPT_PRETTY) {
+        if (s->flags & PCVRNT_SERIALIZE_OPT_PRETTY_TAB)
+            return fill_output(s, '\t', level);
+        return fill_output(s, ' ', level * 2);
     }
 
     return 0;
 }
 
-static inline ssize_t
-print_space(purc_rwstream_t rws, unsigned int flags, size_t* len_expected)
+static inline int
+print_space(struct serializer *s)
+{
+    if (s->flags & PCVRNT_SERIALIZE_OPT_SPACED)
+        return write_char(s, ' ');
+
+    return 0;
+}
+
+static inline int
+print_space_no_pretty(struct serializer *s)
 {
-    ssize_t nr_written = 0;
+    if (s->flags & PCVRNT_SERIALIZE_OPT_SPACED &&
+            !(s->flags & PCVRNT_SERIALIZE_OPT_PRETTY))
+        return write_char(s, ' ');
 
-    if (flags & PCVRNT_SERIALIZE_OPT_SPACED) {
-        if (len_expected)
-            *len_expected += 1;
-        nr_written = purc_rwstream_write(rws, " ", 1);
+    return 0;
+}
+
+/* the separator before a member of a container */
+static inline int
+print_member_prefix(struct serializer *s, bool first, int level)
+{
+    if (!first) {
+        if (write_char(s, ','))
+            return -1;
+        if (print_newline(s))
+            return -1;
     }
 
-    return nr_written;
+    if (print_space_no_pretty(s))
+        return -1;
+
+    return print_indent(s, level + 1);
 }
 
-static inline ssize_t print_space_no_pretty(purc_rwstream_t rws,
-        unsigned int flags, size_t *len_expected)
+/* the end of a container with nr_members members */
+static inline int
+print_container_suffix(struct serializer *s, size_t nr_members, int level,
+        char c)
 {
-    ssize_t nr_written = 0;
+    if (nr_members > 0 && print_newline(s))
+        return -1;
 
-    if (flags & PCVRNT_SERIALIZE_OPT_SPACED &&
-            !(flags & PCVRNT_SERIALIZE_OPT_PRETTY)) {
-        if (len_expected)
-            *len_expected += 1;
-        nr_written = purc_rwstream_write(rws, " ", 1);
-    }
+    if (print_indent(s, level))
+        return -1;
 
-    return nr_written;
+    if (print_space_no_pretty(s))
+        return -1;
+
+    return write_char(s, c);
 }
 
-ssize_t purc_variant_serialize(purc_variant_t value, purc_rwstream_t rws,
-        int level, unsigned int flags, size_t *len_expected)
+static int
+serialize_variant(struct serializer *s, purc_variant_t value, int level)
 {
-    ssize_t nr_written = 0, n;
     const char* content = NULL;
     size_t sz_content = 0;
     size_t i, idx;
     char buff [256];
     purc_variant_t member = NULL;
     purc_variant_t key;
-    char* format_double = NULL;
-    char* format_long_double = NULL;
     variant_set_t data;
-
-    purc_get_local_data(PURC_LDNAME_FORMAT_DOUBLE,
-            (uintptr_t *)&format_double, NULL);
-    purc_get_local_data(PURC_LDNAME_FORMAT_LDOUBLE,
-            (uintptr_t *)&format_long_double, NULL);
+    unsigned int flags = s->flags;
+    int n;
 
     PC_ASSERT(value);
 
@@ -705,83 +824,44 @@ ssize_t purc_variant_serialize(purc_variant_t value, purc_rwstream_t rws,
             break;
 
         case PURC_VARIANT_TYPE_EXCEPTION:
+        case PURC_VARIANT_TYPE_ATOMSTRING:
             content = purc_atom_to_string(value->atom);
             sz_content = strlen(content);
-            MY_WRITE(rws, "\"", 1);
-            n = serialize_string(rws, content, sz_content,
-                        flags, len_expected);
-            MY_CHECK(n);
-            MY_WRITE(rws, "\"", 1);
+            MY_PUTC(s, '"');
+            MY_CHECK(serialize_string(s, content, sz_content));
+            MY_PUTC(s, '"');
 
             content = NULL;
             break;
 
         case PURC_VARIANT_TYPE_NUMBER:
             /* try to serialize the number as an integer first */
-            n = serialize_number(rws, value->d, len_expected);
-            if (n < 0)
-                goto failed;
-            if (n == 0) {
-                n = serialize_double(rws, value->d, flags,
-                        format_double, len_expected);
-                if (n < 0)
-                    goto failed;
-            }
-            nr_written += n;
-
-            content = NULL;
+            n = serialize_number(s, value->d);
+            MY_CHECK(n);
+            if (n == 0)
+                MY_CHECK(serialize_double(s, value->d));
             break;
 
         case PURC_VARIANT_TYPE_LONGINT:
-        {
-            const char *format;
-            if (flags & PCVRNT_SERIALIZE_OPT_REAL_EJSON)
-                format = "%lldL";
-            else
-                format = "%lld";
-
-            if (snprintf(buff, sizeof(buff), format,
-                        (long long int)value->i64) < 0)
-                goto failed;
-            content = buff;
-            // sz_content = strlen(buff);
+            sz_content = pcutils_i64toa(value->i64, buff);
+            if (flags & PCVRNT_SERIALIZE_OPT_REAL_EJSON) {
+                strcpy(buff + sz_content, "L");
+                sz_content += 1;
+            }
+            MY_WRITE(s, buff, sz_content);
             break;
-        }
 
         case PURC_VARIANT_TYPE_ULONGINT:
-        {
-            const char *format;
-            if (flags & PCVRNT_SERIALIZE_OPT_REAL_EJSON)
-                format = "%lluUL";
-            else
-                format = "%llu";
-
-            if (snprintf(buff, sizeof(buff), format,
-                        (long long unsigned)value->u64) < 0)
-                goto failed;
-            content = buff;
-            // sz_content = strlen(buff);
+            sz_content = pcutils_u64toa(value->u64, buff);
+            if (flags & PCVRNT_SERIALIZE_OPT_REAL_EJSON) {
+                strcpy(buff + sz_content, "UL");
+                sz_content += 2;
+            }
+            MY_WRITE(s, buff, sz_content);
             break;
-        }
 
         case PURC_VARIANT_TYPE_LONGDOUBLE:
-            n = serialize_long_double(rws, value->ld, flags,
-                    format_long_double, len_expected);
-            MY_CHECK(n);
-
-            content = NULL;
-            break;
-
-        case PURC_VARIANT_TYPE_ATOMSTRING:
-            content = purc_atom_to_string(value->atom);
-            sz_content = strlen(content);
-            MY_WRITE(rws, "\"", 1);
-            n = serialize_string(rws, content, sz_content,
-                        flags, len_expected);
-            MY_CHECK(n);
-            MY_WRITE(rws, "\"", 1);
-
-            content = NULL;
+            MY_CHECK(serialize_long_double(s, value->ld));
             break;
 
         case PURC_VARIANT_TYPE_STRING:
@@ -799,15 +879,12 @@ ssize_t purc_variant_serialize(purc_variant_t value, purc_rwstream_t rws,
                 sz_content = value->size;
             }
             if (value->type == PURC_VARIANT_TYPE_STRING) {
-                MY_WRITE(rws, "\"", 1);
-                n = serialize_string(rws, content, sz_content - 1,
-                            flags, len_expected);
-                MY_WRITE(rws, "\"", 1);
+                MY_PUTC(s, '"');
+                MY_CHECK(serialize_string(s, content, sz_content - 1));
+                MY_PUTC(s, '"');
             }
             else
-                n = serialize_bsequence(rws, content, sz_content,
-                            flags, len_expected);
-            MY_CHECK(n);
+                MY_CHECK(serialize_bsequence(s, content, sz_content));
 
             content = NULL;
             break;
@@ -827,124 +904,60 @@ ssize_t purc_variant_serialize(purc_variant_t value, purc_rwstream_t rws,
             break;
 
         case PURC_VARIANT_TYPE_OBJECT:
-            content = NULL;
-
-            n = print_indent(rws, level, flags, len_expected);
-            MY_CHECK(n);
-
-            MY_WRITE(rws, "{", 1);
-            n = print_newline(rws, flags, len_expected);
-            MY_CHECK(n);
+            MY_CHECK(print_indent(s, level));
+            MY_PUTC(s, '{');
+            MY_CHECK(print_newline(s));
 
             i = 0;
             foreach_key_value_in_variant_object(value, key, member)
-                if (i > 0) {
-                    MY_WRITE(rws, ",", 1);
-                    n = print_newline(rws, flags, len_expected);
-                    MY_CHECK(n);
-                }
-
-                n = print_space_no_pretty(rws, flags, len_expected);
-                MY_CHECK(n);
-
-                n = print_indent(rws, level + 1, flags, len_expected);
-                MY_CHECK(n);
+                MY_CHECK(print_member_prefix(s, i == 0, level));
 
                 // key
-                MY_WRITE(rws, "\"", 1);
                 size_t len;
                 const char *ks = purc_variant_get_string_const_ex(key, &len);
                 assert(ks != NULL);
-                n = serialize_string(rws, ks, len, flags, len_expected);
-                MY_CHECK(n);
-                MY_WRITE(rws, "\"", 1);
-
-                MY_WRITE(rws, ":", 1);
-                n = print_space(rws, flags, len_expected);
-                MY_CHECK(n);
+                MY_PUTC(s, '"');
+                MY_CHECK(serialize_string(s, ks, len));
+                MY_WRITE(s, "\":", 2);
+                MY_CHECK(print_space(s));
 
                 // value
-                n = purc_variant_serialize(member,
-                        rws, level + 1, flags, len_expected);
-                MY_CHECK(n);
+                MY_CHECK(serialize_variant(s, member, level + 1));
 
                 i++;
             end_foreach;
 
-            if (i > 0) {
-                n = print_newline(rws, flags, len_expected);
-                MY_CHECK(n);
-            }
-
-            n = print_indent(rws, level, flags, len_expected);
-            MY_CHECK(n);
-
-            n = print_space_no_pretty(rws, flags, len_expected);
-            MY_CHECK(n);
-
-            MY_WRITE(rws, "}", 1);
+            MY_CHECK(print_container_suffix(s, i, level, '}'));
             break;
 
         case PURC_VARIANT_TYPE_ARRAY:
-            content = NULL;
-
-            n = print_indent(rws, level, flags, len_expected);
-            MY_CHECK(n);
-
-            MY_WRITE(rws, "[", 1);
-            n = print_newline(rws, flags, len_expected);
-            MY_CHECK(n);
+            MY_CHECK(print_indent(s, level));
+            MY_PUTC(s, '[');
+            MY_CHECK(print_newline(s));
 
             i = 0;
             foreach_value_in_variant_array(value, member, idx)
                 (void)idx;
-                if (i > 0) {
-                    MY_WRITE(rws, ",", 1);
-                    n = print_newline(rws, flags, len_expected);
-                    MY_CHECK(n);
-                }
-
-                n = print_space_no_pretty(rws, flags, len_expected);
-                MY_CHECK(n);
-
-                n = print_indent(rws, level + 1, flags, len_expected);
-                MY_CHECK(n);
+                MY_CHECK(print_member_prefix(s, i == 0, level));
 
                 // member
-                n = purc_variant_serialize(member,
-                        rws, level + 1, flags, len_expected);
-                MY_CHECK(n);
+                MY_CHECK(serialize_variant(s, member, level + 1));
 
                 i++;
             end_foreach;
 
-            if (i > 0) {
-                n = print_newline(rws, flags, len_expected);
-                MY_CHECK(n);
-            }
-
-            n = print_indent(rws, level, flags, len_expected);
-            MY_CHECK(n);
-
-            n = print_space_no_pretty(rws, flags, len_expected);
-            MY_CHECK(n);
-
-            MY_WRITE(rws, "]", 1);
+            MY_CHECK(print_container_suffix(s, i, level, ']'));
             break;
 
         case PURC_VARIANT_TYPE_SET:
-            content = NULL;
-
-            n = print_indent(rws, level, flags, len_expected);
-            MY_CHECK(n);
+            MY_CHECK(print_indent(s, level));
 
             if (flags & PCVRNT_SERIALIZE_OPT_UNIQKEYS)
-                MY_WRITE(rws, "[!", 2);
+                MY_WRITE(s, "[!", 2);
             else
-                MY_WRITE(rws, "[", 1);
+                MY_PUTC(s, '[');
 
-            n = print_newline(rws, flags, len_expected);
-            MY_CHECK(n);
+            MY_CHECK(print_newline(s));
 
             if (flags & PCVRNT_SERIALIZE_OPT_UNIQKEYS) {
                 data = pcvar_set_get_data(value);
@@ -952,65 +965,38 @@ ssize_t purc_variant_serialize(purc_variant_t value, purc_rwstream_t rws,
                     for (size_t i=0; i<data->nr_keynames; ++i) {
                         const char *sk = data->keynames[i];
                         if (i>0)
-                            MY_WRITE(rws, " ", 1);
-                        MY_WRITE(rws, sk, strlen(sk));
+                            MY_PUTC(s, ' ');
+                        MY_WRITE(s, sk, strlen(sk));
                     }
                 }
             }
 
             i = 0;
             foreach_value_in_variant_set_order(value, member)
-                if (i > 0 || flags & PCVRNT_SERIALIZE_OPT_UNIQKEYS) {
-                    MY_WRITE(rws, ",", 1);
-                    n = print_newline(rws, flags, len_expected);
-                    MY_CHECK(n);
-                }
-
-                n = print_space_no_pretty(rws, flags, len_expected);
-                MY_CHECK(n);
-
-                n = print_indent(rws, level + 1, flags, len_expected);
-                MY_CHECK(n);
+                MY_CHECK(print_member_prefix(s,
+                            i == 0 && !(flags & PCVRNT_SERIALIZE_OPT_UNIQKEYS),
+                            level));
 
                 // member
-                n = purc_variant_serialize(member,
-                        rws, level + 1, flags, len_expected);
-                MY_CHECK(n);
+                MY_CHECK(serialize_variant(s, member, level + 1));
 
                 i++;
             end_foreach;
 
-            if (i > 0) {
-                n = print_newline(rws, flags, len_expected);
-                MY_CHECK(n);
-            }
-
-            n = print_indent(rws, level, flags, len_expected);
-            MY_CHECK(n);
-
-            n = print_space_no_pretty(rws, flags, len_expected);
-            MY_CHECK(n);
-
-            MY_WRITE(rws, "]", 1);
+            MY_CHECK(print_container_suffix(s, i, level, ']'));
             break;
 
         case PURC_VARIANT_TYPE_TUPLE:
         {
-            content = NULL;
-
-            n = print_indent(rws, level, flags, len_expected);
-            MY_CHECK(n);
+            MY_CHECK(print_indent(s, level));
 
             /* TODO: might use '(' in the future. */
             if (flags & PCVRNT_SERIALIZE_OPT_TUPLE_EJSON)
-                MY_WRITE(rws, "[!", 2);
+                MY_WRITE(s, "[!", 2);
             else
-                MY_WRITE(rws, "[", 1);
-
-            n = print_newline(rws, flags, len_expected);
-            MY_CHECK(n);
+                MY_PUTC(s, '[');
 
-            i = 0;
+            MY_CHECK(print_newline(s));
 
             purc_variant_t *members;
             size_t sz;
@@ -1018,40 +1004,14 @@ ssize_t purc_variant_serialize(purc_variant_t value, purc_rwstream_t rws,
             assert(members);
 
             for (idx = 0; idx < sz; idx++) {
-
-                if (i > 0) {
-                    MY_WRITE(rws, ",", 1);
-                    n = print_newline(rws, flags, len_expected);
-                    MY_CHECK(n);
-                }
-
-                n = print_space_no_pretty(rws, flags, len_expected);
-                MY_CHECK(n);
-
-                n = print_indent(rws, level + 1, flags, len_expected);
-                MY_CHECK(n);
+                MY_CHECK(print_member_prefix(s, idx == 0, level));
 
                 // member
-                n = purc_variant_serialize(members[idx],
-                        rws, level + 1, flags, len_expected);
-                MY_CHECK(n);
-
-                i++;
+                MY_CHECK(serialize_variant(s, members[idx], level + 1));
             }
 
-            if (i > 0) {
-                n = print_newline(rws, flags, len_expected);
-                MY_CHECK(n);
-            }
-
-            n = print_indent(rws, level, flags, len_expected);
-            MY_CHECK(n);
-
-            n = print_space_no_pretty(rws, flags, len_expected);
-            MY_CHECK(n);
-
-            /* TODO: might use ']' in the future. */
-            MY_WRITE(rws, "]", 1);
+            /* TODO: might use ')' in the future. */
+            MY_CHECK(print_container_suffix(s, sz, level, ']'));
             break;
         }
 
@@ -1061,12 +1021,46 @@ ssize_t purc_variant_serialize(purc_variant_t value, purc_rwstream_t rws,
 
     if (content) {
         // for simple types
-        MY_WRITE(rws, content, strlen (content));
+        MY_WRITE(s, content, strlen (content));
     }
 
-    return nr_written;
+    return 0;
 
 failed:
     return -1;
 }
 
+static void
+serializer_init(struct serializer *s, purc_rwstream_t rws,
+        unsigned int flags, size_t *len_expected)
+{
+    s->rws = rws;
+    s->flags = flags;
+    s->len_expected = len_expected;
+    s->nr_written = 0;
+    s->failed = false;
+    s->len = 0;
+
+    s->format_double = NULL;
+    s->format_long_double = NULL;
+    purc_get_local_data(PURC_LDNAME_FORMAT_DOUBLE,
+            (uintptr_t *)&s->format_double, NULL);
+    purc_get_local_data(PURC_LDNAME_FORMAT_LDOUBLE,
+            (uintptr_t *)&s->format_long_double, NULL);
+}
+
+ssize_t purc_variant_serialize(purc_variant_t value, purc_rwstream_t rws,
+        int level, unsigned int flags, size_t *len_expected)
+{
+    struct serializer s;
+    serializer_init(&s, rws, flags, len_expected);
+
+    int r = serialize_variant(&s, value, level);
+    if (flush_output(&s))
+        r = -1;
+
+    if (s.failed && (flags & PCVRNT_SERIALIZE_OPT_IGNORE_ERRORS))
+        r = 0;
+
+    return r ? -1 : s.nr_written;
+}
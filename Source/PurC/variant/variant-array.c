@@ -689,6 +689,64 @@ pcvar_arr_append(purc_variant_t arr, purc_variant_t val)
     return variant_arr_append(arr, val, check);
 }
 
+int
+pcvar_arr_remove_marked(purc_variant_t arr, const uint8_t *marks,
+        size_t nr_marks)
+{
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    PC_ASSERT(data);
+
+    struct pcutils_array_list *al = &data->al;
+    size_t nr = pcutils_array_list_length(al);
+    if (nr_marks > nr)
+        nr_marks = nr;
+
+    /* Somebody may veto or watch the removals, or the array is a member of
+       a set whose uniqueness must be checked for every removal; remove the
+       members one by one from the tail then. */
+    if (!list_empty(&arr->listeners) || pcvar_container_belongs_to_set(arr)) {
+        int r = 0;
+        for (size_t i = nr_marks; i > 0; i--) {
+            if (marks[i - 1]) {
+                r = variant_arr_remove(arr, i - 1, true);
+                if (r)
+                    break;
+            }
+        }
+
+        refresh_extra(arr);
+        return r;
+    }
+
+    /* Otherwise, compact the array in one pass. */
+    size_t nr_kept = 0;
+    for (size_t i = 0; i < nr; i++) {
+        struct pcutils_array_list_node *p = al->nodes[i];
+        if (i < nr_marks && marks[i]) {
+            struct arr_node *node;
+            node = (struct arr_node*)container_of(p, struct arr_node, node);
+            list_del(&p->node);
+            p->idx = (size_t)-1;
+            arr_node_destroy(arr, node);
+        }
+        else {
+            al->nodes[nr_kept] = p;
+            p->idx = nr_kept;
+            nr_kept++;
+        }
+    }
+
+    for (size_t i = nr_kept; i < nr; i++)
+        al->nodes[i] = NULL;
+    al->nr = nr_kept;
+
+    if (nr_kept < nr)
+        pcvar_adjust_set_by_descendant(arr);
+
+    refresh_extra(arr);
+    return 0;
+}
+
 static purc_variant_t
 pv_make_array_n (bool check, size_t sz, purc_variant_t value0, va_list ap)
 {
@@ -760,6 +818,23 @@ void pcvariant_array_release (purc_variant_t value)
     array_release(value);
 }
 
+size_t pcvariant_array_release_members(purc_variant_t value, size_t max)
+{
+    variant_arr_t data = pcvar_arr_get_data(value);
+    if (!data)
+        return 0;
+
+    struct pcutils_array_list *al = &data->al;
+    struct arr_node *p, *n;
+    array_list_for_each_entry_reverse_safe(al, p, n, node) {
+        if (max-- == 0)
+            break;
+        arr_node_destroy(value, p);
+    };
+
+    return variant_arr_length(data);
+}
+
 /* VWNOTE: unnecessary
 int pcvariant_array_compare (purc_variant_t lv, purc_variant_t rv)
 {
@@ -922,11 +997,16 @@ int pcvariant_array_sort(purc_variant_t arr, void *ud,
 purc_variant_t
 pcvariant_array_clone(purc_variant_t arr, bool recursively)
 {
-    purc_variant_t var;
-    var = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    variant_arr_t from = pcvar_arr_get_data(arr);
+    size_t nr = pcutils_array_list_length(&from->al);
+
+    /* The clone is a fresh array without listener or parent, so we
+     * append the members to the preallocated list directly. */
+    purc_variant_t var = make_array(nr);
     if (var == PURC_VARIANT_INVALID)
         return PURC_VARIANT_INVALID;
 
+    struct pcutils_array_list *al = &pcvar_arr_get_data(var)->al;
     purc_variant_t v;
     size_t idx;
     foreach_value_in_variant_array(arr, v, idx) {
@@ -942,15 +1022,21 @@ pcvariant_array_clone(purc_variant_t arr, bool recursively)
             purc_variant_unref(var);
             return PURC_VARIANT_INVALID;
         }
-        bool ok;
-        ok = purc_variant_array_append(var, val);
+
+        struct arr_node *node = arr_node_create(val);
         purc_variant_unref(val);
-        if (!ok) {
+        if (!node) {
             purc_variant_unref(var);
             return PURC_VARIANT_INVALID;
         }
+
+        int r = pcutils_array_list_append(al, &node->node);
+        PC_ASSERT(r == 0);
+        (void)r;
     } end_foreach;
 
+    refresh_extra(var);
+
     PC_ASSERT(var != arr);
     return var;
 }
@@ -73,6 +73,13 @@ void pcvariant_set_release     (purc_variant_t value)    WTF_INTERNAL;
 void pcvariant_tuple_release   (purc_variant_t value)    WTF_INTERNAL;
 void pcvariant_sorted_array_release (purc_variant_t value)    WTF_INTERNAL;
 
+// release at most max members of an array or object to be released,
+// without firing any event; returns the number of the remaining members
+size_t pcvariant_array_release_members(purc_variant_t value, size_t max)
+    WTF_INTERNAL;
+size_t pcvariant_object_release_members(purc_variant_t value, size_t max)
+    WTF_INTERNAL;
+
 variant_arr_t
 pcvar_arr_get_data(purc_variant_t arr) WTF_INTERNAL;
 variant_obj_t
@@ -101,6 +108,11 @@ pcvar_reverse_check(purc_variant_t old, purc_variant_t _new) WTF_INTERNAL;
 bool
 pcvar_container_belongs_to_set(purc_variant_t val) WTF_INTERNAL;
 
+// whether any listener for op on the container will be called at once,
+// that is, a pre listener, or a post one which is not deferred by a batch
+bool
+pcvar_has_immediate_listener(purc_variant_t ctnr, pcvar_op_t op) WTF_INTERNAL;
+
 purc_variant_t
 pcvariant_container_clone(purc_variant_t cntr, bool recursively) WTF_INTERNAL;
 
@@ -288,18 +300,40 @@ pcvar_make_arr(void);
 int
 pcvar_arr_append(purc_variant_t arr, purc_variant_t val);
 
+// remove the members whose marks are non-zero; returns 0 on success
+int
+pcvar_arr_remove_marked(purc_variant_t arr, const uint8_t *marks,
+        size_t nr_marks);
+
 purc_variant_t
 pcvar_make_obj(void);
 
 int
 pcvar_obj_set(purc_variant_t obj, purc_variant_t k, purc_variant_t v);
 
+// prepare a member to be merged; returns a new reference
+typedef purc_variant_t (*pcvar_prepare_member_fn)(purc_variant_t val);
+
+// merge the members of src into dst in one pass; the existing members are
+// kept or overwritten according to cr_method (IGNORE or OVERWRITE only);
+// prepare can be NULL. Returns the number of the members added or
+// overwritten, or -1 on failure.
+ssize_t
+pcvar_obj_merge(purc_variant_t dst, purc_variant_t src,
+        pcvrnt_cr_method_k cr_method, pcvar_prepare_member_fn prepare);
+
 purc_variant_t
 pcvar_make_set(variant_set_t data);
 
 int
 pcvar_set_add(purc_variant_t set, purc_variant_t val);
 
+// check whether `node` of `set` would still be unique if its member were
+// replaced by `val`; this is one lookup in the index of the set
+bool
+pcvar_set_is_unique_after_change(purc_variant_t set, struct set_node *node,
+        purc_variant_t val);
+
 int
 pcvar_readjust_set(purc_variant_t set, struct set_node *node);
 
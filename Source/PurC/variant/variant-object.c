@@ -585,6 +585,179 @@ v_object_set(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
     return -1;
 }
 
+/* link the new node just before `next` in the order of the keys;
+   `next` is NULL if the node goes to the end */
+static void
+link_node_before(struct rb_root *root, struct rb_node *next,
+        struct rb_node *node)
+{
+    struct rb_node *parent;
+    struct rb_node **link;
+
+    if (next == NULL) {
+        parent = pcutils_rbtree_last(root);
+        link = parent ? &parent->rb_right : &root->rb_node;
+    }
+    else if (next->rb_left == NULL) {
+        parent = next;
+        link = &next->rb_left;
+    }
+    else {
+        /* the predecessor has no right child */
+        parent = pcutils_rbtree_prev(next);
+        link = &parent->rb_right;
+    }
+
+    pcutils_rbtree_link_node(node, parent, link);
+    pcutils_rbtree_insert_color(node, root);
+}
+
+static int
+merge_member(purc_variant_t obj, struct rb_node *next,
+        struct obj_node *node, purc_variant_t k, purc_variant_t v,
+        pcvar_prepare_member_fn prepare)
+{
+    variant_obj_t data = pcvar_obj_get_data(obj);
+    purc_variant_t val;
+
+    val = prepare ? prepare(v) : purc_variant_ref(v);
+    if (val == PURC_VARIANT_INVALID)
+        return -1;
+
+    if (node == NULL) {
+        node = obj_node_create(k, val);
+        if (node == NULL) {
+            purc_variant_unref(val);
+            return -1;
+        }
+
+        link_node_before(&data->kvs, next, &node->node);
+        ++data->size;
+
+        grown(obj, k, val, true);
+    }
+    else if (node->val != val) {
+        purc_variant_t ko = node->key;
+        purc_variant_t vo = node->val;
+
+        break_rev_update_chain(obj, node);
+        node->key = purc_variant_ref(k);
+        node->val = purc_variant_ref(val);
+
+        changed(obj, ko, vo, k, val, true);
+
+        purc_variant_unref(ko);
+        purc_variant_unref(vo);
+    }
+
+    purc_variant_unref(val);
+    return 0;
+}
+
+static ssize_t
+merge_by_setter(purc_variant_t dst, purc_variant_t src,
+        pcvrnt_cr_method_k cr_method, pcvar_prepare_member_fn prepare)
+{
+    ssize_t nr = 0;
+    purc_variant_t k, v;
+
+    foreach_key_value_in_variant_object(src, k, v)
+        purc_variant_t o = purc_variant_object_get(dst, k);
+        if (o) {
+            if (cr_method == PCVRNT_CR_METHOD_IGNORE)
+                continue;
+        }
+        else {
+            /* clr PCVRNT_ERROR_NO_SUCH_KEY */
+            purc_clr_error();
+        }
+
+        purc_variant_t val = prepare ? prepare(v) : purc_variant_ref(v);
+        if (val == PURC_VARIANT_INVALID)
+            return -1;
+
+        bool ok = purc_variant_object_set(dst, k, val);
+        purc_variant_unref(val);
+        if (!ok)
+            return -1;
+        nr++;
+    end_foreach;
+
+    return nr;
+}
+
+/*
+ * Both objects keep their members in the order of the keys, so we walk
+ * them side by side: every key of the source is compared only with the
+ * keys of the destination between the previous position and the new one,
+ * and a new member is linked to the known position without searching the
+ * tree again.
+ *
+ * This only works if nobody can touch the destination during the walk,
+ * and the constraints of sets are not involved. So we fall back to the
+ * public setter if the destination belongs to a set, or has a pre
+ * listener, or has a post listener which is not deferred by a batch.
+ */
+ssize_t
+pcvar_obj_merge(purc_variant_t dst, purc_variant_t src,
+        pcvrnt_cr_method_k cr_method, pcvar_prepare_member_fn prepare)
+{
+    PC_ASSERT(cr_method == PCVRNT_CR_METHOD_IGNORE ||
+            cr_method == PCVRNT_CR_METHOD_OVERWRITE);
+
+    ssize_t nr = 0;
+    struct pcvar_batch *batch = pcvariant_begin_batch(dst);
+
+    if (pcvar_container_belongs_to_set(dst) ||
+            pcvar_has_immediate_listener(dst,
+                PCVAR_OPERATION_GROW | PCVAR_OPERATION_CHANGE)) {
+        nr = merge_by_setter(dst, src, cr_method, prepare);
+        goto done;
+    }
+
+    variant_obj_t data = pcvar_obj_get_data(dst);
+    struct rb_node *next = pcutils_rbtree_first(&data->kvs);
+
+    purc_variant_t k, v;
+    foreach_key_value_in_variant_object(src, k, v)
+        const char *sk = purc_variant_get_string_const(k);
+
+        struct obj_node *found = NULL;
+        while (next) {
+            struct obj_node *node = container_of(next, struct obj_node, node);
+            int ret = strcmp(sk, purc_variant_get_string_const(node->key));
+            if (ret < 0)
+                break;
+
+            if (ret == 0) {
+                found = node;
+                break;
+            }
+
+            next = pcutils_rbtree_next(next);
+        }
+
+        if (found && cr_method == PCVRNT_CR_METHOD_IGNORE)
+            continue;
+
+        if (merge_member(dst, next, found, k, v, prepare)) {
+            nr = -1;
+            break;
+        }
+
+        if (found)
+            next = pcutils_rbtree_next(next);
+        nr++;
+    end_foreach;
+
+    size_t extra = OBJ_EXTRA_SIZE(data);
+    pcvariant_stat_set_extra_size(dst, extra);
+
+done:
+    pcvariant_end_batch(batch);
+    return nr;
+}
+
 purc_variant_t
 pcvar_make_obj(void)
 {
@@ -772,6 +945,28 @@ void pcvariant_object_release (purc_variant_t value)
     pcvariant_stat_set_extra_size(value, 0);
 }
 
+size_t pcvariant_object_release_members(purc_variant_t value, size_t max)
+{
+    variant_obj_t data = pcvar_obj_get_data(value);
+    if (!data)
+        return 0;
+
+    struct rb_root *root = &data->kvs;
+
+    struct rb_node *p, *n;
+    pcutils_rbtree_for_each_safe(pcutils_rbtree_first(root), p, n) {
+        if (max-- == 0)
+            break;
+
+        struct obj_node *node;
+        node = container_of(p, struct obj_node, node);
+
+        obj_node_destroy(value, node);
+    }
+
+    return data->size;
+}
+
 /* VWNOTE: unnecessary
 int pcvariant_object_compare (purc_variant_t lv, purc_variant_t rv)
 {
@@ -993,36 +1188,93 @@ pcvrnt_object_iterator_get_value(struct pcvrnt_object_iterator* it)
     return it->it.curr->val;
 }
 
+static void
+free_subtree(struct rb_node *node)
+{
+    if (node->rb_left)
+        free_subtree(node->rb_left);
+    if (node->rb_right)
+        free_subtree(node->rb_right);
+
+    struct obj_node *p = container_of(node, struct obj_node, node);
+    PURC_VARIANT_SAFE_CLEAR(p->key);
+    PURC_VARIANT_SAFE_CLEAR(p->val);
+    free(p);
+}
+
+/* copy the tree with the same shape and colors, so no key is compared
+   and no node is rebalanced */
+static struct rb_node *
+copy_subtree(const struct rb_node *src, struct rb_node *parent,
+        bool recursively)
+{
+    const struct obj_node *from;
+    from = container_of(src, struct obj_node, node);
+
+    struct obj_node *to = (struct obj_node*)calloc(1, sizeof(*to));
+    if (!to) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    to->node.rb_color = src->rb_color;
+    to->node.rb_parent = parent;
+    /* the keys are immutable strings, share them */
+    to->key = purc_variant_ref(from->key);
+    if (recursively)
+        to->val = pcvariant_container_clone(from->val, recursively);
+    else
+        to->val = purc_variant_ref(from->val);
+
+    if (to->val == PURC_VARIANT_INVALID)
+        goto failed;
+
+    if (src->rb_left) {
+        to->node.rb_left = copy_subtree(src->rb_left, &to->node,
+                recursively);
+        if (!to->node.rb_left)
+            goto failed;
+    }
+
+    if (src->rb_right) {
+        to->node.rb_right = copy_subtree(src->rb_right, &to->node,
+                recursively);
+        if (!to->node.rb_right)
+            goto failed;
+    }
+
+    return &to->node;
+
+failed:
+    free_subtree(&to->node);
+    return NULL;
+}
+
 purc_variant_t
 pcvariant_object_clone(purc_variant_t obj, bool recursively)
 {
-    purc_variant_t var;
-    var = purc_variant_make_object(0,
-            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    purc_variant_t var = v_object_new_with_capacity();
     if (var == PURC_VARIANT_INVALID)
         return PURC_VARIANT_INVALID;
 
-    purc_variant_t k,v;
-    foreach_key_value_in_variant_object(obj, k, v) {
-        purc_variant_t val;
-        if (recursively) {
-            val = pcvariant_container_clone(v, recursively);
-        }
-        else {
-            val = purc_variant_ref(v);
-        }
-        if (val == PURC_VARIANT_INVALID) {
-            purc_variant_unref(var);
-            return PURC_VARIANT_INVALID;
-        }
-        bool ok;
-        ok = purc_variant_object_set(var, k, val);
-        purc_variant_unref(val);
-        if (!ok) {
+    /* The clone is a fresh object: there is neither listener nor parent
+     * to notify, and the source has no duplicated key. So we copy the
+     * tree of the source directly in linear time instead of inserting
+     * the members one by one. */
+    variant_obj_t from = pcvar_obj_get_data(obj);
+    variant_obj_t data = pcvar_obj_get_data(var);
+    if (from->kvs.rb_node) {
+        data->kvs.rb_node = copy_subtree(from->kvs.rb_node, NULL,
+                recursively);
+        if (!data->kvs.rb_node) {
             purc_variant_unref(var);
             return PURC_VARIANT_INVALID;
         }
-    } end_foreach;
+        data->size = from->size;
+    }
+
+    size_t extra = OBJ_EXTRA_SIZE(data);
+    pcvariant_stat_set_extra_size(var, extra);
 
     PC_ASSERT(var != obj);
     return var;
@@ -1259,6 +1511,12 @@ purc_variant_object_unite(purc_variant_t dst,
         goto out;
     }
 
+    if (cr_method == PCVRNT_CR_METHOD_IGNORE ||
+            cr_method == PCVRNT_CR_METHOD_OVERWRITE) {
+        ret = pcvar_obj_merge(dst, src, cr_method, NULL);
+        goto out;
+    }
+
     ret = 0;
     purc_variant_t k, v;
     foreach_key_value_in_variant_object(src, k, v)
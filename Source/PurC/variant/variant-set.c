@@ -443,8 +443,6 @@ find_element_rb_node(struct element_rb_node *node,
     struct rb_node **pnode = &root->rb_node;
     struct rb_node *parent = NULL;
     struct rb_node *entry = NULL;
-    char md5[33];
-    pcvariant_md5_by_set(md5, kvs, set);
 
     while (*pnode) {
         struct set_node *on;
@@ -453,9 +451,6 @@ find_element_rb_node(struct element_rb_node *node,
         if (0) {
             diff = variant_set_compare_by_set_keys(set, kvs, on->val);
         }
-        else if (0) {
-            diff = pcvariant_diff_by_set(md5, kvs, on->md5, on->val, set);
-        }
         else {
             diff = _compare(kvs, on->val, data);
         }
@@ -2119,6 +2114,21 @@ pcvar_adjust_set_by_edge(purc_variant_t set,
     PC_ASSERT(0);
 }
 
+bool
+pcvar_set_is_unique_after_change(purc_variant_t set, struct set_node *node,
+        purc_variant_t val)
+{
+    PC_ASSERT(set != PURC_VARIANT_INVALID);
+    PC_ASSERT(purc_variant_is_set(set));
+
+    // the tree is still ordered by the current members, so one lookup
+    // tells whether any member other than `node` equals the new value
+    struct element_rb_node rbn;
+    find_element_rb_node(&rbn, set, val);
+
+    return rbn.entry == NULL || rbn.entry == &node->rbnode;
+}
+
 int
 pcvar_readjust_set(purc_variant_t set, struct set_node *node)
 {
@@ -2126,6 +2136,20 @@ pcvar_readjust_set(purc_variant_t set, struct set_node *node)
     PC_ASSERT(purc_variant_is_set(set));
     variant_set_t data = pcvar_set_get_data(set);
 
+    pcvariant_md5_by_set(node->md5, node->val, set);
+
+    // most changes do not touch the unique keys: keep the node in place
+    // if it still sorts between its neighbours
+    struct rb_node *prev = pcutils_rbtree_prev(&node->rbnode);
+    struct rb_node *next = pcutils_rbtree_next(&node->rbnode);
+    if ((prev == NULL || _compare(node->val,
+                    container_of(prev, struct set_node, rbnode)->val,
+                    data) > 0) &&
+            (next == NULL || _compare(node->val,
+                    container_of(next, struct set_node, rbnode)->val,
+                    data) < 0))
+        return 0;
+
     pcutils_rbtree_erase(&node->rbnode, &data->elems);
 
     struct element_rb_node rbn;
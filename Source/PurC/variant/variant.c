@@ -31,6 +31,7 @@
 #include "private/debug.h"
 #include "private/dvobjs.h"
 #include "private/utils.h"
+#include "private/dtoa.h"
 #include "variant-internals.h"
 
 #include <stdlib.h>
@@ -38,6 +39,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <float.h>
+#include <time.h>
 
 #if OS(LINUX) || OS(UNIX)
     #include <dlfcn.h>
@@ -138,6 +140,11 @@ static void _cleanup_instance(struct pcinst *inst)
 {
     struct pcvariant_heap *heap = inst->variant_heap;
 
+    if (heap) {
+        heap->dying = &heap->own_dying;
+        pcvariant_release_deferred(&heap->own_dying, 0);
+    }
+
     if (inst->variables) {
         pcvarmgr_destroy(inst->variables);
         inst->variables = NULL;
@@ -176,6 +183,8 @@ static void _cleanup_instance(struct pcinst *inst)
     }
 #endif
 
+    free(heap->own_dying.values);
+
     assert(heap->v_undefined.refc == 0);
     assert(heap->v_null.refc == 0);
     assert(heap->v_true.refc == 0);
@@ -199,6 +208,7 @@ static int _init_instance(struct pcinst *curr_inst,
     }
 
     inst->org_vrt_heap = inst->variant_heap;
+    inst->variant_heap->dying = &inst->variant_heap->own_dying;
 
     // initialize const values in instance
     inst->variant_heap->v_undefined.type = PURC_VARIANT_TYPE_UNDEFINED;
@@ -361,6 +371,75 @@ purc_variant_t purc_variant_ref (purc_variant_t value)
     return value;
 }
 
+static void
+release_value(purc_variant_t value)
+{
+    // release the extra memory used by the variant
+    pcvariant_release_fn release_fn = variant_releasers[value->type];
+    if (release_fn)
+        release_fn(value);
+
+    // release the variant itself
+    pcvariant_put(value);
+}
+
+static int
+push_dying(struct pcvariant_dying *dying, purc_variant_t value)
+{
+    if (dying->nr == dying->sz) {
+        size_t sz = dying->sz ? dying->sz * 2 : 64;
+        purc_variant_t *values = realloc(dying->values, sz * sizeof(*values));
+        if (values == NULL)
+            return -1;
+
+        dying->values = values;
+        dying->sz = sz;
+    }
+
+    dying->values[dying->nr++] = value;
+    return 0;
+}
+
+/*
+ * A container whose last reference is dropped while releasing another
+ * value, or while the release is deferred, is pushed to a stack of the
+ * dying values instead of being released at once. So releasing a deep
+ * structure does not recurse, and the outermost call releases the
+ * pushed containers one by one, unless the release is deferred; in that
+ * case, they are pushed to the stack given to pcvariant_defer_release()
+ * and released by pcvariant_release_deferred().
+ *
+ * The values of the move heap are always released at once.
+ */
+static void
+release_or_defer(purc_variant_t value)
+{
+    struct pcinst *inst = pcinst_current();
+    struct pcvariant_heap *heap = inst->variant_heap;
+
+    if (heap != inst->org_vrt_heap) {
+        release_value(value);
+        return;
+    }
+
+    bool deferred = (heap->dying != &heap->own_dying);
+    if (IS_CONTAINER(value->type) && (heap->releasing || deferred) &&
+            push_dying(heap->dying, value) == 0)
+        return;
+
+    bool releasing = heap->releasing;
+    heap->releasing = true;
+    release_value(value);
+
+    if (!releasing && !deferred) {
+        while (heap->own_dying.nr > 0) {
+            release_value(heap->own_dying.values[--heap->own_dying.nr]);
+        }
+    }
+
+    heap->releasing = releasing;
+}
+
 unsigned int purc_variant_unref(purc_variant_t value)
 {
     PC_ASSERT(value);
@@ -378,19 +457,115 @@ unsigned int purc_variant_unref(purc_variant_t value)
 
     // VWNOTE: only non-constant values has a releaser
     if (value->refc == 0 && !(value->flags & PCVRNT_FLAG_NOFREE)) {
-        // release the extra memory used by the variant
-        pcvariant_release_fn release_fn = variant_releasers[value->type];
-        if (release_fn)
-            release_fn(value);
-
-        // release the variant itself
-        pcvariant_put(value);
+        release_or_defer(value);
         return 0;
     }
 
     return value->refc;
 }
 
+struct pcvariant_dying *
+pcvariant_defer_release(struct pcvariant_dying *dying)
+{
+    struct pcinst *inst = pcinst_current();
+    struct pcvariant_heap *heap = inst->org_vrt_heap;
+
+    struct pcvariant_dying *old = heap->dying;
+    heap->dying = dying ? dying : &heap->own_dying;
+    return (old == &heap->own_dying) ? NULL : old;
+}
+
+#define NR_MEMBERS_RELEASED_AT_ONCE     64
+
+/* A large array or object is emptied piece by piece, so that releasing
+   it can be split across time budgets as well. Returns false if the
+   container should be released in one go. A container with listeners is
+   left whole, so that they see all members when it is released. */
+static bool
+release_some_members(purc_variant_t value)
+{
+    size_t sz;
+
+    if (!list_empty(&value->listeners))
+        return false;
+
+    switch (value->type) {
+    case PURC_VARIANT_TYPE_ARRAY:
+        if (!purc_variant_array_size(value, &sz) ||
+                sz <= NR_MEMBERS_RELEASED_AT_ONCE)
+            return false;
+        pcvariant_array_release_members(value, NR_MEMBERS_RELEASED_AT_ONCE);
+        return true;
+
+    case PURC_VARIANT_TYPE_OBJECT:
+        if (!purc_variant_object_size(value, &sz) ||
+                sz <= NR_MEMBERS_RELEASED_AT_ONCE)
+            return false;
+        pcvariant_object_release_members(value, NR_MEMBERS_RELEASED_AT_ONCE);
+        return true;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+size_t pcvariant_release_deferred(struct pcvariant_dying *dying,
+        unsigned int budget_ms)
+{
+    struct pcinst *inst = pcinst_current();
+    struct pcvariant_heap *heap = inst->org_vrt_heap;
+
+    if (dying->nr == 0 || heap != inst->variant_heap)
+        return dying->nr;
+
+    struct timespec begin;
+    if (budget_ms)
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    /* the containers dropped meanwhile go to the same stack */
+    struct pcvariant_dying *old = heap->dying;
+    bool releasing = heap->releasing;
+    heap->dying = dying;
+    heap->releasing = true;
+
+    size_t n = 0;
+    while (dying->nr > 0) {
+        purc_variant_t value = dying->values[dying->nr - 1];
+
+        if (budget_ms && release_some_members(value)) {
+            /* the container stays on the stack; the containers dropped
+               with the members are pushed above it */
+            n += NR_MEMBERS_RELEASED_AT_ONCE;
+        }
+        else {
+            dying->nr--;
+            release_value(value);
+            n++;
+        }
+
+        /* check the time every some values */
+        if (budget_ms && n >= 64) {
+            n = 0;
+            if (purc_get_elapsed_milliseconds(&begin, NULL) >= budget_ms)
+                break;
+        }
+    }
+
+    heap->releasing = releasing;
+    heap->dying = old;
+    return dying->nr;
+}
+
+void pcvariant_release_dying(struct pcvariant_dying *dying)
+{
+    pcvariant_release_deferred(dying, 0);
+    free(dying->values);
+    dying->values = NULL;
+    dying->sz = 0;
+}
+
 const struct purc_variant_stat *purc_variant_usage_stat(void)
 {
     struct pcinst *inst = pcinst_current();
@@ -1640,6 +1815,21 @@ ret:
     return value;
 }
 
+purc_variant_t
+purc_variant_load_from_json_stream_ex(purc_rwstream_t stream,
+        unsigned int opts)
+{
+    if (stream == NULL) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    if (opts & PCVRNT_LOAD_OPT_LAZY) {
+        return pcvariant_load_lazy_json(stream);
+    }
+
+    return purc_variant_load_from_json_stream(stream);
+}
+
 purc_variant_t purc_variant_make_from_json_string(const char* json, size_t sz)
 {
     purc_variant_t value;
@@ -1866,7 +2056,7 @@ numerify_str(const char *s)
     if (!s || !*s)
         return 0.0;
 
-    return strtod(s, NULL);
+    return pcutils_strtod(s, NULL);
 }
 
 static double
@@ -2579,16 +2769,28 @@ ssize_t pcvariant_serialize(char *buf, size_t sz, purc_variant_t val)
 
 char* pcvariant_serialize_alloc(char *buf, size_t sz, purc_variant_t val)
 {
-    int r = pcvariant_serialize(buf, sz, val);
-    PC_ASSERT(r > 0); // FIXME:
+    /* serialize into the caller's buffer first; the serializer counts the
+     * full length even if the output is truncated, so we only need to
+     * allocate and serialize again when the buffer is too small */
+    purc_rwstream_t out = purc_rwstream_new_from_mem(buf, sz);
+    PC_ASSERT(out); // FIXME:
+
+    size_t len_expected = 0;
+    purc_variant_serialize(val, out, 0,
+            PCVRNT_SERIALIZE_OPT_PLAIN | PCVRNT_SERIALIZE_OPT_IGNORE_ERRORS,
+            &len_expected);
+    purc_rwstream_destroy(out);
 
-    if ((size_t)r < sz)
+    if (len_expected < sz) {
+        buf[len_expected] = '\0';
         return buf;
+    }
 
-    char *p = (char*)malloc(r + 1);
+    char *p = (char*)malloc(len_expected + 1);
     PC_ASSERT(p); // FIXME:
-    r = pcvariant_serialize(p, r+1, val);
+    ssize_t r = pcvariant_serialize(p, len_expected + 1, val);
     PC_ASSERT(r > 0);
+    (void)r;
 
     return p;
 }
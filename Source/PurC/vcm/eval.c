@@ -596,6 +596,14 @@ eval_frame(struct pcvcm_eval_ctxt *ctxt, int32_t frame_idx, size_t return_pos,
                     if (v) {
                         continue;
                     }
+                    if ((ctxt->flags & PCVCM_EVAL_FLAG_PREEMPTIBLE) &&
+                            (++ctxt->nr_params_evaluated &
+                             PCVCM_PREEMPT_CHECK_MASK) == 0 &&
+                            pcintr_preempt_if_slice_expired()) {
+                        /* the results got so far are kept in ctxt */
+                        ctxt->preempted = 1;
+                        goto out;
+                    }
                     param = frame->ops->select_param(ctxt, frame, frame->pos);
                     if (!param) {
                         if (frame->step == STEP_EVAL_PARAMS) {
@@ -693,8 +701,22 @@ eval_vcm(struct pcvcm_eval_node *tree,
         ctxt->flags |= PCVCM_EVAL_FLAG_TIMEOUT;
     }
 
+    /* only the evaluation started by the interpreter for an element can
+       be preempted; the nested ones cannot be resumed. */
+    pcintr_coroutine_t co = pcintr_get_coroutine();
+    if (co && co->stack.vcm_preemptible && find_var_ctxt == &co->stack) {
+        co->stack.vcm_preemptible = 0;
+        ctxt->flags |= PCVCM_EVAL_FLAG_PREEMPTIBLE;
+    }
+    else {
+        ctxt->flags &= ~PCVCM_EVAL_FLAG_PREEMPTIBLE;
+    }
+
     if (again) {
-        ctxt->flags |= PCVCM_EVAL_FLAG_AGAIN;
+        /* a preempted evaluation is not a call again for the getters */
+        if (!ctxt->preempted)
+            ctxt->flags |= PCVCM_EVAL_FLAG_AGAIN;
+        ctxt->preempted = 0;
         frame = bottom_frame(ctxt);
     }
     else {
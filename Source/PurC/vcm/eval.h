@@ -43,6 +43,10 @@
 #define PCVCM_EVAL_FLAG_SILENTLY        0x0001
 #define PCVCM_EVAL_FLAG_AGAIN           0x0002
 #define PCVCM_EVAL_FLAG_TIMEOUT         0x0004
+#define PCVCM_EVAL_FLAG_PREEMPTIBLE     0x0008
+
+/* check the time slice once every so many parameters evaluated */
+#define PCVCM_PREEMPT_CHECK_MASK        0xFF
 
 #define KEY_INNER_HANDLER               "__vcm_native_wrapper"
 #define KEY_CALLER_NODE                 "__vcm_caller_node"
@@ -121,8 +125,10 @@ struct pcvcm_eval_ctxt {
 #endif
 
     int                     err;
+    size_t                  nr_params_evaluated;
     unsigned int            enable_log:1;
     unsigned int            free_on_destroy:1;
+    unsigned int            preempted:1;
 };
 
 struct pcvcm_eval_stack_frame_ops {
@@ -93,6 +93,9 @@ struct pcvdom_attr {
     const struct pchvml_attr_entry  *pre_defined;
     char                     *key;
 
+    // the atom of the key in the HVML keyword bucket; 0 for a non-keyword
+    purc_atom_t               key_atom;
+
     // operator
     enum pchvml_attr_operator       op;
 
@@ -111,6 +114,8 @@ struct pcvdom_element {
     pcutils_array_t        *attrs;
 
     unsigned int            self_closing:1;
+    // whether the element is a template or a verb element
+    unsigned int            is_operation:1;
 };
 
 struct pcvdom_content {
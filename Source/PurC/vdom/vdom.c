@@ -31,6 +31,7 @@
 #include "private/stringbuilder.h"
 
 #include "hvml-attr.h"
+#include "keywords.h"
 
 #include "vdom-internal.h"
 
@@ -159,6 +160,8 @@ pcvdom_element_create(pcvdom_tag_id tag)
     if (entry) {
         elem->tag_id   = entry->id;
         elem->tag_name = (char*)entry->name;
+        elem->is_operation = (entry->cats &
+                (PCHVML_TAGCAT_TEMPLATE | PCHVML_TAGCAT_VERB)) ? 1 : 0;
     } else {
         pcinst_set_error(PURC_ERROR_INVALID_VALUE);
         element_destroy(elem);
@@ -186,6 +189,8 @@ pcvdom_element_create_c(const char *tag_name)
     if (entry) {
         elem->tag_id   = entry->id;
         elem->tag_name = (char*)entry->name;
+        elem->is_operation = (entry->cats &
+                (PCHVML_TAGCAT_TEMPLATE | PCHVML_TAGCAT_VERB)) ? 1 : 0;
     } else {
         elem->tag_name = strdup(tag_name);
         if (!elem->tag_name) {
@@ -254,6 +259,7 @@ pcvdom_attr_create(const char *key, enum pchvml_attr_operator op,
         }
     }
 
+    attr->key_atom = PCHVML_KEYWORD_ATOM(HVML, attr->key);
     attr->val = vcm;
 
     return attr;
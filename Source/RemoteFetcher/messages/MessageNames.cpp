@@ -3748,6 +3748,8 @@ const char* description(MessageName name)
     case MessageName::WebResourceLoader_DidReceiveResource:
         return "WebResourceLoader::DidReceiveResource";
 #endif
+    case MessageName::WebResourceLoader_DidReceiveSharedMemory:
+        return "WebResourceLoader::DidReceiveSharedMemory";
     case MessageName::WebSocketChannel_DidConnect:
         return "WebSocketChannel::DidConnect";
     case MessageName::WebSocketChannel_DidClose:
@@ -7358,6 +7360,7 @@ ReceiverName receiverName(MessageName messageName)
 #if ENABLE(SHAREABLE_RESOURCE)
     case MessageName::WebResourceLoader_DidReceiveResource:
 #endif
+    case MessageName::WebResourceLoader_DidReceiveSharedMemory:
         return ReceiverName::WebResourceLoader;
     case MessageName::WebSocketChannel_DidConnect:
     case MessageName::WebSocketChannel_DidClose:
@@ -12421,6 +12424,8 @@ bool isValidMessageName(MessageName messageName)
     if (messageName == IPC::MessageName::WebResourceLoader_DidReceiveResource)
         return true;
 #endif
+    if (messageName == IPC::MessageName::WebResourceLoader_DidReceiveSharedMemory)
+        return true;
     if (messageName == IPC::MessageName::WebSocketChannel_DidConnect)
         return true;
     if (messageName == IPC::MessageName::WebSocketChannel_DidClose)
@@ -102,6 +102,11 @@ using namespace PurCFetcher;
 #define NATIVE_SERVER_PORT      9301
 #undef gengyue 
 
+// Bodies announced at least this large are delivered to the interpreter via
+// one shared memory segment. Keep it in sync with PCFETCHER_SHM_BODY_THRESHOLD
+// in PurC/fetchers/fetcher-internal.h.
+static const long long sharedMemoryBodyThreshold = 1024 * 1024;
+
 static int json_sockfd = -1;
 
 static void send_json_over(void)
@@ -528,6 +533,7 @@ void NetworkResourceLoader::cleanup(LoadResult result)
     m_connection->stopTrackingResourceLoad(m_parameters.identifier, code);
 
     m_bufferingTimer.stop();
+    m_sharedMemoryBody = nullptr;
 
     invalidateSandboxExtensions();
 
@@ -719,6 +725,13 @@ void NetworkResourceLoader::didReceiveResponse(ResourceResponse&& receivedRespon
     else
         m_httpresponsecode = response.httpStatusCode();
 
+    if (!m_parameters.request.getJsonType() && !m_response.isMultipart()
+            && m_response.expectedContentLength() >= sharedMemoryBodyThreshold) {
+        m_sharedMemoryBody = SharedMemory::allocate(m_response.expectedContentLength());
+        m_sharedMemoryBodySize = 0;
+        m_sharedMemoryBodyEncodedDataLength = 0;
+    }
+
     if (m_parameters.pageHasResourceLoadClient)
         m_connection->networkProcess().parentProcessConnection()->send(Messages::NetworkProcessProxy::ResourceLoadDidReceiveResponse(m_parameters.webPageProxyID, resourceLoadInfo(), response), 0);
 
@@ -760,6 +773,9 @@ void NetworkResourceLoader::didReceiveBuffer(Ref<SharedBuffer>&& buffer, int rep
     // FIXME: At least on OS X Yosemite we always get -1 from the resource handle.
     unsigned encodedDataLength = reportedEncodedDataLength >= 0 ? reportedEncodedDataLength : buffer->size();
 
+    if (m_sharedMemoryBody && appendToSharedMemoryBody(buffer.get(), encodedDataLength))
+        return;
+
     if (m_bufferedData) {
         m_bufferedData->append(buffer.get());
         m_bufferedDataEncodedDataLength += encodedDataLength;
@@ -796,6 +812,8 @@ void NetworkResourceLoader::didFinishLoading(const NetworkLoadMetrics& networkLo
     if (isSynchronous())
         sendReplyToSynchronousRequest(*m_synchronousLoadData, m_bufferedData.get());
     else {
+        if (m_sharedMemoryBody)
+            sendSharedMemoryBody();
         if (m_bufferedData && !m_bufferedData->isEmpty()) {
             // FIXME: Pass a real value or remove the encoded data size feature.
             sendBuffer(*m_bufferedData, -1);
@@ -1154,6 +1172,46 @@ void NetworkResourceLoader::sendBuffer(SharedBuffer& buffer, size_t encodedDataL
     }
 }
 
+bool NetworkResourceLoader::appendToSharedMemoryBody(const SharedBuffer& buffer, size_t encodedDataLength)
+{
+    ASSERT(m_sharedMemoryBody);
+
+    if (m_sharedMemoryBodySize + buffer.size() > m_sharedMemoryBody->size()) {
+        // The server sent more than it announced: hand over what we have
+        // and stream the rest through the socket as usual.
+        sendSharedMemoryBody();
+        return false;
+    }
+
+    char* dest = static_cast<char*>(m_sharedMemoryBody->data()) + m_sharedMemoryBodySize;
+    for (const auto& element : buffer) {
+        memcpy(dest, element.segment->data(), element.segment->size());
+        dest += element.segment->size();
+    }
+    m_sharedMemoryBodySize += buffer.size();
+    m_sharedMemoryBodyEncodedDataLength += encodedDataLength;
+    return true;
+}
+
+void NetworkResourceLoader::sendSharedMemoryBody()
+{
+    ASSERT(m_sharedMemoryBody);
+
+    auto sharedMemory = WTFMove(m_sharedMemoryBody);
+    if (!m_sharedMemoryBodySize)
+        return;
+
+    SharedMemory::Handle handle;
+    if (!sharedMemory->createHandle(handle, SharedMemory::Protection::ReadOnly)) {
+        RELEASE_LOG_ERROR_IF_ALLOWED("sendSharedMemoryBody: Failed to create shared memory handle");
+        auto data = SharedBuffer::create(static_cast<const char*>(sharedMemory->data()), m_sharedMemoryBodySize);
+        send(Messages::WebResourceLoader::DidReceiveSharedBuffer({ WTFMove(data) }, m_sharedMemoryBodyEncodedDataLength));
+        return;
+    }
+
+    send(Messages::WebResourceLoader::DidReceiveSharedMemory(handle, m_sharedMemoryBodySize, m_sharedMemoryBodyEncodedDataLength));
+}
+
 void NetworkResourceLoader::tryStoreAsCacheEntry()
 {
 #ifdef gengyue
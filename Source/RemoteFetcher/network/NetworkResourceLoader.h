@@ -38,6 +38,7 @@
 #include "ContentSecurityPolicyClient.h"
 #include "CrossOriginAccessControl.h"
 #include "ResourceResponse.h"
+#include "SharedMemory.h"
 //#include "SecurityPolicyViolationEvent.h"
 #include "Timer.h"
 #include <wtf/WeakPtr.h>
@@ -183,6 +184,8 @@ private:
     void startBufferingTimerIfNeeded();
     void bufferingTimerFired();
     void sendBuffer(PurCFetcher::SharedBuffer&, size_t encodedDataLength);
+    bool appendToSharedMemoryBody(const PurCFetcher::SharedBuffer&, size_t encodedDataLength);
+    void sendSharedMemoryBody();
 
     void consumeSandboxExtensions();
     void invalidateSandboxExtensions();
@@ -217,6 +220,12 @@ private:
 
     size_t m_bufferedDataEncodedDataLength { 0 };
     RefPtr<PurCFetcher::SharedBuffer> m_bufferedData;
+    // Large bodies are collected into one shared memory segment and handed
+    // over to the interpreter as a whole instead of being streamed through
+    // the socket piece by piece.
+    RefPtr<PurCFetcher::SharedMemory> m_sharedMemoryBody;
+    size_t m_sharedMemoryBodySize { 0 };
+    size_t m_sharedMemoryBodyEncodedDataLength { 0 };
     unsigned m_redirectCount { 0 };
 
     std::unique_ptr<SynchronousLoadData> m_synchronousLoadData;
@@ -23,9 +23,17 @@
 */
 
 #include <purc/purc-document.h>
+#include <purc/purc-helpers.h>
+
+#include "private/document.h"
+
+#include "../helpers.h"
 
 #include <stdio.h>
 #include <errno.h>
+#include <time.h>
+#include <iostream>
+#include <string>
 #include <gtest/gtest.h>
 
 static const char *html_contents = ""
@@ -667,4 +675,235 @@ TEST(document, elem_coll_by_id)
     ASSERT_EQ(refc, 1);
 }
 
+TEST(document, content_cache)
+{
+    bool perf = test_perf_enabled();
+
+    purc_document_t doc = purc_document_new(PCDOC_K_TYPE_HTML);
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_element_t body = purc_document_body(doc);
+    ASSERT_NE(body, nullptr);
+
+    static const char *badge =
+        "<span class=\"badge ok\" title=\"status\">OK <em>42</em></span>";
+    const size_t nr_badges = perf ? 100000 : 1000;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t i = 0; i < nr_badges; i++) {
+        pcdoc_node node = pcdoc_element_new_content(doc, body,
+                PCDOC_OP_APPEND, badge, 0);
+        ASSERT_NE(node.elem, nullptr);
+    }
+    if (perf)
+        std::cerr << "inserting the same content " << nr_badges << " times: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    size_t nr_elems = 0, nr_texts = 0, nr_data = 0;
+    ASSERT_EQ(pcdoc_element_children_count(doc, body,
+                &nr_elems, &nr_texts, &nr_data), 0);
+    ASSERT_EQ(nr_elems, nr_badges);
+
+    size_t nr_hits, nr_misses;
+    purc_document_get_content_cache_stats(doc, &nr_hits, &nr_misses);
+    ASSERT_EQ(nr_hits, nr_badges - 1);
+    ASSERT_EQ(nr_misses, 1);
+
+    /* the element with an identifier inserted last is the one found */
+    pcdoc_node first = pcdoc_element_new_content(doc, body,
+            PCDOC_OP_APPEND, "<p id=\"para\">text</p>", 0);
+    pcdoc_node second = pcdoc_element_new_content(doc, body,
+            PCDOC_OP_APPEND, "<p id=\"para\">text</p>", 0);
+    ASSERT_NE(first.elem, second.elem);
+    ASSERT_EQ(pcdoc_get_element_by_id_in_document(doc, "para"), second.elem);
+
+    purc_document_get_content_cache_stats(doc, &nr_hits, &nr_misses);
+    ASSERT_EQ(nr_hits, nr_badges);
+    ASSERT_EQ(nr_misses, 2);
+
+    purc_document_delete(doc);
+}
+
+TEST(document, large_document)
+{
+    bool perf = test_perf_enabled();
+
+    /* an element and a text node for every paragraph */
+    const size_t nr_paras = perf ? 500000 : 5000;
+    std::string paras;
+    for (size_t i = 0; i < nr_paras; i++) {
+        paras += "<p>x</p>";
+    }
+    std::string markup = "<html><body>" + paras + "</body></html>";
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            markup.c_str(), markup.length());
+    ASSERT_NE(doc, nullptr);
+    if (perf)
+        std::cerr << "building a document with " << nr_paras * 2 << " nodes: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    pcdoc_element_t body = purc_document_body(doc);
+    ASSERT_NE(body, nullptr);
+
+    size_t nr_elems = 0;
+    ASSERT_EQ(pcdoc_element_children_count(doc, body,
+                &nr_elems, NULL, NULL), 0);
+    ASSERT_EQ(nr_elems, nr_paras);
+
+    /* the nodes removed are reused by the nodes inserted later */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    pcdoc_element_clear(doc, body);
+    if (perf)
+        std::cerr << "removing " << nr_paras * 2 << " nodes: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    pcdoc_element_new_content(doc, body, PCDOC_OP_APPEND,
+            paras.c_str(), paras.length());
+    if (perf)
+        std::cerr << "inserting " << nr_paras * 2 << " nodes: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    ASSERT_EQ(pcdoc_element_children_count(doc, body,
+                &nr_elems, NULL, NULL), 0);
+    ASSERT_EQ(nr_elems, nr_paras);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_document_delete(doc);
+    if (perf)
+        std::cerr << "destroying the document: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+}
+
+static std::string serialize_body(purc_document_t doc)
+{
+    purc_rwstream_t out = purc_rwstream_new_buffer(1024, 0);
+    pcdoc_serialize_descendants_to_stream(doc, purc_document_body(doc),
+            0, out);
+
+    size_t len;
+    const char *buf = (const char *)purc_rwstream_get_mem_buffer(out, &len);
+    std::string str(buf, len);
+    purc_rwstream_destroy(out);
+    return str;
+}
 
+struct fragment_case {
+    const char *parts[4];
+    size_t      nr_slots;
+    const char *vals[3];
+    /* whether the values are put in the slots, or the caller falls back */
+    bool        fits;
+};
+
+/* the fragment path makes the same tree as parsing the whole markup */
+TEST(document, fragment_same_as_parsing)
+{
+    static struct fragment_case cases[] = {
+        /* slots in attribute values and text */
+        { { "<li class=\"item item-", "\" title=\"Item ",
+              "\"><em>No. ", "</em></li>" }, 3,
+          { "7", "seven", "7th" }, true },
+        { { "<p>", " and ", " &amp; more</p>" }, 2,
+          { "this", "that" }, true },
+        /* the parser drops the leading newline in pre */
+        { { "<pre>", "</pre>" }, 1, { "\nline" }, false },
+        { { "<pre>", "</pre>" }, 1, { "line" }, true },
+        /* values to be parsed */
+        { { "<p>", "</p>" }, 1, { "a &amp; b" }, false },
+        { { "<p>", "</p>" }, 1, { "<b>bold</b>" }, false },
+        { { "<a title=\"", "\">x</a>" }, 1, { "say \"hi\"" }, false },
+        { { "<a title=\"", "\">x</a>" }, 1, { "it's" }, false },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        struct fragment_case *c = cases + i;
+
+        size_t lens[4], val_lens[3];
+        std::string markup;
+        for (size_t j = 0; j <= c->nr_slots; j++) {
+            lens[j] = strlen(c->parts[j]);
+            markup += c->parts[j];
+            if (j < c->nr_slots) {
+                val_lens[j] = strlen(c->vals[j]);
+                markup += c->vals[j];
+            }
+        }
+
+        purc_document_t parsed = purc_document_new(PCDOC_K_TYPE_HTML);
+        purc_document_t built = purc_document_new(PCDOC_K_TYPE_HTML);
+        ASSERT_NE(parsed, nullptr);
+        ASSERT_NE(built, nullptr);
+
+        pcdoc_fragment_t frag = pcdoc_fragment_new(built,
+                purc_document_body(built), c->parts, lens, c->nr_slots);
+        ASSERT_NE(frag, nullptr) << markup;
+
+        /* insert twice, so the second one is made from the copy */
+        for (int n = 0; n < 2; n++) {
+            pcdoc_element_new_content(parsed, purc_document_body(parsed),
+                    PCDOC_OP_APPEND, markup.c_str(), markup.length());
+
+            pcdoc_node node = pcdoc_element_new_content_from_fragment(built,
+                    purc_document_body(built), PCDOC_OP_APPEND, frag,
+                    c->vals, val_lens);
+            ASSERT_EQ(node.type != PCDOC_NODE_VOID, c->fits) << markup;
+            if (node.type == PCDOC_NODE_VOID)
+                pcdoc_element_new_content(built, purc_document_body(built),
+                        PCDOC_OP_APPEND, markup.c_str(), markup.length());
+        }
+
+        ASSERT_EQ(serialize_body(built), serialize_body(parsed)) << markup;
+
+        pcdoc_fragment_delete(built, frag);
+        purc_document_delete(built);
+        purc_document_delete(parsed);
+    }
+}
+
+TEST(document, fragment_not_supported)
+{
+    purc_document_t doc = purc_document_new(PCDOC_K_TYPE_HTML);
+    ASSERT_NE(doc, nullptr);
+    pcdoc_element_t body = purc_document_body(doc);
+
+    /* a character reference not ended before a slot */
+    const char *open_ref[] = { "<p>&", "</p>" };
+    size_t lens[] = { strlen(open_ref[0]), strlen(open_ref[1]) };
+    purc_clr_error();
+    ASSERT_EQ(pcdoc_fragment_new(doc, body, open_ref, lens, 1), nullptr);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NOT_SUPPORTED);
+
+    const char *in_attr[] = { "<a title=\"&amp", "\">x</a>" };
+    lens[0] = strlen(in_attr[0]);
+    lens[1] = strlen(in_attr[1]);
+    ASSERT_EQ(pcdoc_fragment_new(doc, body, in_attr, lens, 1), nullptr);
+
+    /* a fragment is inserted only in the kind of element it is made for */
+    const char *item[] = { "<li>", "</li>" };
+    lens[0] = strlen(item[0]);
+    lens[1] = strlen(item[1]);
+    pcdoc_fragment_t frag = pcdoc_fragment_new(doc, body, item, lens, 1);
+    ASSERT_NE(frag, nullptr);
+
+    pcdoc_node list = pcdoc_element_new_content(doc, body, PCDOC_OP_APPEND,
+            "<ul></ul>", 0);
+    ASSERT_NE(list.elem, nullptr);
+
+    const char *vals[] = { "one" };
+    size_t val_lens[] = { 3 };
+    pcdoc_node node = pcdoc_element_new_content_from_fragment(doc, list.elem,
+            PCDOC_OP_APPEND, frag, vals, val_lens);
+    ASSERT_EQ(node.type, PCDOC_NODE_VOID);
+
+    node = pcdoc_element_new_content_from_fragment(doc, body,
+            PCDOC_OP_APPEND, frag, vals, val_lens);
+    ASSERT_NE(node.type, PCDOC_NODE_VOID);
+
+    pcdoc_fragment_delete(doc, frag);
+    purc_document_delete(doc);
+}
@@ -2033,3 +2033,389 @@ TEST(dvobjs, dvobjs_string_substr)
     purc_cleanup ();
 }
 
+
+TEST(dvobjs, dvobjs_string_replace_perf)
+{
+    PurCInstance purc;
+
+    purc_variant_t string = purc_dvobj_string_new();
+    ASSERT_NE(string, nullptr);
+
+    purc_variant_t dynamic = purc_variant_object_get_by_ckey (string,
+            "replace");
+    ASSERT_NE(dynamic, nullptr);
+    purc_dvariant_method func = purc_variant_dynamic_get_getter (dynamic);
+    ASSERT_NE(func, nullptr);
+
+    bool perf = test_perf_enabled();
+
+    // a 10 MB text with 50 different keys scattered in
+    const size_t nr_patterns = 50;
+    const size_t sz_text = perf ? 10 * 1024 * 1024 : 64 * 1024;
+    char *text = (char *)malloc(sz_text + 1);
+    ASSERT_NE(text, nullptr);
+
+    srand(1);
+    for (size_t i = 0; i < sz_text; ) {
+        if (rand() % 64 == 0 && i + 5 <= sz_text) {
+            i += sprintf(text + i, "key%02d", rand() % (int)nr_patterns);
+        }
+        else {
+            text[i++] = 'a' + rand() % 26;
+        }
+    }
+    text[sz_text] = 0;
+
+    purc_variant_t patterns = purc_variant_make_array (0,
+            PURC_VARIANT_INVALID);
+    purc_variant_t replaces = purc_variant_make_array (0,
+            PURC_VARIANT_INVALID);
+    for (size_t i = 0; i < nr_patterns; i++) {
+        char buf[16];
+        purc_variant_t v;
+
+        sprintf(buf, "key%02d", (int)i);
+        v = purc_variant_make_string (buf, false);
+        purc_variant_array_append (patterns, v);
+        purc_variant_unref (v);
+
+        sprintf(buf, "<%02d>", (int)i);
+        v = purc_variant_make_string (buf, false);
+        purc_variant_array_append (replaces, v);
+        purc_variant_unref (v);
+    }
+
+    purc_variant_t param[3];
+    param[0] = purc_variant_make_string_reuse_buff (text, sz_text + 1, false);
+    param[1] = patterns;
+    param[2] = replaces;
+
+    // replace all keys in one pass
+    struct timespec ts0, ts1;
+    clock_gettime(CLOCK_MONOTONIC, &ts0);
+    purc_variant_t one_pass = func (NULL, 3, param, false);
+    clock_gettime(CLOCK_MONOTONIC, &ts1);
+    ASSERT_NE(one_pass, nullptr);
+
+    // replace the keys one by one
+    purc_variant_t chained = purc_variant_ref (param[0]);
+    for (size_t i = 0; i < nr_patterns; i++) {
+        purc_variant_t args[3];
+        args[0] = chained;
+        args[1] = purc_variant_array_get (patterns, i);
+        args[2] = purc_variant_array_get (replaces, i);
+
+        purc_variant_t v = func (NULL, 3, args, false);
+        ASSERT_NE(v, nullptr);
+        purc_variant_unref (chained);
+        chained = v;
+    }
+
+    if (perf)
+        std::cerr << "replacing " << nr_patterns << " patterns in "
+            << sz_text << " bytes: one pass "
+            << purc_get_elapsed_milliseconds(&ts0, &ts1) << " ms, chained "
+            << purc_get_elapsed_milliseconds(&ts1, NULL) << " ms" << std::endl;
+
+    ASSERT_STREQ (purc_variant_get_string_const (one_pass),
+            purc_variant_get_string_const (chained));
+
+    purc_variant_unref (one_pass);
+    purc_variant_unref (chained);
+    purc_variant_unref (param[0]);
+    purc_variant_unref (patterns);
+    purc_variant_unref (replaces);
+    purc_variant_unref (string);
+}
+
+TEST(dvobjs, dvobjs_string_shared)
+{
+    PurCInstance purc;
+
+    purc_variant_t string = purc_dvobj_string_new();
+    ASSERT_NE(string, nullptr);
+
+    purc_variant_t dynamic = purc_variant_object_get_by_ckey (string,
+            "explode");
+    purc_dvariant_method explode = purc_variant_dynamic_get_getter (dynamic);
+    dynamic = purc_variant_object_get_by_ckey (string, "substr");
+    purc_dvariant_method substr = purc_variant_dynamic_get_getter (dynamic);
+
+    const char *fields[] = {
+        "a short one",
+        "a long field which will share the buffer",
+        "",
+        "中文字符串，也足够长了",
+    };
+
+    std::string text;
+    for (size_t i = 0; i < PCA_TABLESIZE(fields); i++) {
+        if (i > 0)
+            text += "\t";
+        text += fields[i];
+    }
+
+    purc_variant_t param[3];
+    param[0] = purc_variant_make_string (text.c_str(), false);
+    param[1] = purc_variant_make_string ("\t", false);
+
+    purc_variant_t result = explode (NULL, 2, param, false);
+    ASSERT_NE(result, nullptr);
+
+    // the pieces stay valid after the source was released
+    purc_variant_unref (param[0]);
+    purc_variant_unref (param[1]);
+
+    ASSERT_EQ(purc_variant_array_get_size (result), PCA_TABLESIZE(fields));
+    for (size_t i = 0; i < PCA_TABLESIZE(fields); i++) {
+        purc_variant_t v = purc_variant_array_get (result, i);
+        size_t len, nr_chars;
+        const char *s = purc_variant_get_string_const_ex (v, &len);
+        ASSERT_STREQ (s, fields[i]);
+        ASSERT_EQ(len, strlen(fields[i]));
+
+        purc_variant_string_chars (v, &nr_chars);
+        ASSERT_EQ(nr_chars, pcutils_string_utf8_chars(fields[i], -1));
+    }
+    ASSERT_TRUE(purc_variant_array_get (result, 1)->flags &
+            PCVRNT_FLAG_STRING_SHARED);
+    ASSERT_FALSE(purc_variant_array_get (result, 0)->flags &
+            PCVRNT_FLAG_STRING_SHARED);
+
+    // substr on a shared string gives the tail sharing the same owner
+    param[0] = purc_variant_array_get (result, 1);
+    param[1] = purc_variant_make_longint (2);
+    purc_variant_t tail = substr (NULL, 2, param, false);
+    purc_variant_unref (param[1]);
+    ASSERT_NE(tail, nullptr);
+    ASSERT_STREQ(purc_variant_get_string_const (tail), fields[1] + 2);
+    ASSERT_TRUE(tail->flags & PCVRNT_FLAG_STRING_SHARED);
+    ASSERT_EQ(tail->extra_data, param[0]->extra_data);
+
+    purc_variant_unref (result);
+    ASSERT_STREQ(purc_variant_get_string_const (tail), fields[1] + 2);
+
+    ASSERT_TRUE(pcvariant_string_unshare (tail));
+    ASSERT_FALSE(tail->flags & PCVRNT_FLAG_STRING_SHARED);
+    ASSERT_STREQ(purc_variant_get_string_const (tail), fields[1] + 2);
+    purc_variant_unref (tail);
+
+    purc_variant_unref (string);
+}
+
+TEST(dvobjs, dvobjs_string_shared_key_move)
+{
+    PurCInstance purc;
+
+    purc_variant_t string = purc_dvobj_string_new();
+    ASSERT_NE(string, nullptr);
+
+    purc_variant_t dynamic = purc_variant_object_get_by_ckey (string,
+            "substr");
+    purc_dvariant_method substr = purc_variant_dynamic_get_getter (dynamic);
+
+    const char *text = "0123: a long key which will share the buffer";
+
+    // the first round moves the object itself, the second one a clone
+    for (int i = 0; i < 2; i++) {
+        purc_variant_t param[2];
+        param[0] = purc_variant_make_string (text, false);
+        param[1] = purc_variant_make_longint (6);
+        purc_variant_t key = substr (NULL, 2, param, false);
+        purc_variant_unref (param[0]);
+        purc_variant_unref (param[1]);
+        ASSERT_NE(key, nullptr);
+        ASSERT_TRUE(key->flags & PCVRNT_FLAG_STRING_SHARED);
+
+        purc_variant_t inner = purc_variant_make_object_0 ();
+        purc_variant_t obj = purc_variant_make_object_0 ();
+        ASSERT_TRUE(purc_variant_object_set (obj, key, inner));
+        purc_variant_unref (inner);
+
+        purc_variant_t holder = PURC_VARIANT_INVALID;
+        if (i == 1)
+            holder = purc_variant_ref (obj);
+
+        purc_variant_t moved = pcvariant_move_heap_in (obj);
+        ASSERT_NE(moved, nullptr);
+        ASSERT_FALSE(key->flags & PCVRNT_FLAG_STRING_SHARED);
+        ASSERT_STREQ(purc_variant_get_string_const (key), text + 6);
+
+        moved = pcvariant_move_heap_out (moved);
+        ASSERT_NE(moved, nullptr);
+        ASSERT_NE(purc_variant_object_get_by_ckey (moved, text + 6), nullptr);
+        purc_variant_unref (moved);
+
+        if (holder)
+            purc_variant_unref (holder);
+        purc_variant_unref (key);
+    }
+
+    purc_variant_unref (string);
+}
+
+TEST(dvobjs, dvobjs_string_explode_perf)
+{
+    PurCInstance purc;
+
+    purc_variant_t string = purc_dvobj_string_new();
+    ASSERT_NE(string, nullptr);
+
+    purc_variant_t dynamic = purc_variant_object_get_by_ckey (string,
+            "explode");
+    purc_dvariant_method func = purc_variant_dynamic_get_getter (dynamic);
+    ASSERT_NE(func, nullptr);
+
+    bool perf = test_perf_enabled();
+
+    // 1M short fields and 100K long fields
+    const size_t nr_fields = perf ? 1000000 : 10000;
+    std::string text;
+    text.reserve(nr_fields * 10);
+    for (size_t i = 0; i < nr_fields; i++) {
+        char buf[64];
+        if (i % 10 == 0)
+            snprintf(buf, sizeof(buf), "a long field number %08u,", (unsigned)i);
+        else
+            snprintf(buf, sizeof(buf), "%u,", (unsigned)i);
+        text += buf;
+    }
+
+    purc_variant_t param[2];
+    param[0] = purc_variant_make_string (text.c_str(), false);
+    param[1] = purc_variant_make_string (",", false);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_variant_t result = func (NULL, 2, param, false);
+    ASSERT_NE(result, nullptr);
+    if (perf)
+        std::cerr << "exploding " << text.size() << " bytes into "
+            << nr_fields << " fields: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    ASSERT_EQ(purc_variant_array_get_size (result), nr_fields);
+    ASSERT_STREQ(purc_variant_get_string_const (
+                purc_variant_array_get (result, 10)),
+            "a long field number 00000010");
+
+    purc_variant_unref (result);
+    purc_variant_unref (param[0]);
+    purc_variant_unref (param[1]);
+    purc_variant_unref (string);
+}
+
+TEST(dvobjs, dvobjs_string_format_perf)
+{
+    PurCInstance purc;
+
+    purc_variant_t string = purc_dvobj_string_new();
+    ASSERT_NE(string, nullptr);
+
+    purc_variant_t dynamic = purc_variant_object_get_by_ckey (string,
+            "format_c");
+    ASSERT_NE(dynamic, nullptr);
+    purc_dvariant_method format_c = purc_variant_dynamic_get_getter (dynamic);
+    ASSERT_NE(format_c, nullptr);
+
+    dynamic = purc_variant_object_get_by_ckey (string, "format_p");
+    ASSERT_NE(dynamic, nullptr);
+    purc_dvariant_method format_p = purc_variant_dynamic_get_getter (dynamic);
+    ASSERT_NE(format_p, nullptr);
+
+    bool perf = test_perf_enabled();
+
+    // 1M rows: [id, name, score]
+    const size_t nr_rows = perf ? 1000000 : 10000;
+    purc_variant_t rows = purc_variant_make_array (0, PURC_VARIANT_INVALID);
+    for (size_t i = 0; i < nr_rows; i++) {
+        char name[32];
+        sprintf(name, "user%u", (unsigned)i);
+
+        purc_variant_t row = purc_variant_make_array (0,
+                PURC_VARIANT_INVALID);
+        purc_variant_t v = purc_variant_make_longint ((int64_t)i);
+        purc_variant_array_append (row, v);
+        purc_variant_unref (v);
+        v = purc_variant_make_string (name, false);
+        purc_variant_array_append (row, v);
+        purc_variant_unref (v);
+        v = purc_variant_make_number (i / 8.0);
+        purc_variant_array_append (row, v);
+        purc_variant_unref (v);
+
+        purc_variant_array_append (rows, row);
+        purc_variant_unref (row);
+    }
+
+    purc_variant_t param[3];
+    param[0] = purc_variant_make_string ("%d: %s scored %f", false);
+
+    // format the rows one call per row
+    struct timespec ts0, ts1;
+    clock_gettime(CLOCK_MONOTONIC, &ts0);
+    purc_variant_t one_by_one = purc_variant_make_array (0,
+            PURC_VARIANT_INVALID);
+    for (size_t i = 0; i < nr_rows; i++) {
+        purc_variant_t row = purc_variant_array_get (rows, i);
+        param[1] = purc_variant_array_get (row, 0);
+        param[2] = purc_variant_array_get (row, 1);
+        purc_variant_t args[4] = { param[0], param[1], param[2],
+            purc_variant_array_get (row, 2) };
+
+        purc_variant_t v = format_c (NULL, 4, args, false);
+        ASSERT_NE(v, nullptr);
+        purc_variant_array_append (one_by_one, v);
+        purc_variant_unref (v);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ts1);
+
+    // format all rows in one call
+    param[1] = rows;
+    param[2] = purc_variant_make_boolean (true);
+    purc_variant_t batch = format_c (NULL, 3, param, false);
+    purc_variant_unref (param[2]);
+    ASSERT_NE(batch, nullptr);
+
+    if (perf)
+        std::cerr << "formatting " << nr_rows << " rows: one by one "
+            << purc_get_elapsed_milliseconds(&ts0, &ts1) << " ms, batch "
+            << purc_get_elapsed_milliseconds(&ts1, NULL) << " ms" << std::endl;
+
+    ASSERT_EQ (purc_variant_array_get_size (batch), nr_rows);
+    for (size_t i = 0; i < nr_rows; i += 9973) {
+        ASSERT_STREQ (
+                purc_variant_get_string_const (
+                    purc_variant_array_get (batch, i)),
+                purc_variant_get_string_const (
+                    purc_variant_array_get (one_by_one, i)));
+    }
+    ASSERT_STREQ (purc_variant_get_string_const (
+                purc_variant_array_get (batch, 8)),
+            "8: user8 scored 1.000000");
+    purc_variant_unref (param[0]);
+    purc_variant_unref (batch);
+    purc_variant_unref (one_by_one);
+
+    // format_p with rows
+    param[0] = purc_variant_make_string ("{1} is #{0}", false);
+    param[1] = rows;
+    param[2] = purc_variant_make_boolean (true);
+    clock_gettime(CLOCK_MONOTONIC, &ts0);
+    batch = format_p (NULL, 3, param, false);
+    ASSERT_NE(batch, nullptr);
+    if (perf)
+        std::cerr << "formatting " << nr_rows << " rows with format_p: "
+            << purc_get_elapsed_milliseconds(&ts0, NULL) << " ms" << std::endl;
+
+    ASSERT_EQ (purc_variant_array_get_size (batch), nr_rows);
+    ASSERT_STREQ (purc_variant_get_string_const (
+                purc_variant_array_get (batch, 12)),
+            "user12 is #12");
+
+    purc_variant_unref (param[0]);
+    purc_variant_unref (param[2]);
+    purc_variant_unref (batch);
+    purc_variant_unref (rows);
+    purc_variant_unref (string);
+}
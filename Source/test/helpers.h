@@ -70,6 +70,11 @@ do {                                                                    \
     _v;                                                                 \
 })
 
+// the performance tests use their full sizes and report the timings
+// only if PURC_TEST_PERF is set
+#define test_perf_enabled()                                             \
+    test_getbool_from_env_or_default("PURC_TEST_PERF", false)
+
 #else
 
 #error "Please define test_getpath_from_env_or_rel for this operating system"
@@ -21,6 +21,7 @@
 #include "purc/purc.h"
 #include "private/utils.h"
 #include "private/debug.h"
+#include "private/interpreter.h"
 #include "../helpers.h"
 
 #include <gtest/gtest.h>
@@ -639,3 +640,138 @@ TEST(interpreter, basic)
     purc_run(NULL);
 }
 
+
+static size_t nr_large_page_paras;
+static uint64_t large_page_dom_handle;
+
+static int large_page_cond_handler(purc_cond_k event, void *arg, void *data)
+{
+    if (event == PURC_COND_COR_EXITED) {
+        purc_coroutine_t co = (purc_coroutine_t)arg;
+        struct purc_cor_exit_info *info = (struct purc_cor_exit_info *)data;
+
+        // the handle returned by the renderer for the last chunk (writeEnd)
+        large_page_dom_handle = co->target_dom_handle;
+
+        pcdoc_element_t body = purc_document_body(info->doc);
+        if (body)
+            pcdoc_element_children_count(info->doc, body,
+                    &nr_large_page_paras, NULL, NULL);
+    }
+    return 0;
+}
+
+TEST(interpreter, load_large_page)
+{
+    unsigned int modules = (PURC_MODULE_HVML | PURC_MODULE_PCRDR) & ~PURC_HAVE_FETCHER;
+
+    struct purc_instance_extra_info info = { };
+    info.renderer_comm = PURC_RDRCOMM_HEADLESS;
+    info.workspace_name = "main";
+
+    PurCInstance purc(modules, "cn.fmsoft.hybridos.test", "test_attach_rdr",
+            &info);
+    ASSERT_TRUE(purc);
+
+    // about 5 MB of static content; much larger than the first chunk
+    // even when not measuring, so that the page is always sent in pieces
+    bool perf = test_perf_enabled();
+    const size_t nr_paras = perf ? 50000 : 2000;
+    std::string hvml = "<!DOCTYPE hvml><hvml target=\"html\"><body>";
+    std::string line(96, 'x');
+    for (size_t i = 0; i < nr_paras; i++) {
+        hvml += "<p>";
+        hvml += line;
+        hvml += "</p>";
+    }
+    hvml += "</body></hvml>";
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml.c_str());
+    ASSERT_NE(vdom, nullptr);
+
+    purc_renderer_extra_info extra_info = {};
+    extra_info.title = "large_page";
+    purc_coroutine_t co = purc_schedule_vdom(vdom,
+            0, PURC_VARIANT_INVALID, PCRDR_PAGE_TYPE_PLAINWIN,
+            "main",         /* target_workspace */
+            NULL,           /* target_group */
+            "large_page",   /* page_name */
+            &extra_info, NULL, NULL);
+    ASSERT_NE(co, nullptr);
+
+    nr_large_page_paras = 0;
+    large_page_dom_handle = 0;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_run(large_page_cond_handler);
+    if (perf)
+        std::cerr << "loading a page of " << hvml.size() << " bytes: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    ASSERT_EQ(nr_large_page_paras, nr_paras);
+    ASSERT_NE(large_page_dom_handle, (uint64_t)0);
+}
+
+static const char *render_table =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"html\">"
+    "    <head>"
+    "        <update on=\"$TIMERS\" to=\"unite\">"
+    "            [ { \"id\" : \"render\", \"interval\" : 10, \"active\" : \"yes\" } ]"
+    "        </update>"
+    "    </head>"
+    "    <body>"
+    "        <table id=\"rows\">"
+    "            <archetype name=\"row\">"
+    "                <tr><td>$?</td><td>row $?</td></tr>"
+    "            </archetype>"
+    "        </table>"
+    ""
+    "        <observe on=\"$TIMERS\" for=\"expired:render\">"
+    "            <update on=\"$TIMERS\" to=\"subtract\" with=\"[{ id : 'render' }]\" />"
+    "            <iterate on 0 onlyif $L.lt($0<, %d) with $DATA.arith('+', $0<, 1) nosetotail>"
+    "                <update on=\"#rows\" to=\"append\" with=\"$row\" />"
+    "            </iterate>"
+    "            <exit with true />"
+    "        </observe>"
+    "    </body>"
+    "</hvml>";
+
+TEST(interpreter, render_large_table)
+{
+    unsigned int modules = (PURC_MODULE_HVML | PURC_MODULE_PCRDR) & ~PURC_HAVE_FETCHER;
+
+    struct purc_instance_extra_info info = { };
+    info.renderer_comm = PURC_RDRCOMM_HEADLESS;
+    info.workspace_name = "main";
+
+    PurCInstance purc(modules, "cn.fmsoft.hybridos.test", "test_attach_rdr",
+            &info);
+    ASSERT_TRUE(purc);
+
+    bool perf = test_perf_enabled();
+    int nr_rows = perf ? 10000 : 500;
+
+    char hvml[2048];
+    snprintf(hvml, sizeof(hvml), render_table, nr_rows);
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml);
+    ASSERT_NE(vdom, nullptr);
+
+    purc_renderer_extra_info extra_info = {};
+    extra_info.title = "large_table";
+    purc_coroutine_t co = purc_schedule_vdom(vdom,
+            0, PURC_VARIANT_INVALID, PCRDR_PAGE_TYPE_PLAINWIN,
+            "main",         /* target_workspace */
+            NULL,           /* target_group */
+            "large_table",  /* page_name */
+            &extra_info, NULL, NULL);
+    ASSERT_NE(co, nullptr);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_run(NULL);
+    if (perf)
+        std::cerr << "rendering a table of " << nr_rows << " rows: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+}
@@ -895,3 +895,314 @@ TEST(interpreter, basic)
     purc_run(NULL);
 }
 
+static const char *loop_with_three_children =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"void\">"
+    "    <body id=\"theBody\">"
+    "        <init as=\"c\" with -1L temporarily />"
+    "        <iterate on 0 onlyif $L.lt($0<, %d) with $DATA.arith('+', $0<, 1) nosetotail>"
+    "            <init as=\"a\" with $? temporarily />"
+    "            <init as=\"b\" with $a temporarily />"
+    "            <init as=\"c\" at=\"#theBody\" with $b temporarily />"
+    "        </iterate>"
+    "        <exit with $c />"
+    "    </body>"
+    "</hvml>";
+
+static int64_t loop_result;
+
+static int loop_cond_handler(purc_cond_k event, void *arg, void *data)
+{
+    (void)arg;
+
+    if (event == PURC_COND_COR_EXITED) {
+        struct purc_cor_exit_info *info = (struct purc_cor_exit_info *)data;
+        if (info->result)
+            purc_variant_cast_to_longint(info->result, &loop_result, false);
+    }
+    return 0;
+}
+
+TEST(interpreter, stack_frames_perf)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "interpreter", false);
+
+    ASSERT_TRUE(purc);
+
+    bool perf = test_perf_enabled();
+    int nr_iterations = perf ? 1000000 : 1000;
+
+    char hvml[1024];
+    snprintf(hvml, sizeof(hvml), loop_with_three_children, nr_iterations);
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml);
+    ASSERT_NE(vdom, nullptr);
+    purc_schedule_vdom_null(vdom);
+
+    loop_result = -1;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_run(loop_cond_handler);
+    if (perf)
+        std::cerr << "running " << nr_iterations
+            << " iterations with three children: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    // the frames reused by the iterations still see the latest values
+    ASSERT_EQ(loop_result, nr_iterations - 1);
+}
+
+static const char *loop_with_update_and_test =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"void\">"
+    "    <init as=\"obj\" with { \"count\": 0, \"found\": false } />"
+    "    <iterate on 0 onlyif $L.lt($0<, %d) with $DATA.arith('+', $0<, 1) nosetotail>"
+    "        <update on $obj at \".count\" with $? />"
+    "        <test with $L.eq($?, 500) >"
+    "            <update on $obj at \".found\" with true />"
+    "        </test>"
+    "    </iterate>"
+    "</hvml>";
+
+TEST(interpreter, update_test_loop_perf)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "interpreter", false);
+
+    ASSERT_TRUE(purc);
+
+    bool perf = test_perf_enabled();
+    int nr_iterations = perf ? 100000 : 1000;
+
+    char hvml[1024];
+    snprintf(hvml, sizeof(hvml), loop_with_update_and_test, nr_iterations);
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml);
+    ASSERT_NE(vdom, nullptr);
+    purc_schedule_vdom_null(vdom);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_run(NULL);
+    if (perf)
+        std::cerr << "running " << nr_iterations
+            << " iterations with update and test: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+}
+
+static const char *loop_with_archetype =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"html\">"
+    "    <body>"
+    "        <archetype name=\"row\">"
+    "            <li class=\"item item-$?\" title=\"Item $?\">"
+    "                <span class=\"label\">Item</span>"
+    "                <em>No. $?</em>"
+    "                <a href=\"#item-$?\">details</a>"
+    "            </li>"
+    "        </archetype>"
+    "        <ul>"
+    "            <iterate on 0 onlyif $L.lt($0<, %d) with $DATA.arith('+', $0<, 1) nosetotail>"
+    "                <update on=\"$@\" to=\"append\" with=\"$row\" />"
+    "            </iterate>"
+    "        </ul>"
+    "    </body>"
+    "</hvml>";
+
+TEST(interpreter, archetype_expansion_perf)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "interpreter", false);
+
+    ASSERT_TRUE(purc);
+
+    bool perf = test_perf_enabled();
+    int nr_expansions = perf ? 100000 : 1000;
+
+    char hvml[2048];
+    snprintf(hvml, sizeof(hvml), loop_with_archetype, nr_expansions);
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml);
+    ASSERT_NE(vdom, nullptr);
+    purc_schedule_vdom_null(vdom);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_run(NULL);
+    if (perf)
+        std::cerr << "expanding an archetype " << nr_expansions << " times: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+}
+
+#define NR_CPU_BOUND_TASKS      8
+
+static const char *cpu_bound_tasks =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"void\">"
+    "    <define as \"aCpuBoundTask\">"
+    "        <iterate on 0 onlyif $L.lt($0<, %d) with $DATA.arith('+', $0<, 1) nosetotail />"
+    "        <return with true />"
+    "    </define>"
+    "    <init as \"results\" with [] />"
+    "    <iterate on 0 onlyif $L.lt($0<, %d) with $DATA.arith('+', $0<, 1) nosetotail>"
+    "        <call on $aCpuBoundTask as \"task\" within \"%s\" concurrently asynchronously />"
+    "        <observe on $task for \"callState:success\">"
+    "            <update on $results to \"append\" with $? />"
+    "            <test with $L.ge($DATA.count($results), %d) >"
+    "                <exit with $results />"
+    "            </test>"
+    "        </observe>"
+    "    </iterate>"
+    "</hvml>";
+
+static size_t nr_cpu_bound_results;
+
+static int cpu_bound_cond_handler(purc_cond_k event, void *arg, void *data)
+{
+    (void)arg;
+
+    if (event == PURC_COND_COR_EXITED) {
+        /* only the main coroutine exits with the array of the results */
+        struct purc_cor_exit_info *info = (struct purc_cor_exit_info *)data;
+        if (info->result && purc_variant_is_array(info->result))
+            purc_variant_array_size(info->result, &nr_cpu_bound_results);
+    }
+    return 0;
+}
+
+static double run_cpu_bound_tasks(const char *runner, int nr_iterations)
+{
+    char hvml[2048];
+    snprintf(hvml, sizeof(hvml), cpu_bound_tasks, nr_iterations,
+            NR_CPU_BOUND_TASKS, runner, NR_CPU_BOUND_TASKS);
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml);
+    if (vdom == NULL)
+        return -1;
+    purc_schedule_vdom_null(vdom);
+
+    nr_cpu_bound_results = 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_run(cpu_bound_cond_handler);
+    return purc_get_elapsed_milliseconds(&ts, NULL);
+}
+
+TEST(interpreter, isolated_coroutines_perf)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "interpreter", false);
+
+    ASSERT_TRUE(purc);
+
+    bool perf = test_perf_enabled();
+    int nr_iterations = perf ? 200000 : 1000;
+
+    double serial = run_cpu_bound_tasks("_self", nr_iterations);
+    ASSERT_GE(serial, 0);
+    ASSERT_EQ(nr_cpu_bound_results, (size_t)NR_CPU_BOUND_TASKS);
+
+    double parallel = run_cpu_bound_tasks("_isolated", nr_iterations);
+    ASSERT_GE(parallel, 0);
+    ASSERT_EQ(nr_cpu_bound_results, (size_t)NR_CPU_BOUND_TASKS);
+
+    if (perf)
+        std::cerr << "running " << NR_CPU_BOUND_TASKS
+            << " CPU-bound coroutines within _self: " << serial << " ms; "
+            << "within _isolated: " << parallel << " ms" << std::endl;
+
+    /* purc_run() asked the isolated runners to shut down */
+    long nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (long i = 0; i < nr_cpus && i < NR_CPU_BOUND_TASKS; i++) {
+        char runner_name[PURC_LEN_RUNNER_NAME + 1];
+        char endpoint_name[PURC_LEN_ENDPOINT_NAME + 1];
+        snprintf(runner_name, sizeof(runner_name), "_isolated_%ld", i);
+        purc_assemble_endpoint_name(PCRDR_LOCALHOST,
+                "cn.fmsoft.hybridos.test", runner_name, endpoint_name);
+
+        unsigned int seconds = 0;
+        while (purc_atom_try_string_ex(PURC_ATOM_BUCKET_DEF, endpoint_name)) {
+            sleep(1);
+            seconds++;
+            ASSERT_LT(seconds, 10);
+        }
+    }
+}
+
+/* enough items to take many time slices (5 ms) even on a fast machine */
+#define NR_BIG_ARRAY_ITEMS      8192
+
+static purc_coroutine_t big_array_cor;
+static purc_coroutine_t latency_probe;
+static struct timespec latency_begin;
+static double latency_ms;
+static uint64_t big_array_count;
+/* the order in which the coroutines exited, starting from 1 */
+static int nr_exited;
+static int probe_exit_order;
+static int big_array_exit_order;
+
+static int latency_cond_handler(purc_cond_k event, void *arg, void *data)
+{
+    if (event != PURC_COND_COR_EXITED)
+        return 0;
+
+    if (arg == latency_probe) {
+        latency_ms = purc_get_elapsed_milliseconds(&latency_begin, NULL);
+        probe_exit_order = ++nr_exited;
+    }
+    else if (arg == big_array_cor) {
+        big_array_exit_order = ++nr_exited;
+        struct purc_cor_exit_info *info = (struct purc_cor_exit_info *)data;
+        if (info->result)
+            purc_variant_cast_to_ulongint(info->result, &big_array_count,
+                    false);
+    }
+    return 0;
+}
+
+TEST(interpreter, preempt_big_array_evaluation)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "interpreter", false);
+
+    ASSERT_TRUE(purc);
+
+    std::string big_array =
+        "<!DOCTYPE hvml>"
+        "<hvml target=\"void\">"
+        "    <init as \"long\" with $STR.repeat('x', 131072) />"
+        "    <init as \"big\" with [";
+    for (int i = 0; i < NR_BIG_ARRAY_ITEMS; i++) {
+        big_array += "$STR.nr_chars($long),";
+    }
+    big_array += "0] />"
+        "    <exit with $DATA.count($big) />"
+        "</hvml>";
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(big_array.c_str());
+    ASSERT_NE(vdom, nullptr);
+    big_array_cor = purc_schedule_vdom_null(vdom);
+    ASSERT_NE(big_array_cor, nullptr);
+
+    vdom = purc_load_hvml_from_string(
+            "<hvml target=\"void\"><exit with true /></hvml>");
+    ASSERT_NE(vdom, nullptr);
+    latency_probe = purc_schedule_vdom_null(vdom);
+    ASSERT_NE(latency_probe, nullptr);
+
+    latency_ms = -1;
+    big_array_count = 0;
+    nr_exited = 0;
+    probe_exit_order = 0;
+    big_array_exit_order = 0;
+    clock_gettime(CLOCK_MONOTONIC, &latency_begin);
+    purc_run(latency_cond_handler);
+    double total_ms = purc_get_elapsed_milliseconds(&latency_begin, NULL);
+
+    // the evaluation was preempted and resumed, not abandoned
+    ASSERT_EQ(big_array_count, (uint64_t)NR_BIG_ARRAY_ITEMS + 1);
+
+    // the other coroutine did not wait for the whole evaluation
+    ASSERT_EQ(probe_exit_order, 1);
+    ASSERT_EQ(big_array_exit_order, 2);
+
+    if (test_perf_enabled())
+        std::cerr << "a ready coroutine waited " << latency_ms
+            << " ms while another one evaluated an array of "
+            << NR_BIG_ARRAY_ITEMS << " items in " << total_ms << " ms"
+            << std::endl;
+}
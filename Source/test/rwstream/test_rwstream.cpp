@@ -21,6 +21,7 @@
 
 #include "purc/purc-rwstream.h"
 #include "purc/purc-utils.h"
+#include "private/rwstream.h"
 #include "config.h"
 
 #include <stdio.h>
@@ -564,6 +565,45 @@ TEST(mem_rwstream, seek_read)
     ASSERT_EQ(ret, 0);
 }
 
+static void release_readonly_mem(void *ctxt)
+{
+    int *nr_released = (int *)ctxt;
+    (*nr_released)++;
+}
+
+TEST(mem_rwstream, readonly)
+{
+    const char buf[] = "This is test file. 这是测试文件。";
+    size_t buf_len = strlen(buf);
+    int nr_released = 0;
+
+    purc_rwstream_t rws = pcrwstream_new_from_readonly_mem (buf, buf_len,
+            release_readonly_mem, &nr_released);
+    ASSERT_NE(rws, nullptr);
+
+    size_t sz = 0;
+    const char* mem_buffer = (const char*)purc_rwstream_get_mem_buffer (rws,
+            &sz);
+    ASSERT_EQ(mem_buffer, buf);
+    ASSERT_EQ(sz, buf_len);
+
+    char read_buf[100] = {0};
+    ssize_t read_len = purc_rwstream_read (rws, read_buf, 4);
+    ASSERT_EQ(read_len, 4);
+    ASSERT_STREQ(read_buf, "This");
+
+    ssize_t write_len = purc_rwstream_write (rws, "that", 4);
+    ASSERT_EQ(write_len, -1);
+
+    off_t pos = purc_rwstream_seek (rws, 0, SEEK_END);
+    ASSERT_EQ(pos, (off_t)buf_len);
+
+    ASSERT_EQ(nr_released, 0);
+    int ret = purc_rwstream_destroy (rws);
+    ASSERT_EQ(ret, 0);
+    ASSERT_EQ(nr_released, 1);
+}
+
 /* test buffer rwstream */
 TEST(buffer_rwstream, new_destroy)
 {
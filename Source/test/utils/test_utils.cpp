@@ -28,6 +28,7 @@
 #include "private/atom-buckets.h"
 #include "private/sorted-array.h"
 #include "private/url.h"
+#include "private/dtoa.h"
 
 #include "../helpers.h"
 
@@ -35,6 +36,8 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <math.h>
+#include <pthread.h>
 #include <gtest/gtest.h>
 
 #define ATOM_BUCKET     1
@@ -354,6 +357,77 @@ TEST(utils, atom_buckets)
     purc_cleanup ();
 }
 
+#define NR_LOOKUP_THREADS       8
+static void *lookup_custom_atoms(void *arg)
+{
+    uintptr_t nr_wrong = 0;
+    size_t nr_rounds = (size_t)(uintptr_t)arg;
+
+    for (size_t i = 0; i < nr_rounds; i++) {
+        for (size_t n = 0; n < NR_CUSTOM_ATOMS; n++) {
+            purc_atom_t atom = purc_atom_try_string_ex(ATOM_BUCKET_CUSTOM,
+                    _except_names[n].str);
+            if (atom != _except_names[n].atom)
+                nr_wrong++;
+        }
+    }
+
+    return (void *)nr_wrong;
+}
+
+// to test looking up atoms in multiple threads
+TEST(utils, atom_lookup_threads)
+{
+    int ret = purc_init_ex(PURC_MODULE_UTILS, "cn.fmsoft.hybridos.test",
+            "utils", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    for (size_t n = 0; n < NR_CUSTOM_ATOMS; n++) {
+        _except_names[n].atom =
+            purc_atom_from_static_string_ex(ATOM_BUCKET_CUSTOM,
+                _except_names[n].str);
+        ASSERT_NE(_except_names[n].atom, 0);
+    }
+
+    bool perf = test_perf_enabled();
+    size_t nr_rounds = perf ? 100000 : 1000;
+
+    pthread_t threads[NR_LOOKUP_THREADS];
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (int i = 0; i < NR_LOOKUP_THREADS; i++) {
+        ASSERT_EQ(pthread_create(threads + i, NULL,
+                    lookup_custom_atoms, (void *)(uintptr_t)nr_rounds), 0);
+    }
+
+    for (int i = 0; i < NR_LOOKUP_THREADS; i++) {
+        void *nr_wrong;
+        pthread_join(threads[i], &nr_wrong);
+        ASSERT_EQ(nr_wrong, nullptr);
+    }
+
+    if (perf)
+        std::cerr << "looking up " << NR_CUSTOM_ATOMS << " atoms "
+            << nr_rounds << " times in " << NR_LOOKUP_THREADS
+            << " threads: " << purc_get_elapsed_milliseconds(&ts, NULL)
+            << " ms" << std::endl;
+
+    /* a removed atom must not be found in the cache any more */
+    purc_atom_t atom = purc_atom_from_string_ex(ATOM_BUCKET_CUSTOM,
+            "transientAtom");
+    ASSERT_NE(atom, 0);
+    ASSERT_EQ(purc_atom_try_string_ex(ATOM_BUCKET_CUSTOM, "transientAtom"),
+            atom);
+    ASSERT_TRUE(purc_atom_remove_string_ex(ATOM_BUCKET_CUSTOM,
+            "transientAtom"));
+    ASSERT_EQ(purc_atom_try_string_ex(ATOM_BUCKET_CUSTOM, "transientAtom"),
+            0);
+    ASSERT_NE(purc_atom_from_string_ex(ATOM_BUCKET_CUSTOM, "transientAtom"),
+            atom);
+
+    purc_cleanup ();
+}
+
 // to test sorted array
 static int sortv[10] = { 1, 8, 7, 5, 4, 6, 9, 0, 2, 3 };
 
@@ -2135,6 +2209,121 @@ TEST(utils, build_query_array)
     purc_cleanup();
 }
 
+TEST(utils, build_query_nested)
+{
+    purc_variant_t v;
+    purc_variant_t ret;
+    const char *buf;
+
+    int r = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "url_query", NULL);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    v = purc_variant_make_object(0, PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+
+    purc_variant_t v_1 = purc_variant_make_number(2);
+    purc_variant_array_append(arr, v_1);
+
+    purc_variant_t v_2 = purc_variant_make_string_static("x y", false);
+    purc_variant_array_append(arr, v_2);
+
+    purc_variant_t inner = purc_variant_make_object(0, PURC_VARIANT_INVALID,
+            PURC_VARIANT_INVALID);
+    purc_variant_object_set_by_static_ckey(inner, "k", v_2);
+    purc_variant_array_append(arr, inner);
+
+    purc_variant_object_set_by_static_ckey(v, "a", arr);
+
+    ret = pcutils_url_build_query(v, "pre_",
+                '&', PCUTILS_URL_OPT_REAL_JSON |  PCUTILS_URL_OPT_RFC1738);
+    ASSERT_NE(ret, nullptr);
+    buf = purc_variant_get_string_const(ret);
+    ASSERT_STREQ("a%5B0%5D=2&a%5B1%5D=x%20y&a%5B2%5D%5Bk%5D=x%20y", buf);
+
+    purc_variant_unref(inner);
+    purc_variant_unref(v_2);
+    purc_variant_unref(v_1);
+    purc_variant_unref(arr);
+    purc_variant_unref(ret);
+    purc_variant_unref(v);
+
+    purc_cleanup();
+}
+
+TEST(utils, url_encode_perf)
+{
+    int r = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+            "url_encode", NULL);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_variant_t url = purc_dvobj_url_new();
+    ASSERT_NE(url, nullptr);
+
+    purc_variant_t dynamic = purc_variant_object_get_by_ckey(url, "encode");
+    ASSERT_NE(dynamic, nullptr);
+    purc_dvariant_method encode = purc_variant_dynamic_get_getter(dynamic);
+    ASSERT_NE(encode, nullptr);
+
+    dynamic = purc_variant_object_get_by_ckey(url, "decode");
+    ASSERT_NE(dynamic, nullptr);
+    purc_dvariant_method decode = purc_variant_dynamic_get_getter(dynamic);
+    ASSERT_NE(decode, nullptr);
+
+    bool perf = test_perf_enabled();
+
+    // 100 MB of mixed text: mostly ASCII words with spaces, punctuation,
+    // and some Chinese characters
+    const size_t sz_text = perf ? 100 * 1024 * 1024 : 1024 * 1024;
+    char *text = (char *)malloc(sz_text + 1);
+    ASSERT_NE(text, nullptr);
+
+    srand(1);
+    for (size_t i = 0; i < sz_text; ) {
+        int n = rand() % 32;
+        if (n == 0 && i + 3 <= sz_text) {
+            memcpy(text + i, "\xe6\x98\xaf", 3);
+            i += 3;
+        }
+        else if (n < 4) {
+            text[i++] = " /:?&="[rand() % 6];
+        }
+        else {
+            text[i++] = 'a' + rand() % 26;
+        }
+    }
+    text[sz_text] = 0;
+
+    purc_variant_t str = purc_variant_make_string_reuse_buff(text,
+            sz_text + 1, false);
+    ASSERT_NE(str, nullptr);
+
+    struct timespec ts0, ts1;
+    clock_gettime(CLOCK_MONOTONIC, &ts0);
+    purc_variant_t encoded = encode(NULL, 1, &str, 0);
+    clock_gettime(CLOCK_MONOTONIC, &ts1);
+    ASSERT_NE(encoded, nullptr);
+
+    purc_variant_t decoded = decode(NULL, 1, &encoded, 0);
+    ASSERT_NE(decoded, nullptr);
+
+    if (perf)
+        std::cerr << "encoding " << sz_text << " bytes: "
+            << purc_get_elapsed_milliseconds(&ts0, &ts1) << " ms; decoding: "
+            << purc_get_elapsed_milliseconds(&ts1, NULL) << " ms" << std::endl;
+
+    ASSERT_EQ(purc_variant_string_size(decoded), sz_text + 1);
+    ASSERT_EQ(memcmp(purc_variant_get_string_const(decoded),
+                purc_variant_get_string_const(str), sz_text), 0);
+
+    purc_variant_unref(decoded);
+    purc_variant_unref(encoded);
+    purc_variant_unref(str);
+    purc_variant_unref(url);
+
+    purc_cleanup();
+}
+
 struct test_data {
     const char *ejson;
     const char *cmp;
@@ -2210,3 +2399,121 @@ TEST_P(test_build_query, build_query)
 
 INSTANTIATE_TEST_SUITE_P(build_query, test_build_query,
         testing::ValuesIn(test_cases));
+
+TEST(utils, dtoa)
+{
+    static const struct {
+        double d;
+        const char *str;
+    } cases[] = {
+        { 0.0, "0" },
+        { -0.0, "-0" },
+        { 0.1, "0.1" },
+        { -0.1, "-0.1" },
+        { 1.5e-5, "1.5e-05" },
+        { 0.0001, "0.0001" },
+        { 123.456, "123.456" },
+        { 1.0 / 3, "0.3333333333333333" },
+        { 1e16, "10000000000000000" },
+        { 1e17, "1e+17" },
+        { 5e-324, "5e-324" },
+        { 1.7976931348623157e308, "1.7976931348623157e+308" },
+        { INFINITY, "Infinity" },
+        { -INFINITY, "-Infinity" },
+        { NAN, "NaN" },
+    };
+
+    char buf[PCUTILS_DTOA_BUFSZ];
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        size_t len = pcutils_dtoa(cases[i].d, buf);
+        ASSERT_EQ(len, strlen(cases[i].str));
+        ASSERT_STREQ(buf, cases[i].str);
+    }
+
+    pcutils_i64toa(INT64_MIN, buf);
+    ASSERT_STREQ(buf, "-9223372036854775808");
+    pcutils_u64toa(UINT64_MAX, buf);
+    ASSERT_STREQ(buf, "18446744073709551615");
+
+    static const char *numbers[] = {
+        "0", "-0", "  +12.5e", "1.", ".5x", "1e+", "0x1p3", "inf", "-nan",
+        "123456789012345678901234567890", "9007199254740993",
+        "1.7976931348623159e308", "2.2250738585072011e-308",
+        "2.4703282292062328e-324", "1e-400", "00001.00000e0001",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(numbers); i++) {
+        char *end1, *end2;
+        double d1 = pcutils_strtod(numbers[i], &end1);
+        double d2 = strtod(numbers[i], &end2);
+        if (isnan(d2))
+            ASSERT_TRUE(isnan(d1));
+        else
+            ASSERT_EQ(memcmp(&d1, &d2, sizeof(double)), 0) << numbers[i];
+        ASSERT_EQ(end1, end2) << numbers[i];
+    }
+}
+
+TEST(utils, dtoa_perf)
+{
+    bool perf = test_perf_enabled();
+    const size_t nr_doubles = perf ? 10000000 : 100000;
+
+    double *doubles = (double *)malloc(sizeof(double) * nr_doubles);
+    char *text = (char *)malloc(PCUTILS_DTOA_BUFSZ * nr_doubles);
+    ASSERT_NE(doubles, nullptr);
+    ASSERT_NE(text, nullptr);
+
+    uint64_t seed = 88172645463325252ULL;
+    for (size_t i = 0; i < nr_doubles; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        doubles[i] = ldexp((double)(seed >> 11), (int)(seed % 128) - 96);
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t i = 0; i < nr_doubles; i++) {
+        pcutils_dtoa(doubles[i], text + i * PCUTILS_DTOA_BUFSZ);
+    }
+    if (perf)
+        std::cerr << "formatting " << nr_doubles << " doubles: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    size_t nr_mismatched = 0;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t i = 0; i < nr_doubles; i++) {
+        double d = pcutils_strtod(text + i * PCUTILS_DTOA_BUFSZ, NULL);
+        if (d != doubles[i])
+            nr_mismatched++;
+    }
+    if (perf)
+        std::cerr << "parsing " << nr_doubles << " doubles: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+    ASSERT_EQ(nr_mismatched, 0);
+
+    // the C library as the reference
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t i = 0; i < nr_doubles; i++) {
+        snprintf(text + i * PCUTILS_DTOA_BUFSZ, PCUTILS_DTOA_BUFSZ,
+                "%.17g", doubles[i]);
+    }
+    if (perf)
+        std::cerr << "formatting " << nr_doubles << " doubles with snprintf(): "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t i = 0; i < nr_doubles; i++) {
+        double d = strtod(text + i * PCUTILS_DTOA_BUFSZ, NULL);
+        if (d != doubles[i])
+            nr_mismatched++;
+    }
+    if (perf)
+        std::cerr << "parsing " << nr_doubles << " doubles with strtod(): "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+    ASSERT_EQ(nr_mismatched, 0);
+
+    free(text);
+    free(doubles);
+}
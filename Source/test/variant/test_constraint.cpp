@@ -1132,3 +1132,81 @@ TEST(constraint, set_change)
     map_destroy();
 }
 
+
+TEST(constraint, set_update_members_perf)
+{
+    PurCInstance purc;
+
+    bool perf = test_perf_enabled();
+    const size_t nr_records = perf ? 10000 : 1000;
+    const size_t nr_updates = perf ? 100000 : 10000;
+
+    purc_variant_t set = purc_variant_make_set_by_ckey(0, "id", NULL);
+    ASSERT_NE(set, nullptr);
+
+    purc_variant_t *infos = new purc_variant_t[nr_records];
+    for (size_t i = 0; i < nr_records; i++) {
+        purc_variant_t rec = purc_variant_make_object(0,
+                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+        purc_variant_t id = purc_variant_make_longint(i);
+        purc_variant_t info = purc_variant_make_object(0,
+                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+        purc_variant_object_set_by_static_ckey(rec, "id", id);
+        purc_variant_object_set_by_static_ckey(rec, "info", info);
+        ASSERT_EQ(purc_variant_set_add(set, rec, PCVRNT_CR_METHOD_COMPLAIN),
+                1);
+        purc_variant_unref(info);
+        purc_variant_unref(id);
+        purc_variant_unref(rec);
+    }
+
+    // keep the members of the set, not the records added
+    for (size_t i = 0; i < nr_records; i++) {
+        purc_variant_t rec = purc_variant_set_get_by_index(set, i);
+        purc_variant_t id = purc_variant_object_get_by_ckey(rec, "id");
+        int64_t n;
+        ASSERT_TRUE(purc_variant_cast_to_longint(id, &n, false));
+        infos[n] = purc_variant_object_get_by_ckey(rec, "info");
+        ASSERT_NE(infos[n], nullptr);
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t i = 0; i < nr_updates; i++) {
+        purc_variant_t count = purc_variant_make_longint(i);
+        bool ok = purc_variant_object_set_by_static_ckey(
+                infos[(i * 7919) % nr_records], "count", count);
+        purc_variant_unref(count);
+        ASSERT_TRUE(ok);
+    }
+    if (perf)
+        std::cerr << "updating " << nr_updates << " fields of the members in "
+            << nr_records << " records: " << purc_get_elapsed_milliseconds(&ts,
+                    NULL) << " ms" << std::endl;
+
+    // changing a unique key still checks against the other members
+    purc_variant_t key = purc_variant_make_longint(1);
+    purc_variant_t rec;
+    rec = purc_variant_set_get_member_by_key_values(set, key);
+    ASSERT_NE(rec, nullptr);
+    purc_variant_unref(key);
+
+    key = purc_variant_make_longint(2);
+    EXPECT_FALSE(purc_variant_object_set_by_static_ckey(rec, "id", key));
+    purc_variant_unref(key);
+
+    key = purc_variant_make_longint(nr_records);
+    EXPECT_TRUE(purc_variant_object_set_by_static_ckey(rec, "id", key));
+    EXPECT_EQ(purc_variant_set_get_member_by_key_values(set, key), rec);
+    purc_variant_unref(key);
+
+    key = purc_variant_make_longint(1);
+    EXPECT_EQ(purc_variant_set_get_member_by_key_values(set, key),
+            nullptr);
+    purc_variant_unref(key);
+
+    EXPECT_EQ(purc_variant_set_get_size(set), (ssize_t)nr_records);
+
+    delete [] infos;
+    PURC_VARIANT_SAFE_CLEAR(set);
+}
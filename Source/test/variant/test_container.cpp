@@ -597,3 +597,479 @@ TEST(variant, clone)
     PURC_VARIANT_SAFE_CLEAR(set);
 }
 
+
+TEST(variant, container_remove_perf)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "purc_variant", false);
+
+    bool perf = test_perf_enabled();
+    const size_t nr_dst = perf ? 100000 : 10000;
+    const size_t nr_src = nr_dst / 2;
+
+    purc_variant_t dst = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    purc_variant_t src = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    purc_variant_t cmp = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(dst, nullptr);
+    ASSERT_NE(src, nullptr);
+    ASSERT_NE(cmp, nullptr);
+
+    // remove the even numbers, given in the reversed order
+    for (size_t i = 0; i < nr_dst; i++) {
+        purc_variant_t v = purc_variant_make_number(i);
+        purc_variant_array_append(dst, v);
+        if (i % 2)
+            purc_variant_array_append(cmp, v);
+        purc_variant_unref(v);
+    }
+
+    for (size_t i = 0; i < nr_src; i++) {
+        purc_variant_t v = purc_variant_make_longint((nr_src - i - 1) * 2);
+        purc_variant_array_append(src, v);
+        purc_variant_unref(v);
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ASSERT_TRUE(pcvariant_container_remove(dst, src, true));
+    if (perf)
+        std::cerr << "removing " << nr_src << " numbers from " << nr_dst
+            << " numbers: " << purc_get_elapsed_milliseconds(&ts, NULL)
+            << " ms" << std::endl;
+
+    ASSERT_EQ(pcvariant_diff(dst, cmp), 0);
+
+    PURC_VARIANT_SAFE_CLEAR(cmp);
+    PURC_VARIANT_SAFE_CLEAR(src);
+    PURC_VARIANT_SAFE_CLEAR(dst);
+}
+
+TEST(variant, container_clone_perf)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "purc_variant", false);
+
+    bool perf = test_perf_enabled();
+    const size_t nr_entries = perf ? 1000000 : 10000;
+    const size_t nr_clones = 10;
+
+    purc_variant_t obj = purc_variant_make_object_0();
+    ASSERT_NE(obj, nullptr);
+
+    for (size_t i = 0; i < nr_entries; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "key%zu", i);
+        purc_variant_t v = purc_variant_make_longint(i);
+        ASSERT_TRUE(purc_variant_object_set_by_static_ckey(obj, key, v));
+        purc_variant_unref(v);
+    }
+
+    // clone, then modify the object; every clone is a full copy
+    // made in linear time, and is not affected by the later changes
+    purc_variant_t clones[nr_clones];
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t i = 0; i < nr_clones; i++) {
+        clones[i] = purc_variant_container_clone(obj);
+        ASSERT_NE(clones[i], nullptr);
+
+        purc_variant_t v = purc_variant_make_longint(nr_entries + i);
+        ASSERT_TRUE(purc_variant_object_set_by_static_ckey(obj, "key0", v));
+        purc_variant_unref(v);
+    }
+    if (perf)
+        std::cerr << "cloning an object with " << nr_entries
+            << " entries " << nr_clones << " times: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    for (size_t i = 0; i < nr_clones; i++) {
+        size_t sz;
+        ASSERT_TRUE(purc_variant_object_size(clones[i], &sz));
+        ASSERT_EQ(sz, nr_entries);
+
+        int64_t n;
+        purc_variant_t v = purc_variant_object_get_by_ckey(clones[i],
+                "key0");
+        ASSERT_TRUE(purc_variant_cast_to_longint(v, &n, false));
+        ASSERT_EQ(n, (int64_t)(i == 0 ? 0 : nr_entries + i - 1));
+
+        v = purc_variant_object_get_by_ckey(clones[i], "key999");
+        ASSERT_TRUE(purc_variant_cast_to_longint(v, &n, false));
+        ASSERT_EQ(n, 999);
+
+        PURC_VARIANT_SAFE_CLEAR(clones[i]);
+    }
+
+    // a recursive clone does not share the containers
+    purc_variant_t arr = purc_variant_make_array_0();
+    ASSERT_TRUE(purc_variant_object_set_by_static_ckey(obj, "arr", arr));
+    purc_variant_t cloned = purc_variant_container_clone_recursively(obj);
+    ASSERT_NE(cloned, nullptr);
+    ASSERT_EQ(pcvariant_diff(obj, cloned), 0);
+
+    purc_variant_t v = purc_variant_make_longint(1);
+    ASSERT_TRUE(purc_variant_array_append(arr, v));
+    purc_variant_unref(v);
+
+    purc_variant_t arr2 = purc_variant_object_get_by_ckey(cloned, "arr");
+    ASSERT_NE(arr2, arr);
+    size_t sz;
+    ASSERT_TRUE(purc_variant_array_size(arr2, &sz));
+    ASSERT_EQ(sz, 0);
+    ASSERT_NE(pcvariant_diff(obj, cloned), 0);
+
+    PURC_VARIANT_SAFE_CLEAR(cloned);
+    PURC_VARIANT_SAFE_CLEAR(arr);
+    PURC_VARIANT_SAFE_CLEAR(obj);
+}
+
+struct batch_counter {
+    size_t          nr_calls;
+    purc_variant_t  records;
+};
+
+static bool
+count_changes(purc_variant_t source, pcvar_op_t op, void *ctxt,
+        size_t nr_args, purc_variant_t *argv)
+{
+    UNUSED_PARAM(source);
+    UNUSED_PARAM(op);
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+
+    struct batch_counter *counter = (struct batch_counter *)ctxt;
+    counter->nr_calls++;
+    return true;
+}
+
+static bool
+keep_batch_records(purc_variant_t source, pcvar_op_t op, void *ctxt,
+        size_t nr_args, purc_variant_t *argv)
+{
+    UNUSED_PARAM(source);
+    UNUSED_PARAM(op);
+
+    struct batch_counter *counter = (struct batch_counter *)ctxt;
+    counter->nr_calls++;
+    if (nr_args == 1) {
+        PURC_VARIANT_SAFE_CLEAR(counter->records);
+        counter->records = purc_variant_ref(argv[0]);
+    }
+    return true;
+}
+
+TEST(variant, container_batch_notifications)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "purc_variant", false);
+
+    bool perf = test_perf_enabled();
+    const size_t nr_items = perf ? 100000 : 10000;
+
+    purc_variant_t dst = purc_variant_make_array_0();
+    purc_variant_t src = purc_variant_make_array_0();
+    ASSERT_NE(dst, nullptr);
+    ASSERT_NE(src, nullptr);
+
+    for (size_t i = 0; i < nr_items; i++) {
+        purc_variant_t v = purc_variant_make_number(i);
+        purc_variant_array_append(src, v);
+        purc_variant_unref(v);
+    }
+
+    struct batch_counter batched = { 0, PURC_VARIANT_INVALID };
+    struct batch_counter plain = { 0, PURC_VARIANT_INVALID };
+    struct pcvar_listener *l1, *l2;
+    l1 = pcvariant_register_batch_listener(dst, PCVAR_OPERATION_GROW,
+            keep_batch_records, &batched);
+    ASSERT_NE(l1, nullptr);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ASSERT_TRUE(pcvariant_array_append_another(dst, src, true));
+    if (perf)
+        std::cerr << "appending " << nr_items << " items to an observed array: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    // one aggregated record: [[0, nr_items]]
+    ASSERT_EQ(batched.nr_calls, 1);
+    ASSERT_NE(batched.records, nullptr);
+    ASSERT_EQ(purc_variant_array_get_size(batched.records), 1);
+    purc_variant_t range = purc_variant_array_get(batched.records, 0);
+    uint64_t u;
+    ASSERT_TRUE(purc_variant_cast_to_ulongint(
+                purc_variant_array_get(range, 0), &u, false));
+    ASSERT_EQ(u, 0);
+    ASSERT_TRUE(purc_variant_cast_to_ulongint(
+                purc_variant_array_get(range, 1), &u, false));
+    ASSERT_EQ(u, nr_items);
+
+    // the plain listener is still notified one by one
+    l2 = purc_variant_register_post_listener(dst, PCVAR_OPERATION_GROW,
+            count_changes, &plain);
+    ASSERT_NE(l2, nullptr);
+
+    batched.nr_calls = 0;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ASSERT_TRUE(pcvariant_array_append_another(dst, src, true));
+    if (perf)
+        std::cerr << "appending " << nr_items << " items to an array observed "
+            "one by one: " << purc_get_elapsed_milliseconds(&ts, NULL) << " ms"
+            << std::endl;
+    ASSERT_EQ(batched.nr_calls, 1);
+    ASSERT_EQ(plain.nr_calls, nr_items);
+
+    // out of a batch, the batch listener gets every change
+    purc_variant_t v = purc_variant_make_number(0);
+    ASSERT_TRUE(purc_variant_array_append(dst, v));
+    purc_variant_unref(v);
+    ASSERT_EQ(batched.nr_calls, 2);
+    ASSERT_EQ(plain.nr_calls, nr_items + 1);
+
+    ASSERT_TRUE(purc_variant_revoke_listener(dst, l1));
+    ASSERT_TRUE(purc_variant_revoke_listener(dst, l2));
+
+    // the records of an object are the keys
+    purc_variant_t obj = purc_variant_make_object_0();
+    purc_variant_t another = purc_variant_make_object_0();
+    for (size_t i = 0; i < 10; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%zu", i);
+        v = purc_variant_make_number(i);
+        purc_variant_object_set_by_static_ckey(another, key, v);
+        purc_variant_unref(v);
+    }
+
+    batched.nr_calls = 0;
+    l1 = pcvariant_register_batch_listener(obj, PCVAR_OPERATION_GROW,
+            keep_batch_records, &batched);
+    ASSERT_NE(l1, nullptr);
+    ASSERT_TRUE(pcvariant_container_displace(obj, another, true));
+    ASSERT_EQ(batched.nr_calls, 1);
+    ASSERT_EQ(purc_variant_array_get_size(batched.records), 10);
+    ASSERT_TRUE(purc_variant_revoke_listener(obj, l1));
+
+    PURC_VARIANT_SAFE_CLEAR(batched.records);
+    PURC_VARIANT_SAFE_CLEAR(another);
+    PURC_VARIANT_SAFE_CLEAR(obj);
+    PURC_VARIANT_SAFE_CLEAR(src);
+    PURC_VARIANT_SAFE_CLEAR(dst);
+}
+
+static purc_variant_t
+make_numbered_object(size_t nr_members, size_t first, size_t step)
+{
+    purc_variant_t obj = purc_variant_make_object_0();
+    for (size_t i = 0; i < nr_members; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "key%08zu", first + i * step);
+        purc_variant_t v = purc_variant_make_longint(first + i * step);
+        purc_variant_object_set_by_static_ckey(obj, key, v);
+        purc_variant_unref(v);
+    }
+    return obj;
+}
+
+TEST(variant, object_unite_perf)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "purc_variant", false);
+
+    bool perf = test_perf_enabled();
+    const size_t nr_members = perf ? 100000 : 10000;
+
+    // the even keys and the odd keys interleave
+    purc_variant_t dst = make_numbered_object(nr_members, 0, 2);
+    purc_variant_t src = make_numbered_object(nr_members, 1, 2);
+    ASSERT_NE(dst, nullptr);
+    ASSERT_NE(src, nullptr);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ASSERT_EQ(purc_variant_object_unite(dst, src, PCVRNT_CR_METHOD_IGNORE),
+            (ssize_t)nr_members);
+    if (perf)
+        std::cerr << "uniting two objects with " << nr_members << " members: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    size_t sz;
+    ASSERT_TRUE(purc_variant_object_size(dst, &sz));
+    ASSERT_EQ(sz, nr_members * 2);
+
+    // the members are still in order
+    size_t i = 0;
+    purc_variant_t k, v;
+    foreach_key_value_in_variant_object(dst, k, v)
+        int64_t n;
+        ASSERT_TRUE(purc_variant_cast_to_longint(v, &n, false));
+        ASSERT_EQ(n, (int64_t)i);
+
+        char key[32];
+        snprintf(key, sizeof(key), "key%08zu", i);
+        ASSERT_STREQ(purc_variant_get_string_const(k), key);
+        i++;
+    end_foreach;
+    ASSERT_EQ(i, nr_members * 2);
+
+    // ignore or overwrite the existing members
+    purc_variant_t another = purc_variant_make_object_0();
+    v = purc_variant_make_longint(-1);
+    purc_variant_object_set_by_static_ckey(another, "key00000000", v);
+    purc_variant_object_set_by_static_ckey(another, "zzz", v);
+    purc_variant_unref(v);
+
+    ASSERT_EQ(purc_variant_object_unite(dst, another,
+                PCVRNT_CR_METHOD_IGNORE), 1);
+    int64_t n;
+    v = purc_variant_object_get_by_ckey(dst, "key00000000");
+    ASSERT_TRUE(purc_variant_cast_to_longint(v, &n, false));
+    ASSERT_EQ(n, 0);
+
+    ASSERT_EQ(purc_variant_object_unite(dst, another,
+                PCVRNT_CR_METHOD_OVERWRITE), 2);
+    v = purc_variant_object_get_by_ckey(dst, "key00000000");
+    ASSERT_TRUE(purc_variant_cast_to_longint(v, &n, false));
+    ASSERT_EQ(n, -1);
+    ASSERT_TRUE(purc_variant_object_size(dst, &sz));
+    ASSERT_EQ(sz, nr_members * 2 + 1);
+
+    // an observed object is still notified member by member
+    struct batch_counter plain = { 0, PURC_VARIANT_INVALID };
+    purc_variant_t observed = make_numbered_object(10, 0, 2);
+    purc_variant_t more = make_numbered_object(10, 1, 2);
+    struct pcvar_listener *l;
+    l = purc_variant_register_post_listener(observed, PCVAR_OPERATION_GROW,
+            count_changes, &plain);
+    ASSERT_NE(l, nullptr);
+    ASSERT_EQ(purc_variant_object_unite(observed, more,
+                PCVRNT_CR_METHOD_OVERWRITE), 10);
+    ASSERT_EQ(plain.nr_calls, 10);
+    ASSERT_TRUE(purc_variant_object_size(observed, &sz));
+    ASSERT_EQ(sz, 20);
+    ASSERT_TRUE(purc_variant_revoke_listener(observed, l));
+
+    PURC_VARIANT_SAFE_CLEAR(more);
+    PURC_VARIANT_SAFE_CLEAR(observed);
+    PURC_VARIANT_SAFE_CLEAR(another);
+    PURC_VARIANT_SAFE_CLEAR(src);
+    PURC_VARIANT_SAFE_CLEAR(dst);
+}
+
+// make a chain of nested arrays, every level has a few numbers
+static purc_variant_t
+make_deep_arrays(size_t depth)
+{
+    purc_variant_t inner = purc_variant_make_array_0();
+    for (size_t i = 0; i < depth; i++) {
+        purc_variant_t outer = purc_variant_make_array_0();
+        for (int j = 0; j < 4; j++) {
+            purc_variant_t v = purc_variant_make_number(j);
+            purc_variant_array_append(outer, v);
+            purc_variant_unref(v);
+        }
+        purc_variant_array_append(outer, inner);
+        purc_variant_unref(inner);
+        inner = outer;
+    }
+    return inner;
+}
+
+TEST(variant, release_deep_structure)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "purc_variant", false);
+
+    const struct purc_variant_stat *stat = purc_variant_usage_stat();
+    size_t nr_values = stat->nr_total_values;
+
+    // so deep that a recursive release would overflow the stack
+    bool perf = test_perf_enabled();
+    const size_t depth = perf ? 5000000 : 200000;
+    purc_variant_t deep = make_deep_arrays(depth);
+    ASSERT_NE(deep, nullptr);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_variant_unref(deep);
+    if (perf)
+        std::cerr << "releasing " << depth << " nested arrays: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    stat = purc_variant_usage_stat();
+    ASSERT_EQ(stat->nr_total_values, nr_values);
+
+    // defer the release and drain the stack within small budgets,
+    // as the scheduler does between the steps
+    deep = make_deep_arrays(depth);
+    ASSERT_NE(deep, nullptr);
+
+    struct pcvariant_dying dying = { };
+    ASSERT_EQ(pcvariant_defer_release(&dying), nullptr);
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_variant_unref(deep);
+    double step_ms = purc_get_elapsed_milliseconds(&ts, NULL);
+    ASSERT_EQ(pcvariant_defer_release(NULL), &dying);
+    ASSERT_EQ(dying.nr, 1U);
+
+    stat = purc_variant_usage_stat();
+    ASSERT_GT(stat->nr_total_values, nr_values);
+
+    size_t nr_rounds = 0;
+    double max_round_ms = 0;
+    size_t left;
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        left = pcvariant_release_deferred(&dying, 1);
+        double ms = purc_get_elapsed_milliseconds(&ts, NULL);
+        if (ms > max_round_ms)
+            max_round_ms = ms;
+        nr_rounds++;
+    } while (left > 0);
+    pcvariant_release_dying(&dying);
+
+    if (perf)
+        std::cerr << "dropping " << depth << " nested arrays: step "
+            << step_ms << " ms, released in " << nr_rounds
+            << " rounds, the longest one " << max_round_ms << " ms"
+            << std::endl;
+
+    stat = purc_variant_usage_stat();
+    ASSERT_EQ(stat->nr_total_values, nr_values);
+
+    // a flat array and a flat object are emptied piece by piece
+    const size_t nr_members = perf ? 5000000 : 200000;
+    purc_variant_t flat[2];
+    flat[0] = purc_variant_make_array_0();
+    flat[1] = purc_variant_make_object_0();
+    for (size_t i = 0; i < nr_members; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "%zu", i);
+        purc_variant_t v = purc_variant_make_number(i);
+        ASSERT_TRUE(purc_variant_array_append(flat[0], v));
+        ASSERT_TRUE(purc_variant_object_set_by_ckey(flat[1], key, v));
+        purc_variant_unref(v);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(pcvariant_defer_release(&dying), nullptr);
+        purc_variant_unref(flat[i]);
+        ASSERT_EQ(pcvariant_defer_release(NULL), &dying);
+        ASSERT_EQ(dying.nr, 1U);
+
+        nr_rounds = 0;
+        max_round_ms = 0;
+        do {
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            left = pcvariant_release_deferred(&dying, 1);
+            double ms = purc_get_elapsed_milliseconds(&ts, NULL);
+            if (ms > max_round_ms)
+                max_round_ms = ms;
+            nr_rounds++;
+        } while (left > 0);
+
+        if (perf)
+            std::cerr << "dropping a flat " << (i ? "object" : "array")
+                << " of " << nr_members << " members: released in "
+                << nr_rounds << " rounds, the longest one " << max_round_ms
+                << " ms" << std::endl;
+    }
+    pcvariant_release_dying(&dying);
+
+    stat = purc_variant_usage_stat();
+    ASSERT_EQ(stat->nr_total_values, nr_values);
+}
@@ -21,11 +21,13 @@
 
 #include "private/ejson.h"
 #include "private/utils.h"
+#include "private/variant.h"
 #include "purc/purc-rwstream.h"
 
 #include "../helpers.h"
 
 #include <stdio.h>
+#include <time.h>
 #include <gtest/gtest.h>
 
 using namespace std;
@@ -285,3 +287,167 @@ std::vector<ejson_test_data> read_ejson_test_data()
 INSTANTIATE_TEST_SUITE_P(ejson, variant_load_from_json,
         testing::ValuesIn(read_ejson_test_data()));
 
+
+static purc_variant_t
+call_lazy_method(purc_variant_t lazy, const char *name, bool setter,
+        purc_variant_t arg)
+{
+    struct purc_native_ops *ops = purc_variant_native_get_ops(lazy);
+    void *entity = purc_variant_native_get_entity(lazy);
+    purc_nvariant_method method = setter ?
+        ops->property_setter(entity, name) :
+        ops->property_getter(entity, name);
+    if (method == NULL)
+        return PURC_VARIANT_INVALID;
+    return method(entity, name, arg ? 1 : 0, arg ? &arg : NULL, 0);
+}
+
+TEST(variant, load_from_json_lazily)
+{
+    purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test", "variant",
+            NULL);
+
+    bool perf = test_perf_enabled();
+    const size_t nr_items = 100000;
+
+    std::string json = "{\"items\":{";
+    for (size_t i = 0; i < nr_items; i++) {
+        char buf[128];
+        snprintf(buf, sizeof(buf),
+                "%s\"item%zu\":{\"id\":%zu,\"name\":\"n\\u00e9%zu\","
+                "\"tags\":[1,2,3]}", i ? "," : "", i, i, i);
+        json += buf;
+    }
+    json += "},\"server\":{\"host\":\"localhost\",\"port\":8080}}";
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)json.c_str(),
+            json.length());
+    purc_variant_t eager = purc_variant_load_from_json_stream(rws);
+    purc_rwstream_destroy(rws);
+    if (perf)
+        std::cerr << "loading " << json.length() << " bytes of JSON: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+    ASSERT_NE(eager, PURC_VARIANT_INVALID);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    rws = purc_rwstream_new_from_mem((void*)json.c_str(), json.length());
+    purc_variant_t lazy = purc_variant_load_from_json_stream_ex(rws,
+            PCVRNT_LOAD_OPT_LAZY);
+    purc_rwstream_destroy(rws);
+    ASSERT_NE(lazy, PURC_VARIANT_INVALID);
+    ASSERT_TRUE(pcvariant_is_lazy_json(lazy));
+
+    purc_variant_t server = call_lazy_method(lazy, "server", false, NULL);
+    ASSERT_TRUE(pcvariant_is_lazy_json(server));
+    purc_variant_t port = call_lazy_method(server, "port", false, NULL);
+    purc_variant_t items = call_lazy_method(lazy, "items", false, NULL);
+    purc_variant_t item = call_lazy_method(items, "item99999", false, NULL);
+    purc_variant_t name = call_lazy_method(item, "name", false, NULL);
+    purc_variant_t tags = call_lazy_method(item, "tags", false, NULL);
+    if (perf)
+        std::cerr << "loading " << json.length() << " bytes of JSON lazily "
+            "and reading a few fields: "
+            << purc_get_elapsed_milliseconds(&ts, NULL) << " ms" << std::endl;
+
+    double d;
+    ASSERT_TRUE(purc_variant_cast_to_number(port, &d, false));
+    ASSERT_EQ(d, 8080);
+    ASSERT_STREQ(purc_variant_get_string_const(name), "n\xc3\xa9" "99999");
+    ASSERT_TRUE(purc_variant_is_array(tags));
+    ASSERT_EQ(purc_variant_array_get_size(tags), 3);
+    ASSERT_EQ(call_lazy_method(item, "none", false, NULL),
+            PURC_VARIANT_INVALID);
+
+    // a change is visible from the lazy parent
+    purc_variant_t v = purc_variant_make_number(8081);
+    purc_variant_t ret = call_lazy_method(server, "port", true, v);
+    ASSERT_NE(ret, PURC_VARIANT_INVALID);
+    purc_variant_unref(ret);
+    purc_variant_unref(v);
+
+    purc_variant_t again = call_lazy_method(lazy, "server", false, NULL);
+    ASSERT_TRUE(purc_variant_is_object(again));
+    v = purc_variant_object_get_by_ckey(again, "port");
+    ASSERT_TRUE(purc_variant_cast_to_number(v, &d, false));
+    ASSERT_EQ(d, 8081);
+
+    // the whole document is the same as the one loaded eagerly
+    purc_variant_t whole = call_lazy_method(lazy, NULL, false, NULL);
+    ASSERT_TRUE(purc_variant_is_object(whole));
+    v = purc_variant_make_number(8080);
+    ASSERT_TRUE(purc_variant_object_set_by_static_ckey(again, "port", v));
+    purc_variant_unref(v);
+    ASSERT_TRUE(purc_variant_is_equal_to(whole, eager));
+
+    purc_variant_unref(whole);
+    purc_variant_unref(again);
+    purc_variant_unref(tags);
+    purc_variant_unref(name);
+    purc_variant_unref(item);
+    purc_variant_unref(items);
+    purc_variant_unref(port);
+    purc_variant_unref(server);
+    purc_variant_unref(lazy);
+    purc_variant_unref(eager);
+
+    // eJSON falls back to the full parser
+    rws = purc_rwstream_new_from_mem((void*)"{key:1}", 7);
+    v = purc_variant_load_from_json_stream_ex(rws, PCVRNT_LOAD_OPT_LAZY);
+    purc_rwstream_destroy(rws);
+    ASSERT_TRUE(purc_variant_is_object(v));
+    purc_variant_unref(v);
+
+    purc_cleanup();
+}
+
+TEST(variant, load_from_json_lazily_keys)
+{
+    purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test", "variant",
+            NULL);
+
+    const char *json = "{\"b\":1,\"k\\u00e9y\":2,\"a\\\"b\":3,\"b\":4,"
+        "\"\":5,\"ab\":6,\"a\":7}";
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)json,
+            strlen(json));
+    purc_variant_t lazy = purc_variant_load_from_json_stream_ex(rws,
+            PCVRNT_LOAD_OPT_LAZY);
+    purc_rwstream_destroy(rws);
+    ASSERT_TRUE(pcvariant_is_lazy_json(lazy));
+
+    const struct {
+        const char *key;
+        double value;
+    } members[] = {
+        { "k\xc3\xa9y", 2 },
+        { "a\"b", 3 },
+        // the last one wins
+        { "b", 4 },
+        { "", 5 },
+        { "ab", 6 },
+        { "a", 7 },
+    };
+
+    // twice: the keys are sorted by the first access
+    for (int round = 0; round < 2; round++) {
+        for (size_t i = 0; i < PCA_TABLESIZE(members); i++) {
+            purc_variant_t v = call_lazy_method(lazy, members[i].key,
+                    false, NULL);
+            ASSERT_NE(v, PURC_VARIANT_INVALID);
+
+            double d;
+            ASSERT_TRUE(purc_variant_cast_to_number(v, &d, false));
+            ASSERT_EQ(d, members[i].value);
+            purc_variant_unref(v);
+        }
+
+        ASSERT_EQ(call_lazy_method(lazy, "k\\u00e9y", false, NULL),
+                PURC_VARIANT_INVALID);
+        ASSERT_EQ(call_lazy_method(lazy, "abc", false, NULL),
+                PURC_VARIANT_INVALID);
+    }
+
+    purc_variant_unref(lazy);
+    purc_cleanup();
+}
@@ -21,6 +21,8 @@
 
 #include "private/variant.h"
 
+#include "../helpers.h"
+
 #include <stdio.h>
 #include <errno.h>
 #include <gtest/gtest.h>
@@ -232,6 +234,82 @@ TEST(variant, serialize_number)
     ASSERT_STREQ(buf, "123.456");
     purc_variant_unref(my_variant);
 
+    /* case 2.1: a short form which reads back as the same double */
+    my_variant = purc_variant_make_number(-0.1);
+    ASSERT_NE(my_variant, PURC_VARIANT_INVALID);
+
+    purc_rwstream_seek(my_rws, 0, SEEK_SET);
+    len_expected = 0;
+    n = purc_variant_serialize(my_variant, my_rws,
+            0, PCVRNT_SERIALIZE_OPT_PLAIN, &len_expected);
+    ASSERT_GT(n, 0);
+
+    buf[n] = 0;
+    ASSERT_STREQ(buf, "-0.1");
+    purc_variant_unref(my_variant);
+
+    my_variant = purc_variant_make_number(1.5e-7);
+    ASSERT_NE(my_variant, PURC_VARIANT_INVALID);
+
+    purc_rwstream_seek(my_rws, 0, SEEK_SET);
+    len_expected = 0;
+    n = purc_variant_serialize(my_variant, my_rws,
+            0, PCVRNT_SERIALIZE_OPT_PLAIN, &len_expected);
+    ASSERT_GT(n, 0);
+
+    buf[n] = 0;
+    ASSERT_STREQ(buf, "1.5e-07");
+    purc_variant_unref(my_variant);
+
+    /* case 2.2: large integers keep all digits */
+    my_variant = purc_variant_make_number(1e20);
+    ASSERT_NE(my_variant, PURC_VARIANT_INVALID);
+
+    purc_rwstream_seek(my_rws, 0, SEEK_SET);
+    len_expected = 0;
+    n = purc_variant_serialize(my_variant, my_rws,
+            0, PCVRNT_SERIALIZE_OPT_PLAIN, &len_expected);
+    ASSERT_GT(n, 0);
+
+    buf[n] = 0;
+    ASSERT_STREQ(buf, "100000000000000000000");
+    purc_variant_unref(my_variant);
+
+    /* case 2.3: a number which "%.0f" recovers is written as an integer */
+    const struct {
+        double d;
+        const char *expected;
+    } near_integers[] = {
+        { 1.0000000000000002, "1" },
+        { -0.0, "-0" },
+        { 1e100, NULL },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(near_integers); i++) {
+        my_variant = purc_variant_make_number(near_integers[i].d);
+        ASSERT_NE(my_variant, PURC_VARIANT_INVALID);
+
+        char big[128];
+        purc_rwstream_t big_rws = purc_rwstream_new_from_mem(big,
+                sizeof(big) - 1);
+        len_expected = 0;
+        n = purc_variant_serialize(my_variant, big_rws,
+                0, PCVRNT_SERIALIZE_OPT_PLAIN, &len_expected);
+        ASSERT_GT(n, 0);
+        big[n] = 0;
+
+        if (near_integers[i].expected) {
+            ASSERT_STREQ(big, near_integers[i].expected);
+        }
+        else {
+            ASSERT_EQ(strpbrk(big, ".e"), nullptr);
+            ASSERT_EQ(strtod(big, NULL), near_integers[i].d);
+        }
+
+        purc_rwstream_destroy(big_rws);
+        purc_variant_unref(my_variant);
+    }
+
     /* case 3: customized double format */
     my_variant = purc_variant_make_number(1.1234567890);
     ASSERT_NE(my_variant, PURC_VARIANT_INVALID);
@@ -993,3 +1071,135 @@ TEST(variant, serialize_object_with_empty_key2)
 
     purc_cleanup ();
 }
+
+// to test: serialize a large tree, and count the length without writing
+TEST(variant, serialize_large_tree)
+{
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "variant", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const size_t nr_records = 100000;
+    purc_variant_t arr = purc_variant_make_array_0();
+    ASSERT_NE(arr, PURC_VARIANT_INVALID);
+
+    for (size_t i = 0; i < nr_records; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "name \"%zu\"\tof the record/%zu",
+                i, i * 3);
+
+        purc_variant_t id = purc_variant_make_longint(i);
+        purc_variant_t nm = purc_variant_make_string(name, false);
+        purc_variant_t score = purc_variant_make_number(i / 7.0);
+        purc_variant_t rec = purc_variant_make_object_by_static_ckey(3,
+                "id", id, "name", nm, "score", score);
+        ASSERT_NE(rec, PURC_VARIANT_INVALID);
+        ASSERT_TRUE(purc_variant_array_append(arr, rec));
+        purc_variant_unref(id);
+        purc_variant_unref(nm);
+        purc_variant_unref(score);
+        purc_variant_unref(rec);
+    }
+
+    bool perf = test_perf_enabled();
+    unsigned int flags = PCVRNT_SERIALIZE_OPT_PRETTY;
+    struct timespec ts;
+    purc_rwstream_t rws = purc_rwstream_new_buffer(1024, 64 * 1024 * 1024);
+    ASSERT_NE(rws, nullptr);
+
+    size_t len_expected = 0;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ssize_t n = purc_variant_serialize(arr, rws, 0, flags, &len_expected);
+    if (perf)
+        std::cerr << "serializing " << nr_records << " records (" << n
+            << " bytes): " << purc_get_elapsed_milliseconds(&ts, NULL) << " ms"
+            << std::endl;
+    ASSERT_GT(n, 0);
+    ASSERT_EQ(len_expected, (size_t)n);
+    size_t len = (size_t)n;
+
+    size_t sz_content = 0;
+    const char *buf = (const char *)purc_rwstream_get_mem_buffer(rws,
+            &sz_content);
+    ASSERT_EQ(sz_content, len);
+    ASSERT_EQ(buf[0], '[');
+    ASSERT_EQ(buf[len - 1], ']');
+
+    const char *first = "\"name\":\"name \\\"0\\\"\\tof the record\\/0\"";
+    ASSERT_NE(memmem(buf, len, first, strlen(first)), nullptr);
+
+    // the output is the same as the one serialized to a small memory buffer
+    char small[256];
+    purc_rwstream_t mem = purc_rwstream_new_from_mem(small, sizeof(small));
+    len_expected = 0;
+    n = purc_variant_serialize(arr, mem, 0,
+            flags | PCVRNT_SERIALIZE_OPT_IGNORE_ERRORS, &len_expected);
+    ASSERT_EQ(n, (ssize_t)sizeof(small));
+    ASSERT_EQ(len_expected, len);
+    ASSERT_EQ(memcmp(small, buf, sizeof(small)), 0);
+    purc_rwstream_destroy(mem);
+
+    purc_rwstream_destroy(rws);
+    purc_variant_unref(arr);
+    purc_cleanup ();
+}
+
+// to test: serialize values into a caller's buffer or an allocated one
+TEST(variant, serialize_alloc)
+{
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "variant", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const size_t nr_records = 100000;
+    purc_variant_t arr = purc_variant_make_array_0();
+    ASSERT_NE(arr, PURC_VARIANT_INVALID);
+
+    for (size_t i = 0; i < nr_records; i++) {
+        purc_variant_t id = purc_variant_make_longint(i);
+        purc_variant_t nm = purc_variant_make_string("name/of the record",
+                false);
+        purc_variant_t rec = purc_variant_make_object_by_static_ckey(2,
+                "id", id, "name", nm);
+        ASSERT_NE(rec, PURC_VARIANT_INVALID);
+        ASSERT_TRUE(purc_variant_array_append(arr, rec));
+        purc_variant_unref(id);
+        purc_variant_unref(nm);
+        purc_variant_unref(rec);
+    }
+
+    char buf[128];
+
+    // a small value fits in the caller's buffer
+    purc_variant_t rec = purc_variant_array_get(arr, 7);
+    char *p = pcvariant_serialize_alloc(buf, sizeof(buf), rec);
+    ASSERT_EQ(p, buf);
+    ASSERT_STREQ(p, "{\"id\":7,\"name\":\"name\\/of the record\"}");
+
+    // a large one is serialized into an allocated buffer
+    p = pcvariant_serialize_alloc(buf, sizeof(buf), arr);
+    ASSERT_NE(p, buf);
+    ASSERT_EQ(strncmp(p, "[{\"id\":0,", 10), 0);
+    ASSERT_EQ(p[strlen(p) - 1], ']');
+    free(p);
+
+    if (test_perf_enabled()) {
+        struct timespec ts;
+        double ms_alloc;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        for (size_t i = 0; i < nr_records; i++) {
+            p = pcvariant_serialize_alloc(buf, sizeof(buf),
+                    purc_variant_array_get(arr, i));
+            if (p != buf)
+                free(p);
+        }
+        ms_alloc = purc_get_elapsed_milliseconds(&ts, NULL);
+
+        std::cerr << "serializing " << nr_records << " small records: "
+            << ms_alloc << " ms" << std::endl;
+    }
+
+    purc_variant_unref(arr);
+    purc_cleanup ();
+}